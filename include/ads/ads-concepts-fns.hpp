@@ -1,12 +1,30 @@
 #pragma once
 
 #include "ads-vocab.hpp"
+#include <span>
+#include <type_traits>
+#include <utility>
 
 namespace ads::concepts {
 
 template <uint64_t Chs>
 concept is_mono_data = Chs == 1;
 
+// ads::data or a view.
+template <typename T>
+concept is_channel_data = requires(const std::remove_cvref_t<T>& data, channel_idx ch) {
+	{ data.get_channel_count() } -> std::same_as<channel_count>;
+	{ data.get_frame_count() } -> std::same_as<frame_count>;
+	{ data.data(ch) };
+};
+
+template <typename T>
+concept is_mutable_channel_data = is_channel_data<T> && requires(std::remove_cvref_t<T>& data, channel_idx ch) {
+	{ *data.data(ch) = *data.data(ch) };
+};
+
+template <typename T> using channel_value_t = std::remove_cvref_t<decltype(*std::declval<const std::remove_cvref_t<T>&>().data(channel_idx{}))>;
+
 template <typename ValueType, typename Fn>
 concept is_multi_channel_read_fn = requires(Fn fn, const ValueType* buffer, channel_idx channel, frame_idx frame_start, ads::frame_count frame_count) {
 	{ fn(buffer, channel, frame_start, frame_count) } -> std::same_as<ads::frame_count>;
@@ -37,10 +55,23 @@ concept is_single_channel_provider_fn = requires(Fn fn, frame_idx fr) {
 	{ fn(fr) } -> std::same_as<ValueType>;
 };
 
+template <typename ValueType, typename Fn>
+concept is_block_read_fn = requires(Fn fn, std::span<const ValueType* const> channels, frame_idx frame_start, ads::frame_count frame_count) {
+	{ fn(channels, frame_start, frame_count) } -> std::same_as<ads::frame_count>;
+};
+
+template <typename ValueType, typename Fn>
+concept is_block_write_fn = requires(Fn fn, std::span<ValueType* const> channels, frame_idx frame_start, ads::frame_count frame_count) {
+	{ fn(channels, frame_start, frame_count) } -> std::same_as<ads::frame_count>;
+};
+
 template <typename ValueType, typename Fn> concept is_read_fn  = is_single_channel_read_fn<ValueType, Fn> || is_multi_channel_read_fn<ValueType, Fn>;
 template <typename ValueType, typename Fn> concept is_write_fn = is_single_channel_write_fn<ValueType, Fn> || is_multi_channel_write_fn<ValueType, Fn>;
 
 template <typename ValueType, typename Fn>
 concept is_value_visitor_fn = std::invocable<Fn, channel_idx, frame_idx, ValueType>;
 
+template <typename ValueType, typename Fn>
+concept is_block_visitor_fn = std::invocable<Fn, channel_idx, frame_idx, std::span<const ValueType>>;
+
 } // namespace ads::concepts
@@ -0,0 +1,543 @@
+#pragma once
+
+#include "ads.hpp"
+#include "ads-simd.hpp"
+
+namespace ads {
+
+// A little-endian, packed 24-bit sample, as stored in audio files.
+struct int24_t { uint8_t bytes[3]; };
+static_assert (sizeof(int24_t) == 3);
+
+enum class sample_format { int16, int24, int32, float32, float64 };
+
+[[nodiscard]] constexpr
+auto get_sample_size(sample_format format) -> size_t {
+	switch (format) {
+		case sample_format::int16:   { return 2; }
+		case sample_format::int24:   { return 3; }
+		case sample_format::int32:   { return 4; }
+		case sample_format::float32: { return 4; }
+		case sample_format::float64: { return 8; }
+	}
+	return 0;
+}
+
+// Triangular probability density dither, for reducing the bit depth of
+// audio without correlated quantization distortion. Each call returns
+// an offset in (-1, 1), in units of the output's least significant bit.
+class tpdf_dither {
+public:
+	explicit tpdf_dither(uint32_t seed = 1) : state_{seed ? seed : 1} {}
+	[[nodiscard]] auto operator()() -> float {
+		const auto a = next();
+		const auto b = next();
+		return (static_cast<float>(a) - static_cast<float>(b)) * (1.0f / 4294967296.0f);
+	}
+private:
+	auto next() -> uint32_t {
+		// xorshift32
+		state_ ^= state_ << 13;
+		state_ ^= state_ >> 17;
+		state_ ^= state_ << 5;
+		return state_;
+	}
+	uint32_t state_;
+};
+
+namespace concepts {
+
+template <typename T> concept is_int_sample   = std::same_as<T, int16_t> || std::same_as<T, int24_t> || std::same_as<T, int32_t>;
+template <typename T> concept is_float_sample = std::same_as<T, float> || std::same_as<T, double>;
+template <typename T> concept is_sample       = is_int_sample<T> || is_float_sample<T>;
+
+} // namespace concepts
+
+namespace detail::convert {
+
+template <typename T> struct sample_bits;
+template <> struct sample_bits<int16_t> { static constexpr int value = 16; };
+template <> struct sample_bits<int24_t> { static constexpr int value = 24; };
+template <> struct sample_bits<int32_t> { static constexpr int value = 32; };
+template <typename T> static constexpr auto sample_bits_v = sample_bits<T>::value;
+
+// Full scale of an integer sample type, as a floating point value.
+template <concepts::is_int_sample Int, concepts::is_float_sample Float>
+static constexpr auto full_scale_v = static_cast<Float>(uint64_t{1} << (sample_bits_v<Int> - 1));
+
+// The largest value of Float which doesn't overflow Int once rounded.
+template <concepts::is_int_sample Int, concepts::is_float_sample Float>
+static constexpr auto max_scaled_v = (std::same_as<Float, float> && sample_bits_v<Int> > 24) ? static_cast<Float>(2147483520.0f) : full_scale_v<Int, Float> - Float{1};
+
+[[nodiscard]] inline
+auto load_int(int16_t x) -> int32_t { return x; }
+
+[[nodiscard]] inline
+auto load_int(int32_t x) -> int32_t { return x; }
+
+[[nodiscard]] inline
+auto load_int(int24_t x) -> int32_t {
+	const auto bits = uint32_t{x.bytes[0]} | (uint32_t{x.bytes[1]} << 8) | (uint32_t{x.bytes[2]} << 16);
+	return static_cast<int32_t>(bits << 8) >> 8;
+}
+
+template <concepts::is_int_sample Int> [[nodiscard]]
+auto store_int(int32_t x) -> Int {
+	if constexpr (std::same_as<Int, int24_t>) {
+		return {static_cast<uint8_t>(x), static_cast<uint8_t>(x >> 8), static_cast<uint8_t>(x >> 16)};
+	}
+	else {
+		return static_cast<Int>(x);
+	}
+}
+
+template <concepts::is_sample In, concepts::is_sample Out> [[nodiscard]]
+auto convert_sample(In x) -> Out {
+	if constexpr (concepts::is_float_sample<In> && concepts::is_float_sample<Out>) {
+		return static_cast<Out>(x);
+	}
+	else if constexpr (concepts::is_int_sample<In> && concepts::is_float_sample<Out>) {
+		return static_cast<Out>(load_int(x)) * (Out{1} / full_scale_v<In, Out>);
+	}
+	else if constexpr (concepts::is_float_sample<In> && concepts::is_int_sample<Out>) {
+		const auto scaled = std::clamp(x * full_scale_v<Out, In>, -full_scale_v<Out, In>, max_scaled_v<Out, In>);
+		return store_int<Out>(static_cast<int32_t>(std::nearbyint(scaled)));
+	}
+	else {
+		constexpr auto shift = sample_bits_v<In> - sample_bits_v<Out>;
+		const auto v = load_int(x);
+		if constexpr (shift >= 0) { return store_int<Out>(v >> shift); }
+		else                      { return store_int<Out>(static_cast<int32_t>(static_cast<uint32_t>(v) << -shift)); }
+	}
+}
+
+// SIMD kernels. Like the interleave kernels, each processes as many
+// whole vectors as it can and returns the number of samples done.
+
+#if defined(ADS_SSE2)
+inline auto s16_to_f32_sse(const int16_t* in, float* out, uint64_t n) -> uint64_t {
+	const auto scale = _mm_set1_ps(1.0f / 32768.0f);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const auto x  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		const auto lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+		const auto hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+		_mm_storeu_ps(out + i,     _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+		_mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+	}
+	return i;
+}
+
+inline auto f32_to_s16_sse(const float* in, int16_t* out, uint64_t n) -> uint64_t {
+	const auto scale = _mm_set1_ps(32768.0f);
+	const auto lo    = _mm_set1_ps(-32768.0f);
+	const auto hi    = _mm_set1_ps(32767.0f);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const auto a = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), lo), hi));
+		const auto b = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i + 4), scale), lo), hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(a, b));
+	}
+	return i;
+}
+
+inline auto s32_to_f32_sse(const int32_t* in, float* out, uint64_t n) -> uint64_t {
+	const auto scale = _mm_set1_ps(1.0f / 2147483648.0f);
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const auto x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+		_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(x), scale));
+	}
+	return i;
+}
+
+inline auto f32_to_s32_sse(const float* in, int32_t* out, uint64_t n) -> uint64_t {
+	const auto scale = _mm_set1_ps(2147483648.0f);
+	const auto lo    = _mm_set1_ps(-2147483648.0f);
+	const auto hi    = _mm_set1_ps(2147483520.0f);
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const auto x = _mm_cvtps_epi32(_mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_loadu_ps(in + i), scale), lo), hi));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), x);
+	}
+	return i;
+}
+
+inline auto f32_to_f64_sse(const float* in, double* out, uint64_t n) -> uint64_t {
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const auto x = _mm_loadu_ps(in + i);
+		_mm_storeu_pd(out + i,     _mm_cvtps_pd(x));
+		_mm_storeu_pd(out + i + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+	}
+	return i;
+}
+
+inline auto f64_to_f32_sse(const double* in, float* out, uint64_t n) -> uint64_t {
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const auto a = _mm_cvtpd_ps(_mm_loadu_pd(in + i));
+		const auto b = _mm_cvtpd_ps(_mm_loadu_pd(in + i + 2));
+		_mm_storeu_ps(out + i, _mm_movelh_ps(a, b));
+	}
+	return i;
+}
+#endif // ADS_SSE2
+
+#if defined(ADS_AVX2_DISPATCH)
+ADS_TARGET_AVX2 inline auto s16_to_f32_avx2(const int16_t* in, float* out, uint64_t n) -> uint64_t {
+	const auto scale = _mm256_set1_ps(1.0f / 32768.0f);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const auto x = _mm256_cvtepi16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i)));
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto f32_to_s16_avx2(const float* in, int16_t* out, uint64_t n) -> uint64_t {
+	const auto scale = _mm256_set1_ps(32768.0f);
+	const auto lo    = _mm256_set1_ps(-32768.0f);
+	const auto hi    = _mm256_set1_ps(32767.0f);
+	uint64_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		const auto a = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), lo), hi));
+		const auto b = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i + 8), scale), lo), hi));
+		// packs works within 128-bit lanes, so put the quarters back in order
+		const auto packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(a, b), 0xD8);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto s32_to_f32_avx2(const int32_t* in, float* out, uint64_t n) -> uint64_t {
+	const auto scale = _mm256_set1_ps(1.0f / 2147483648.0f);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const auto x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto f32_to_s32_avx2(const float* in, int32_t* out, uint64_t n) -> uint64_t {
+	const auto scale = _mm256_set1_ps(2147483648.0f);
+	const auto lo    = _mm256_set1_ps(-2147483648.0f);
+	const auto hi    = _mm256_set1_ps(2147483520.0f);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const auto x = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), lo), hi));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), x);
+	}
+	return i;
+}
+
+// 24-bit samples are expanded with a byte shuffle into the top three
+// bytes of each 32-bit lane, then shifted down to sign extend. Each
+// iteration reads 4 bytes past the 8 samples it converts.
+ADS_TARGET_AVX2 inline auto s24_to_f32_avx2(const int24_t* in, float* out, uint64_t n) -> uint64_t {
+	const auto scale   = _mm256_set1_ps(1.0f / 8388608.0f);
+	const auto shuffle = _mm256_setr_epi8(
+		-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11,
+		-1, 0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11);
+	const auto bytes = reinterpret_cast<const uint8_t*>(in);
+	uint64_t i = 0;
+	for (; i + 10 <= n; i += 8) {
+		const auto lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i * 3));
+		const auto hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(bytes + i * 3 + 12));
+		const auto x  = _mm256_srai_epi32(_mm256_shuffle_epi8(_mm256_inserti128_si256(_mm256_castsi128_si256(lo), hi, 1), shuffle), 8);
+		_mm256_storeu_ps(out + i, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+	}
+	return i;
+}
+
+// The reverse. Each 16-byte store writes 4 bytes of garbage past its
+// samples, which are overwritten by the next store or by the caller.
+ADS_TARGET_AVX2 inline auto f32_to_s24_avx2(const float* in, int24_t* out, uint64_t n) -> uint64_t {
+	const auto scale   = _mm256_set1_ps(8388608.0f);
+	const auto lo      = _mm256_set1_ps(-8388608.0f);
+	const auto hi      = _mm256_set1_ps(8388607.0f);
+	const auto shuffle = _mm256_setr_epi8(
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1,
+		0, 1, 2, 4, 5, 6, 8, 9, 10, 12, 13, 14, -1, -1, -1, -1);
+	const auto bytes = reinterpret_cast<uint8_t*>(out);
+	uint64_t i = 0;
+	for (; i + 10 <= n; i += 8) {
+		const auto x = _mm256_cvtps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(_mm256_loadu_ps(in + i), scale), lo), hi));
+		const auto packed = _mm256_shuffle_epi8(x, shuffle);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i * 3),      _mm256_castsi256_si128(packed));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(bytes + i * 3 + 12), _mm256_extracti128_si256(packed, 1));
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto f32_to_f64_avx2(const float* in, double* out, uint64_t n) -> uint64_t {
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm256_storeu_pd(out + i, _mm256_cvtps_pd(_mm_loadu_ps(in + i)));
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto f64_to_f32_avx2(const double* in, float* out, uint64_t n) -> uint64_t {
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(out + i, _mm256_cvtpd_ps(_mm256_loadu_pd(in + i)));
+	}
+	return i;
+}
+#endif // ADS_AVX2_DISPATCH
+
+#if defined(ADS_AVX2_DISPATCH)
+#	define ADS_CONVERT_DISPATCH(in_t, out_t, kernel) \
+		if constexpr (std::same_as<In, in_t> && std::same_as<Out, out_t>) { \
+			return simd::has_avx2() ? kernel##_avx2(in, out, n) : kernel##_sse(in, out, n); \
+		}
+#	define ADS_CONVERT_DISPATCH_AVX2(in_t, out_t, kernel) \
+		if constexpr (std::same_as<In, in_t> && std::same_as<Out, out_t>) { \
+			return simd::has_avx2() ? kernel##_avx2(in, out, n) : 0; \
+		}
+#elif defined(ADS_SSE2)
+#	define ADS_CONVERT_DISPATCH(in_t, out_t, kernel) \
+		if constexpr (std::same_as<In, in_t> && std::same_as<Out, out_t>) { return kernel##_sse(in, out, n); }
+#	define ADS_CONVERT_DISPATCH_AVX2(in_t, out_t, kernel)
+#else
+#	define ADS_CONVERT_DISPATCH(in_t, out_t, kernel)
+#	define ADS_CONVERT_DISPATCH_AVX2(in_t, out_t, kernel)
+#endif
+
+// Runs the SIMD kernel for this pair of formats, if there is one.
+template <concepts::is_sample In, concepts::is_sample Out>
+auto convert_simd([[maybe_unused]] const In* in, [[maybe_unused]] Out* out, [[maybe_unused]] uint64_t n) -> uint64_t {
+	ADS_CONVERT_DISPATCH(int16_t, float, s16_to_f32)
+	ADS_CONVERT_DISPATCH(float, int16_t, f32_to_s16)
+	ADS_CONVERT_DISPATCH(int32_t, float, s32_to_f32)
+	ADS_CONVERT_DISPATCH(float, int32_t, f32_to_s32)
+	ADS_CONVERT_DISPATCH(float, double, f32_to_f64)
+	ADS_CONVERT_DISPATCH(double, float, f64_to_f32)
+	ADS_CONVERT_DISPATCH_AVX2(int24_t, float, s24_to_f32)
+	ADS_CONVERT_DISPATCH_AVX2(float, int24_t, f32_to_s24)
+	return 0;
+}
+
+#undef ADS_CONVERT_DISPATCH
+#undef ADS_CONVERT_DISPATCH_AVX2
+
+template <concepts::is_sample In, concepts::is_sample Out>
+auto convert_n(const In* in, Out* out, uint64_t n) -> void {
+	if constexpr (std::same_as<In, Out>) {
+		if (n > 0) {
+			std::memcpy(out, in, n * sizeof(In));
+		}
+	}
+	else {
+		for (auto i = convert_simd(in, out, n); i < n; i++) {
+			out[i] = convert_sample<In, Out>(in[i]);
+		}
+	}
+}
+
+// Dither is added in the floating point domain, a block at a time, and
+// the result goes through the undithered kernels.
+template <concepts::is_sample In, concepts::is_int_sample Out>
+auto convert_n(const In* in, Out* out, uint64_t n, tpdf_dither& dither) -> void {
+	using float_type = std::conditional_t<std::same_as<In, float>, float, double>;
+	static constexpr auto BLOCK_SIZE = uint64_t{256};
+	static constexpr auto lsb = float_type{1} / full_scale_v<Out, float_type>;
+	float_type block[BLOCK_SIZE];
+	for (uint64_t start = 0; start < n; start += BLOCK_SIZE) {
+		const auto count = std::min(BLOCK_SIZE, n - start);
+		convert_n(in + start, block, count);
+		for (uint64_t i = 0; i < count; i++) {
+			block[i] += static_cast<float_type>(dither()) * lsb;
+		}
+		convert_n(block, out + start, count);
+	}
+}
+
+// Calls fn with a null pointer of the sample type for the format.
+template <typename Fn>
+auto visit_format(sample_format format, Fn&& fn) -> void {
+	switch (format) {
+		case sample_format::int16:   { fn(static_cast<int16_t*>(nullptr)); return; }
+		case sample_format::int24:   { fn(static_cast<int24_t*>(nullptr)); return; }
+		case sample_format::int32:   { fn(static_cast<int32_t*>(nullptr)); return; }
+		case sample_format::float32: { fn(static_cast<float*>(nullptr)); return; }
+		case sample_format::float64: { fn(static_cast<double*>(nullptr)); return; }
+	}
+	throw std::invalid_argument{std::format("ads: Invalid sample format ({})", static_cast<int>(format))};
+}
+
+// Converts and deinterleaves a block of frames at a time through a
+// small buffer, so the input is only read from memory once. Writes to
+// the frames [start, start + frame_count) of output.
+template <concepts::is_sample In, typename Dest>
+auto deinterleave_n(const In* input, uint64_t channel_count, uint64_t start, uint64_t frame_count, Dest& output) -> void {
+	using value_type = concepts::channel_value_t<Dest>;
+	static constexpr uint64_t BLOCK_SAMPLES = 2048;
+	static constexpr uint64_t MAX_CHANNELS  = 8;
+	if (channel_count == 0) {
+		return;
+	}
+	if (channel_count > MAX_CHANNELS) {
+		// The SIMD deinterleave kernels don't go this wide, so convert
+		// each sample straight into place instead.
+		constexpr uint64_t BLOCK_SIZE = 64;
+		for (uint64_t block = 0; block < frame_count; block += BLOCK_SIZE) {
+			const auto block_end = std::min(block + BLOCK_SIZE, frame_count);
+			for (uint64_t c = 0; c < channel_count; c++) {
+				const auto dest = output.data(channel_idx{c}) + start;
+				for (auto f = block; f < block_end; f++) {
+					dest[f] = convert_sample<In, value_type>(input[f * channel_count + c]);
+				}
+			}
+		}
+		return;
+	}
+	value_type buffer[BLOCK_SAMPLES];
+	std::array<value_type*, MAX_CHANNELS> channels;
+	const auto block_frames = BLOCK_SAMPLES / channel_count;
+	for (uint64_t block = 0; block < frame_count; block += block_frames) {
+		const auto n = std::min(block_frames, frame_count - block);
+		convert_n(input + block * channel_count, buffer, n * channel_count);
+		for (uint64_t c = 0; c < channel_count; c++) {
+			channels[c] = output.data(channel_idx{c}) + start + block;
+		}
+		detail::deinterleave<DYNAMIC_EXTENT>(static_cast<const value_type*>(buffer), channel_count, n, channels.data());
+	}
+}
+
+// The reverse of deinterleave_n(), for the frames [start, start +
+// frame_count) of input, with optional dither.
+template <typename Src, concepts::is_sample Out>
+auto interleave_n(const Src& input, uint64_t start, uint64_t frame_count, Out* output, tpdf_dither* dither) -> void {
+	using value_type = concepts::channel_value_t<Src>;
+	static constexpr uint64_t BLOCK_SAMPLES = 2048;
+	static constexpr uint64_t MAX_CHANNELS  = 8;
+	const auto channel_count = input.get_channel_count().value;
+	if (channel_count == 0) {
+		return;
+	}
+	if (channel_count > BLOCK_SAMPLES) {
+		throw std::invalid_argument{std::format("ads::interleave(): Channel count {} is too high", channel_count)};
+	}
+	value_type buffer[BLOCK_SAMPLES];
+	std::array<const value_type*, MAX_CHANNELS> channels;
+	const auto block_frames = BLOCK_SAMPLES / channel_count;
+	for (uint64_t block = 0; block < frame_count; block += block_frames) {
+		const auto n = std::min(block_frames, frame_count - block);
+		if (channel_count <= MAX_CHANNELS) {
+			for (uint64_t c = 0; c < channel_count; c++) {
+				channels[c] = input.data(channel_idx{c}) + start + block;
+			}
+			detail::interleave<DYNAMIC_EXTENT>(channels.data(), channel_count, n, static_cast<value_type*>(buffer));
+		}
+		else {
+			for (uint64_t c = 0; c < channel_count; c++) {
+				const auto src = input.data(channel_idx{c}) + start + block;
+				for (uint64_t f = 0; f < n; f++) {
+					buffer[f * channel_count + c] = src[f];
+				}
+			}
+		}
+		const auto out = output + block * channel_count;
+		if constexpr (concepts::is_int_sample<Out>) {
+			if (dither) {
+				convert_n(static_cast<const value_type*>(buffer), out, n * channel_count, *dither);
+				continue;
+			}
+		}
+		convert_n(static_cast<const value_type*>(buffer), out, n * channel_count);
+	}
+}
+
+} // namespace detail::convert
+
+// Converts n samples. Integer samples are scaled so that full scale is
+// [-1, 1), and floating point samples are clamped to the integer range.
+// Works the same for planar or interleaved samples.
+template <concepts::is_sample In, concepts::is_sample Out>
+auto convert(const In* in, Out* out, uint64_t n) -> void {
+	detail::convert::convert_n(in, out, n);
+}
+
+// Converts n samples with TPDF dither.
+template <concepts::is_sample In, concepts::is_int_sample Out>
+auto convert(const In* in, Out* out, uint64_t n, tpdf_dither& dither) -> void {
+	detail::convert::convert_n(in, out, n, dither);
+}
+
+// Converts n samples between formats chosen at runtime.
+inline
+auto convert(const std::byte* in, sample_format in_format, std::byte* out, sample_format out_format, uint64_t n) -> void {
+	detail::convert::visit_format(in_format, [=]<typename In>(In*) {
+		detail::convert::visit_format(out_format, [=]<typename Out>(Out*) {
+			detail::convert::convert_n(reinterpret_cast<const In*>(in), reinterpret_cast<Out*>(out), n);
+		});
+	});
+}
+
+// The same, with dither if the output format is an integer format.
+inline
+auto convert(const std::byte* in, sample_format in_format, std::byte* out, sample_format out_format, uint64_t n, tpdf_dither& dither) -> void {
+	detail::convert::visit_format(in_format, [=, &dither]<typename In>(In*) {
+		detail::convert::visit_format(out_format, [=, &dither]<typename Out>(Out*) {
+			if constexpr (concepts::is_int_sample<Out>) {
+				detail::convert::convert_n(reinterpret_cast<const In*>(in), reinterpret_cast<Out*>(out), n, dither);
+			}
+			else {
+				detail::convert::convert_n(reinterpret_cast<const In*>(in), reinterpret_cast<Out*>(out), n);
+			}
+		});
+	});
+}
+
+// Converts each channel of src into dest, e.g. from ads::data<int16_t>
+// to ads::data<float>, over as many frames as both have. Returns the
+// number of frames converted.
+template <typename Src, typename Dest>
+	requires concepts::is_channel_data<Src> && concepts::is_mutable_channel_data<Dest> &&
+	         concepts::is_sample<concepts::channel_value_t<Src>> && concepts::is_sample<concepts::channel_value_t<Dest>>
+auto convert(const Src& src, Dest&& dest) -> frame_count {
+	if (src.get_channel_count() != dest.get_channel_count()) {
+		throw std::invalid_argument{std::format("ads::convert(): Channel count mismatch ({} != {})", src.get_channel_count().value, dest.get_channel_count().value)};
+	}
+	const auto frame_count = std::min(src.get_frame_count(), dest.get_frame_count());
+	for (ads::channel_idx ch = {0}; ch < dest.get_channel_count(); ch++) {
+		detail::convert::convert_n(src.data(ch), dest.data(ch), frame_count.value);
+	}
+	return frame_count;
+}
+
+template <typename Src, typename Dest>
+	requires concepts::is_channel_data<Src> && concepts::is_mutable_channel_data<Dest> &&
+	         concepts::is_sample<concepts::channel_value_t<Src>> && concepts::is_int_sample<concepts::channel_value_t<Dest>>
+auto convert(const Src& src, Dest&& dest, tpdf_dither& dither) -> frame_count {
+	if (src.get_channel_count() != dest.get_channel_count()) {
+		throw std::invalid_argument{std::format("ads::convert(): Channel count mismatch ({} != {})", src.get_channel_count().value, dest.get_channel_count().value)};
+	}
+	const auto frame_count = std::min(src.get_frame_count(), dest.get_frame_count());
+	for (ads::channel_idx ch = {0}; ch < dest.get_channel_count(); ch++) {
+		detail::convert::convert_n(src.data(ch), dest.data(ch), frame_count.value, dither);
+	}
+	return frame_count;
+}
+
+// Deinterleaves frames of the given sample format straight into output,
+// converting as it goes, e.g. from a 24-bit file into
+// ads::dynamic_stereo<float>. Processes as many frames as both have and
+// returns that count. Doesn't allocate.
+template <typename Dest>
+	requires concepts::is_mutable_channel_data<Dest> && concepts::is_sample<concepts::channel_value_t<Dest>>
+auto deinterleave(const std::byte* input, sample_format format, ads::channel_count channel_count, ads::frame_count frame_count, Dest&& output) -> ads::frame_count {
+	if (channel_count != output.get_channel_count()) {
+		throw std::invalid_argument{std::format("ads::deinterleave(): Channel count mismatch ({} != {})", channel_count.value, output.get_channel_count().value)};
+	}
+	const auto n = std::min(frame_count, output.get_frame_count());
+	detail::convert::visit_format(format, [&]<typename In>(In*) {
+		detail::convert::deinterleave_n(reinterpret_cast<const In*>(input), channel_count.value, 0, n.value, output);
+	});
+	return n;
+}
+
+} // namespace ads
@@ -0,0 +1,401 @@
+#pragma once
+
+#include "ads.hpp"
+#include "ads-simd.hpp"
+#include <numbers>
+
+namespace ads {
+
+// Interpolation methods for read_interpolated(). Each one reads the
+// frames from `before` frames before the integer part of the position
+// to `after` frames after it.
+namespace interpolation {
+
+// A straight line between the two nearest frames.
+struct linear {
+	static constexpr uint64_t before = 0;
+	static constexpr uint64_t after  = 1;
+};
+
+// A Catmull-Rom cubic Hermite spline through the four nearest frames.
+struct cubic {
+	static constexpr uint64_t before = 1;
+	static constexpr uint64_t after  = 2;
+};
+
+// A Blackman-windowed sinc over the Points nearest frames.
+template <uint64_t Points = 16>
+struct sinc {
+	static_assert (Points >= 4 && Points % 4 == 0, "Points must be a multiple of 4");
+	static constexpr uint64_t points = Points;
+	static constexpr uint64_t before = Points / 2 - 1;
+	static constexpr uint64_t after  = Points / 2;
+};
+
+} // namespace interpolation
+
+namespace detail::interp {
+
+// Positions are handled in blocks of this many, so that the bounds are
+// checked once per block rather than once per frame. Only blocks which
+// reach past either end of the channel take the checked scalar path.
+static constexpr uint64_t BLOCK_SIZE  = 64;
+static constexpr uint64_t SINC_PHASES = 512;
+
+// Sinc filter coefficients for SINC_PHASES + 1 evenly spaced fractional
+// positions from 0 to 1 inclusive, so that the coefficients for any
+// position can be interpolated between two rows. Each row sums to one.
+template <typename T, uint64_t Points>
+struct sinc_table {
+	alignas(32) std::array<std::array<T, Points>, SINC_PHASES + 1> rows;
+	sinc_table() {
+		constexpr auto half = static_cast<double>(Points / 2);
+		for (uint64_t p = 0; p <= SINC_PHASES; p++) {
+			const auto t = static_cast<double>(p) / SINC_PHASES;
+			std::array<double, Points> row;
+			auto sum = 0.0;
+			for (uint64_t j = 0; j < Points; j++) {
+				const auto d      = static_cast<double>(j) - (half - 1.0) - t;
+				const auto x      = std::numbers::pi * d;
+				const auto w      = std::numbers::pi * d / half;
+				const auto sinc   = d == 0.0 ? 1.0 : std::sin(x) / x;
+				const auto window = 0.42 + 0.5 * std::cos(w) + 0.08 * std::cos(2.0 * w);
+				row[j] = sinc * window;
+				sum   += row[j];
+			}
+			for (uint64_t j = 0; j < Points; j++) {
+				rows[p][j] = static_cast<T>(row[j] / sum);
+			}
+		}
+	}
+};
+
+template <typename T, uint64_t Points> [[nodiscard]]
+auto get_sinc_table() -> const sinc_table<T, Points>& {
+	static const sinc_table<T, Points> table;
+	return table;
+}
+
+// Scalar implementations. x(i) returns frame i, so the same code serves
+// for the unchecked path and for the checked path near the edges.
+
+template <typename T, typename Fetch> [[nodiscard]]
+auto interpolate(interpolation::linear, Fetch x, int64_t i, T t) -> T {
+	const auto a = x(i);
+	return a + t * (x(i + 1) - a);
+}
+
+template <typename T, typename Fetch> [[nodiscard]]
+auto interpolate(interpolation::cubic, Fetch x, int64_t i, T t) -> T {
+	const auto xm1 = x(i - 1);
+	const auto x0  = x(i);
+	const auto x1  = x(i + 1);
+	const auto x2  = x(i + 2);
+	const auto c1  = T(0.5) * (x1 - xm1);
+	const auto c2  = xm1 - T(2.5) * x0 + T(2) * x1 - T(0.5) * x2;
+	const auto c3  = T(0.5) * (x2 - xm1) + T(1.5) * (x0 - x1);
+	return ((c3 * t + c2) * t + c1) * t + x0;
+}
+
+template <typename T, uint64_t Points, typename Fetch> [[nodiscard]]
+auto interpolate(interpolation::sinc<Points>, Fetch x, int64_t i, T t) -> T {
+	const auto& table = get_sinc_table<T, Points>();
+	const auto phase  = t * T(SINC_PHASES);
+	const auto ph     = std::min(static_cast<uint64_t>(phase), SINC_PHASES - 1);
+	const auto f      = phase - static_cast<T>(ph);
+	const auto& r0    = table.rows[ph];
+	const auto& r1    = table.rows[ph + 1];
+	const auto first  = i - static_cast<int64_t>(Points / 2 - 1);
+	auto sum = T(0);
+	for (uint64_t j = 0; j < Points; j++) {
+		sum += x(first + static_cast<int64_t>(j)) * (r0[j] + f * (r1[j] - r0[j]));
+	}
+	return sum;
+}
+
+// Frames outside the channel read as zero.
+template <typename Interpolation, typename T>
+auto read_checked(const T* x, int64_t frame_count, const double* pos, uint64_t n, T* out) -> void {
+	const auto fetch = [x, frame_count](int64_t i) { return i >= 0 && i < frame_count ? x[i] : T(0); };
+	for (uint64_t k = 0; k < n; k++) {
+		const auto i = std::floor(pos[k]);
+		out[k] = interpolate(Interpolation{}, fetch, static_cast<int64_t>(i), static_cast<T>(pos[k] - i));
+	}
+}
+
+// Every frame which is read is inside the channel, and the positions are
+// relative to x and not negative.
+template <typename Interpolation, typename T>
+auto read_unchecked(const T* x, const double* rel, uint64_t n, T* out) -> void {
+	const auto fetch = [x](int64_t i) { return x[i]; };
+	for (uint64_t k = 0; k < n; k++) {
+		const auto i = static_cast<int64_t>(rel[k]);
+		out[k] = interpolate(Interpolation{}, fetch, i, static_cast<T>(rel[k] - static_cast<double>(i)));
+	}
+}
+
+// The SIMD kernels have the same preconditions as read_unchecked(). They
+// process as many whole vectors as they can and return the number of
+// positions processed.
+
+#if defined(ADS_SSE2)
+inline auto hsum_sse(__m128 v) -> float {
+	const auto hi = _mm_movehl_ps(v, v);
+	const auto s  = _mm_add_ps(v, hi);
+	return _mm_cvtss_f32(_mm_add_ss(s, _mm_shuffle_ps(s, s, 1)));
+}
+
+// SSE2 has no gather, so the samples are loaded one by one and only the
+// arithmetic is vectorized.
+inline auto split_sse(const double* rel, int64_t (&idx)[4], __m128& t) -> void {
+	float f[4];
+	for (int k = 0; k < 4; k++) {
+		idx[k] = static_cast<int64_t>(rel[k]);
+		f[k]   = static_cast<float>(rel[k] - static_cast<double>(idx[k]));
+	}
+	t = _mm_loadu_ps(f);
+}
+
+inline auto gather_sse(const float* x, const int64_t (&idx)[4], int64_t offset) -> __m128 {
+	return _mm_setr_ps(x[idx[0] + offset], x[idx[1] + offset], x[idx[2] + offset], x[idx[3] + offset]);
+}
+
+inline auto linear_sse(const float* x, const double* rel, uint64_t n, float* out) -> uint64_t {
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		int64_t idx[4];
+		__m128 t;
+		split_sse(rel + i, idx, t);
+		const auto a = gather_sse(x, idx, 0);
+		const auto b = gather_sse(x, idx, 1);
+		_mm_storeu_ps(out + i, _mm_add_ps(a, _mm_mul_ps(t, _mm_sub_ps(b, a))));
+	}
+	return i;
+}
+
+inline auto cubic_sse(const float* x, const double* rel, uint64_t n, float* out) -> uint64_t {
+	const auto half     = _mm_set1_ps(0.5f);
+	const auto one_half = _mm_set1_ps(1.5f);
+	const auto two      = _mm_set1_ps(2.0f);
+	const auto two_half = _mm_set1_ps(2.5f);
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		int64_t idx[4];
+		__m128 t;
+		split_sse(rel + i, idx, t);
+		const auto xm1 = gather_sse(x, idx, -1);
+		const auto x0  = gather_sse(x, idx, 0);
+		const auto x1  = gather_sse(x, idx, 1);
+		const auto x2  = gather_sse(x, idx, 2);
+		const auto c1  = _mm_mul_ps(half, _mm_sub_ps(x1, xm1));
+		const auto c2  = _mm_sub_ps(_mm_add_ps(_mm_sub_ps(xm1, _mm_mul_ps(two_half, x0)), _mm_mul_ps(two, x1)), _mm_mul_ps(half, x2));
+		const auto c3  = _mm_add_ps(_mm_mul_ps(half, _mm_sub_ps(x2, xm1)), _mm_mul_ps(one_half, _mm_sub_ps(x0, x1)));
+		auto y = _mm_add_ps(_mm_mul_ps(c3, t), c2);
+		y = _mm_add_ps(_mm_mul_ps(y, t), c1);
+		y = _mm_add_ps(_mm_mul_ps(y, t), x0);
+		_mm_storeu_ps(out + i, y);
+	}
+	return i;
+}
+
+// The taps of each position are contiguous, so sinc is vectorized across
+// the taps rather than across positions.
+template <uint64_t Points>
+auto sinc_sse(const float* x, const double* rel, uint64_t n, float* out) -> uint64_t {
+	const auto& table = get_sinc_table<float, Points>();
+	for (uint64_t i = 0; i < n; i++) {
+		const auto idx   = static_cast<int64_t>(rel[i]);
+		const auto phase = static_cast<float>(rel[i] - static_cast<double>(idx)) * float(SINC_PHASES);
+		const auto ph    = std::min(static_cast<uint64_t>(phase), SINC_PHASES - 1);
+		const auto f     = _mm_set1_ps(phase - static_cast<float>(ph));
+		const auto r0    = table.rows[ph].data();
+		const auto r1    = table.rows[ph + 1].data();
+		const auto s     = x + idx - static_cast<int64_t>(Points / 2 - 1);
+		auto acc = _mm_setzero_ps();
+		for (uint64_t j = 0; j < Points; j += 4) {
+			const auto c0 = _mm_load_ps(r0 + j);
+			const auto c  = _mm_add_ps(c0, _mm_mul_ps(f, _mm_sub_ps(_mm_load_ps(r1 + j), c0)));
+			acc = _mm_add_ps(acc, _mm_mul_ps(_mm_loadu_ps(s + j), c));
+		}
+		out[i] = hsum_sse(acc);
+	}
+	return n;
+}
+#endif // ADS_SSE2
+
+#if defined(ADS_AVX2_DISPATCH)
+// Positions within a block are less than 2^30 apart, so the indices fit
+// in the 32-bit lanes of a gather.
+ADS_TARGET_AVX2 inline auto split_avx2(const double* rel, __m256i& idx, __m256& t) -> void {
+	const auto p0 = _mm256_loadu_pd(rel);
+	const auto p1 = _mm256_loadu_pd(rel + 4);
+	const auto f0 = _mm256_cvtpd_ps(_mm256_sub_pd(p0, _mm256_floor_pd(p0)));
+	const auto f1 = _mm256_cvtpd_ps(_mm256_sub_pd(p1, _mm256_floor_pd(p1)));
+	idx = _mm256_setr_m128i(_mm256_cvttpd_epi32(p0), _mm256_cvttpd_epi32(p1));
+	t   = _mm256_setr_m128(f0, f1);
+}
+
+ADS_TARGET_AVX2 inline auto linear_avx2(const float* x, const double* rel, uint64_t n, float* out) -> uint64_t {
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i idx;
+		__m256 t;
+		split_avx2(rel + i, idx, t);
+		const auto a = _mm256_i32gather_ps(x, idx, 4);
+		const auto b = _mm256_i32gather_ps(x + 1, idx, 4);
+		_mm256_storeu_ps(out + i, _mm256_fmadd_ps(t, _mm256_sub_ps(b, a), a));
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto cubic_avx2(const float* x, const double* rel, uint64_t n, float* out) -> uint64_t {
+	const auto half     = _mm256_set1_ps(0.5f);
+	const auto one_half = _mm256_set1_ps(1.5f);
+	const auto two      = _mm256_set1_ps(2.0f);
+	const auto two_half = _mm256_set1_ps(2.5f);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256i idx;
+		__m256 t;
+		split_avx2(rel + i, idx, t);
+		const auto xm1 = _mm256_i32gather_ps(x - 1, idx, 4);
+		const auto x0  = _mm256_i32gather_ps(x, idx, 4);
+		const auto x1  = _mm256_i32gather_ps(x + 1, idx, 4);
+		const auto x2  = _mm256_i32gather_ps(x + 2, idx, 4);
+		const auto c1  = _mm256_mul_ps(half, _mm256_sub_ps(x1, xm1));
+		const auto c2  = _mm256_fnmadd_ps(half, x2, _mm256_fmadd_ps(two, x1, _mm256_fnmadd_ps(two_half, x0, xm1)));
+		const auto c3  = _mm256_fmadd_ps(one_half, _mm256_sub_ps(x0, x1), _mm256_mul_ps(half, _mm256_sub_ps(x2, xm1)));
+		auto y = _mm256_fmadd_ps(c3, t, c2);
+		y = _mm256_fmadd_ps(y, t, c1);
+		y = _mm256_fmadd_ps(y, t, x0);
+		_mm256_storeu_ps(out + i, y);
+	}
+	return i;
+}
+
+template <uint64_t Points>
+ADS_TARGET_AVX2 auto sinc_avx2(const float* x, const double* rel, uint64_t n, float* out) -> uint64_t {
+	static_assert (Points % 8 == 0);
+	const auto& table = get_sinc_table<float, Points>();
+	for (uint64_t i = 0; i < n; i++) {
+		const auto idx   = static_cast<int64_t>(rel[i]);
+		const auto phase = static_cast<float>(rel[i] - static_cast<double>(idx)) * float(SINC_PHASES);
+		const auto ph    = std::min(static_cast<uint64_t>(phase), SINC_PHASES - 1);
+		const auto f     = _mm256_set1_ps(phase - static_cast<float>(ph));
+		const auto r0    = table.rows[ph].data();
+		const auto r1    = table.rows[ph + 1].data();
+		const auto s     = x + idx - static_cast<int64_t>(Points / 2 - 1);
+		auto acc = _mm256_setzero_ps();
+		for (uint64_t j = 0; j < Points; j += 8) {
+			const auto c0 = _mm256_load_ps(r0 + j);
+			const auto c  = _mm256_fmadd_ps(f, _mm256_sub_ps(_mm256_load_ps(r1 + j), c0), c0);
+			acc = _mm256_fmadd_ps(_mm256_loadu_ps(s + j), c, acc);
+		}
+		const auto sum = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+		const auto hi  = _mm_movehl_ps(sum, sum);
+		const auto s2  = _mm_add_ps(sum, hi);
+		out[i] = _mm_cvtss_f32(_mm_add_ss(s2, _mm_shuffle_ps(s2, s2, 1)));
+	}
+	return n;
+}
+#endif // ADS_AVX2_DISPATCH
+
+template <typename Interpolation>
+auto read_simd(const float* x, const double* rel, uint64_t n, float* out) -> uint64_t {
+	if constexpr (std::is_same_v<Interpolation, interpolation::linear>) {
+#if defined(ADS_AVX2_DISPATCH)
+		return simd::has_avx2() ? linear_avx2(x, rel, n, out) : linear_sse(x, rel, n, out);
+#elif defined(ADS_SSE2)
+		return linear_sse(x, rel, n, out);
+#endif
+	}
+	else if constexpr (std::is_same_v<Interpolation, interpolation::cubic>) {
+#if defined(ADS_AVX2_DISPATCH)
+		return simd::has_avx2() ? cubic_avx2(x, rel, n, out) : cubic_sse(x, rel, n, out);
+#elif defined(ADS_SSE2)
+		return cubic_sse(x, rel, n, out);
+#endif
+	}
+	else {
+#if defined(ADS_AVX2_DISPATCH)
+		if constexpr (Interpolation::points % 8 == 0) {
+			if (simd::has_avx2()) { return sinc_avx2<Interpolation::points>(x, rel, n, out); }
+		}
+#endif
+#if defined(ADS_SSE2)
+		return sinc_sse<Interpolation::points>(x, rel, n, out);
+#endif
+	}
+	return 0;
+}
+
+// position(i) returns the i'th position to read.
+template <typename Interpolation, typename T, typename PositionFn>
+auto read(const T* x, uint64_t frame_count, uint64_t n, PositionFn position, T* out) -> void {
+	constexpr auto before = static_cast<double>(Interpolation::before);
+	constexpr auto after  = static_cast<double>(Interpolation::after);
+	double block[BLOCK_SIZE];
+	for (uint64_t start = 0; start < n; start += BLOCK_SIZE) {
+		const auto count = std::min(BLOCK_SIZE, n - start);
+		auto lo = std::numeric_limits<double>::infinity();
+		auto hi = -lo;
+		for (uint64_t k = 0; k < count; k++) {
+			block[k] = position(start + k);
+			lo = std::min(lo, block[k]);
+			hi = std::max(hi, block[k]);
+		}
+		const auto base = std::floor(lo);
+		if (base - before < 0.0 || std::floor(hi) + after >= static_cast<double>(frame_count) || hi - lo >= 0x1p30) {
+			read_checked<Interpolation>(x, static_cast<int64_t>(frame_count), block, count, out + start);
+			continue;
+		}
+		for (uint64_t k = 0; k < count; k++) {
+			block[k] -= base;
+		}
+		const auto block_x = x + static_cast<int64_t>(base);
+		uint64_t done = 0;
+		if constexpr (std::is_same_v<T, float>) {
+			done = read_simd<Interpolation>(block_x, block, count, out + start);
+		}
+		read_unchecked<Interpolation>(block_x, block + done, count - done, out + start + done);
+	}
+}
+
+template <typename Src>
+auto check_channel(const char* fn, const Src& src, channel_idx ch) -> void {
+	if (ch >= src.get_channel_count()) {
+		throw std::out_of_range{std::format("ads::{}(): Channel {} is out of range (channel count = {})", fn, ch.value, src.get_channel_count().value)};
+	}
+}
+
+} // namespace detail::interp
+
+// Fills out with channel ch of src read at fractional frame positions
+// start, start + increment, start + 2 * increment, and so on, e.g. for
+// playing a sample back at a different pitch. Frames outside the channel
+// read as zero. The SIMD implementations are for float, and use AVX2 if
+// the CPU supports it.
+template <typename Interpolation = interpolation::linear, typename Src>
+	requires concepts::is_channel_data<Src>
+auto read_interpolated(const Src& src, channel_idx ch, double start, double increment, std::span<concepts::channel_value_t<Src>> out) -> void {
+	detail::interp::check_channel("read_interpolated", src, ch);
+	detail::interp::read<Interpolation>(src.data(ch), src.get_frame_count().value, out.size(), [start, increment](uint64_t i) {
+		return start + increment * static_cast<double>(i);
+	}, out.data());
+}
+
+// The same, but out[i] is read at positions[i]. The positions don't
+// have to be in order.
+template <typename Interpolation = interpolation::linear, typename Src>
+	requires concepts::is_channel_data<Src>
+auto read_interpolated(const Src& src, channel_idx ch, std::span<const double> positions, std::span<concepts::channel_value_t<Src>> out) -> void {
+	detail::interp::check_channel("read_interpolated", src, ch);
+	if (positions.size() != out.size()) {
+		throw std::invalid_argument{std::format("ads::read_interpolated(): Expected {} positions but got {}", out.size(), positions.size())};
+	}
+	detail::interp::read<Interpolation>(src.data(ch), src.get_frame_count().value, out.size(), [positions](uint64_t i) {
+		return positions[i];
+	}, out.data());
+}
+
+} // namespace ads
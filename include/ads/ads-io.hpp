@@ -0,0 +1,506 @@
+#pragma once
+
+#include "ads-convert.hpp"
+#include <filesystem>
+#include <fstream>
+#include <optional>
+
+namespace ads {
+
+enum class file_type { wav, w64, aiff };
+
+struct file_info {
+	file_type type;
+	sample_format format;
+	ads::channel_count channel_count;
+	ads::frame_count frame_count;
+	double sample_rate;
+};
+
+namespace detail::io {
+
+static constexpr uint8_t W64_RIFF[16] = {'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00};
+static constexpr uint8_t W64_WAVE[16] = {'w', 'a', 'v', 'e', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A};
+static constexpr uint8_t W64_FMT[16]  = {'f', 'm', 't', ' ', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A};
+static constexpr uint8_t W64_DATA[16] = {'d', 'a', 't', 'a', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A};
+
+// Where the samples are in a file.
+struct layout {
+	file_info info;
+	uint64_t data_offset;
+	bool big_endian;
+};
+
+template <std::unsigned_integral T> [[nodiscard]]
+auto get_le(const std::byte* p) -> T {
+	T value = 0;
+	for (size_t i = 0; i < sizeof(T); i++) {
+		value |= static_cast<T>(std::to_integer<T>(p[i]) << (i * 8));
+	}
+	return value;
+}
+
+template <std::unsigned_integral T> [[nodiscard]]
+auto get_be(const std::byte* p) -> T {
+	T value = 0;
+	for (size_t i = 0; i < sizeof(T); i++) {
+		value = static_cast<T>((value << 8) | std::to_integer<T>(p[i]));
+	}
+	return value;
+}
+
+template <std::unsigned_integral T>
+auto put_le(std::vector<std::byte>* out, T value) -> void {
+	for (size_t i = 0; i < sizeof(T); i++) {
+		out->push_back(static_cast<std::byte>(value >> (i * 8)));
+	}
+}
+
+template <std::unsigned_integral T>
+auto put_be(std::vector<std::byte>* out, T value) -> void {
+	for (size_t i = sizeof(T); i-- > 0;) {
+		out->push_back(static_cast<std::byte>(value >> (i * 8)));
+	}
+}
+
+inline
+auto put_id(std::vector<std::byte>* out, const void* id, size_t size) -> void {
+	const auto bytes = static_cast<const std::byte*>(id);
+	out->insert(out->end(), bytes, bytes + size);
+}
+
+[[nodiscard]] inline
+auto is_id(const std::byte* p, const void* id, size_t size = 4) -> bool {
+	return std::memcmp(p, id, size) == 0;
+}
+
+// AIFF sample rates are 80-bit IEEE extended precision.
+[[nodiscard]] inline
+auto get_extended(const std::byte* p) -> double {
+	const auto sign_exponent = get_be<uint16_t>(p);
+	const auto mantissa      = get_be<uint64_t>(p + 2);
+	const auto exponent      = static_cast<int>(sign_exponent & 0x7FFF) - 16383 - 63;
+	const auto value         = std::ldexp(static_cast<double>(mantissa), exponent);
+	return (sign_exponent & 0x8000) ? -value : value;
+}
+
+inline
+auto put_extended(std::vector<std::byte>* out, double value) -> void {
+	if (!(value > 0.0)) {
+		out->insert(out->end(), 10, std::byte{0});
+		return;
+	}
+	int exponent;
+	const auto fraction = std::frexp(value, &exponent);
+	put_be(out, static_cast<uint16_t>(exponent - 1 + 16383));
+	put_be(out, static_cast<uint64_t>(std::ldexp(fraction, 64)));
+}
+
+inline
+auto read_exact(std::istream& file, uint64_t offset, std::byte* out, uint64_t size) -> bool {
+	file.seekg(static_cast<std::streamoff>(offset));
+	file.read(reinterpret_cast<char*>(out), static_cast<std::streamsize>(size));
+	return file.gcount() == static_cast<std::streamsize>(size);
+}
+
+// The WAV and W64 format chunk.
+inline
+auto parse_fmt(const std::byte* chunk, uint64_t size, file_info* info) -> void {
+	if (size < 16) {
+		throw std::runtime_error{"ads::file_reader: Invalid fmt chunk"};
+	}
+	auto tag = get_le<uint16_t>(chunk);
+	if (tag == 0xFFFE && size >= 40) {
+		// WAVE_FORMAT_EXTENSIBLE. The format is at the start of the sub-format GUID.
+		tag = get_le<uint16_t>(chunk + 24);
+	}
+	const auto bits = get_le<uint16_t>(chunk + 14);
+	info->channel_count = {get_le<uint16_t>(chunk + 2)};
+	info->sample_rate   = get_le<uint32_t>(chunk + 4);
+	if      (tag == 1 && bits == 16) { info->format = sample_format::int16; }
+	else if (tag == 1 && bits == 24) { info->format = sample_format::int24; }
+	else if (tag == 1 && bits == 32) { info->format = sample_format::int32; }
+	else if (tag == 3 && bits == 32) { info->format = sample_format::float32; }
+	else if (tag == 3 && bits == 64) { info->format = sample_format::float64; }
+	else {
+		throw std::runtime_error{std::format("ads::file_reader: Unsupported sample format (format {}, {} bits)", tag, bits)};
+	}
+}
+
+[[nodiscard]] inline
+auto parse_wav(std::istream& file, uint64_t file_size) -> layout {
+	layout out{{file_type::wav}, 0, false};
+	auto have_fmt = false;
+	std::byte header[40];
+	for (uint64_t pos = 12; pos + 8 <= file_size;) {
+		if (!read_exact(file, pos, header, 8)) { break; }
+		const auto size = uint64_t{get_le<uint32_t>(header + 4)};
+		const auto body = pos + 8;
+		if (is_id(header, "fmt ")) {
+			const auto n = std::min<uint64_t>(size, 40);
+			if (!read_exact(file, body, header, n)) { break; }
+			parse_fmt(header, n, &out.info);
+			have_fmt = true;
+		}
+		else if (is_id(header, "data")) {
+			if (!have_fmt) { break; }
+			// Streaming writers sometimes leave the size unset.
+			const auto data_size   = std::min(size, file_size - body);
+			const auto frame_bytes = get_sample_size(out.info.format) * out.info.channel_count.value;
+			out.data_offset      = body;
+			out.info.frame_count = {frame_bytes > 0 ? data_size / frame_bytes : 0};
+			return out;
+		}
+		pos = body + size + (size & 1);
+	}
+	throw std::runtime_error{"ads::file_reader: Missing fmt or data chunk"};
+}
+
+[[nodiscard]] inline
+auto parse_w64(std::istream& file, uint64_t file_size) -> layout {
+	layout out{{file_type::w64}, 0, false};
+	auto have_fmt = false;
+	std::byte header[40];
+	for (uint64_t pos = 40; pos + 24 <= file_size;) {
+		if (!read_exact(file, pos, header, 24)) { break; }
+		const auto size = get_le<uint64_t>(header + 16);
+		const auto body = pos + 24;
+		if (size < 24) { break; }
+		if (is_id(header, W64_FMT, 16)) {
+			const auto n = std::min<uint64_t>(size - 24, 40);
+			if (!read_exact(file, body, header, n)) { break; }
+			parse_fmt(header, n, &out.info);
+			have_fmt = true;
+		}
+		else if (is_id(header, W64_DATA, 16)) {
+			if (!have_fmt) { break; }
+			const auto data_size   = std::min(size - 24, file_size - body);
+			const auto frame_bytes = get_sample_size(out.info.format) * out.info.channel_count.value;
+			out.data_offset      = body;
+			out.info.frame_count = {frame_bytes > 0 ? data_size / frame_bytes : 0};
+			return out;
+		}
+		// Chunks are aligned to 8 bytes.
+		pos += (size + 7) & ~uint64_t{7};
+	}
+	throw std::runtime_error{"ads::file_reader: Missing fmt or data chunk"};
+}
+
+[[nodiscard]] inline
+auto parse_aiff(std::istream& file, uint64_t file_size, bool aifc) -> layout {
+	layout out{{file_type::aiff}, 0, true};
+	std::optional<uint32_t> frame_count;
+	std::byte header[26];
+	for (uint64_t pos = 12; pos + 8 <= file_size;) {
+		if (!read_exact(file, pos, header, 8)) { break; }
+		const auto size = uint64_t{get_be<uint32_t>(header + 4)};
+		const auto body = pos + 8;
+		if (is_id(header, "COMM")) {
+			const auto n = std::min<uint64_t>(size, aifc ? 22 : 18);
+			if (n < 18 || !read_exact(file, body, header, n)) { break; }
+			const auto bits   = get_be<uint16_t>(header + 6);
+			auto compression  = aifc && n >= 22 ? header + 18 : nullptr;
+			out.info.channel_count = {get_be<uint16_t>(header)};
+			out.info.sample_rate   = get_extended(header + 8);
+			frame_count            = get_be<uint32_t>(header + 2);
+			if (!compression || is_id(compression, "NONE") || is_id(compression, "twos") || is_id(compression, "sowt")) {
+				out.big_endian = !compression || !is_id(compression, "sowt");
+				if      (bits == 16) { out.info.format = sample_format::int16; }
+				else if (bits == 24) { out.info.format = sample_format::int24; }
+				else if (bits == 32) { out.info.format = sample_format::int32; }
+				else {
+					throw std::runtime_error{std::format("ads::file_reader: Unsupported AIFF sample size ({} bits)", bits)};
+				}
+			}
+			else if (is_id(compression, "fl32") || is_id(compression, "FL32")) { out.info.format = sample_format::float32; }
+			else if (is_id(compression, "fl64") || is_id(compression, "FL64")) { out.info.format = sample_format::float64; }
+			else {
+				throw std::runtime_error{"ads::file_reader: Unsupported AIFF-C compression type"};
+			}
+		}
+		else if (is_id(header, "SSND")) {
+			if (!frame_count || size < 8 || !read_exact(file, body, header, 8)) { break; }
+			const auto offset      = uint64_t{get_be<uint32_t>(header)};
+			const auto data_size   = std::min(size - 8 - std::min(offset, size - 8), file_size - std::min(file_size, body + 8 + offset));
+			const auto frame_bytes = get_sample_size(out.info.format) * out.info.channel_count.value;
+			out.data_offset      = body + 8 + offset;
+			out.info.frame_count = {std::min<uint64_t>(*frame_count, frame_bytes > 0 ? data_size / frame_bytes : 0)};
+			return out;
+		}
+		pos = body + size + (size & 1);
+	}
+	throw std::runtime_error{"ads::file_reader: Missing COMM or SSND chunk"};
+}
+
+[[nodiscard]] inline
+auto parse(std::istream& file, uint64_t file_size) -> layout {
+	std::byte header[40] = {};
+	if (!read_exact(file, 0, header, std::min<uint64_t>(file_size, 40)) && file_size < 12) {
+		throw std::runtime_error{"ads::file_reader: File is too small"};
+	}
+	if (is_id(header, "RIFF") && is_id(header + 8, "WAVE"))                         { return parse_wav(file, file_size); }
+	if (is_id(header, W64_RIFF, 16) && is_id(header + 24, W64_WAVE, 16))            { return parse_w64(file, file_size); }
+	if (is_id(header, "FORM") && is_id(header + 8, "AIFF"))                         { return parse_aiff(file, file_size, false); }
+	if (is_id(header, "FORM") && is_id(header + 8, "AIFC"))                         { return parse_aiff(file, file_size, true); }
+	throw std::runtime_error{"ads::file_reader: Not a WAV, W64 or AIFF file"};
+}
+
+// Everything before the samples, with the sizes filled in for
+// data_size bytes of samples.
+[[nodiscard]] inline
+auto make_header(const file_info& info, uint64_t data_size) -> std::vector<std::byte> {
+	const auto sample_size = static_cast<uint16_t>(get_sample_size(info.format));
+	const auto chs         = static_cast<uint16_t>(info.channel_count.value);
+	const auto is_float    = info.format == sample_format::float32 || info.format == sample_format::float64;
+	const auto rate        = static_cast<uint32_t>(std::lround(info.sample_rate));
+	std::vector<std::byte> out;
+	const auto put_fmt = [&] {
+		put_le(&out, uint16_t{is_float ? uint16_t{3} : uint16_t{1}});
+		put_le(&out, chs);
+		put_le(&out, rate);
+		put_le(&out, static_cast<uint32_t>(rate * sample_size * chs));
+		put_le(&out, static_cast<uint16_t>(sample_size * chs));
+		put_le(&out, static_cast<uint16_t>(sample_size * 8));
+	};
+	switch (info.type) {
+		case file_type::wav: {
+			put_id(&out, "RIFF", 4);
+			put_le(&out, static_cast<uint32_t>(36 + data_size + (data_size & 1)));
+			put_id(&out, "WAVE", 4);
+			put_id(&out, "fmt ", 4);
+			put_le(&out, uint32_t{16});
+			put_fmt();
+			put_id(&out, "data", 4);
+			put_le(&out, static_cast<uint32_t>(data_size));
+			break;
+		}
+		case file_type::w64: {
+			put_id(&out, W64_RIFF, 16);
+			put_le(&out, uint64_t{104} + ((data_size + 7) & ~uint64_t{7}));
+			put_id(&out, W64_WAVE, 16);
+			put_id(&out, W64_FMT, 16);
+			put_le(&out, uint64_t{40});
+			put_fmt();
+			put_id(&out, W64_DATA, 16);
+			put_le(&out, uint64_t{24} + data_size);
+			break;
+		}
+		case file_type::aiff: {
+			// Integer samples go in a plain AIFF file, floating point
+			// samples need AIFF-C.
+			const auto comm_size = uint32_t{is_float ? 24u : 18u};
+			const auto form_size = 4 + (is_float ? 12 : 0) + 8 + comm_size + 16 + data_size + (data_size & 1);
+			put_id(&out, "FORM", 4);
+			put_be(&out, static_cast<uint32_t>(form_size));
+			put_id(&out, is_float ? "AIFC" : "AIFF", 4);
+			if (is_float) {
+				put_id(&out, "FVER", 4);
+				put_be(&out, uint32_t{4});
+				put_be(&out, uint32_t{0xA2805140});
+			}
+			put_id(&out, "COMM", 4);
+			put_be(&out, comm_size);
+			put_be(&out, chs);
+			put_be(&out, static_cast<uint32_t>(info.frame_count.value));
+			put_be(&out, static_cast<uint16_t>(sample_size * 8));
+			put_extended(&out, info.sample_rate);
+			if (is_float) {
+				put_id(&out, info.format == sample_format::float32 ? "fl32" : "fl64", 4);
+				put_be(&out, uint16_t{0}); // Empty name, padded
+			}
+			put_id(&out, "SSND", 4);
+			put_be(&out, static_cast<uint32_t>(8 + data_size));
+			put_be(&out, uint32_t{0});
+			put_be(&out, uint32_t{0});
+			break;
+		}
+	}
+	return out;
+}
+
+inline
+auto swap_bytes(std::byte* data, uint64_t sample_count, size_t sample_size) -> void {
+	for (uint64_t i = 0; i < sample_count; i++) {
+		std::reverse(data + i * sample_size, data + (i + 1) * sample_size);
+	}
+}
+
+// Reads and writes go through a buffer of this many bytes.
+static constexpr uint64_t BUFFER_SIZE = 1 << 16;
+
+} // namespace detail::io
+
+// Streams samples from a WAV, W64 or AIFF file, a block at a time.
+// Samples are converted and deinterleaved straight into the output.
+class file_reader {
+public:
+	explicit file_reader(const std::filesystem::path& path)
+		: file_{path, std::ios::binary}
+	{
+		if (!file_) {
+			throw std::runtime_error{std::format("ads::file_reader: Failed to open '{}'", path.string())};
+		}
+		layout_ = detail::io::parse(file_, std::filesystem::file_size(path));
+		if (layout_.info.channel_count.value == 0 || layout_.info.channel_count.value > detail::SANE_NUMBER_OF_CHANNELS) {
+			throw std::runtime_error{std::format("ads::file_reader: Unsupported channel count ({})", layout_.info.channel_count.value)};
+		}
+		buffer_.resize(std::max(detail::io::BUFFER_SIZE, get_frame_size()));
+	}
+	[[nodiscard]] auto get_info() const -> const file_info&  { return layout_.info; }
+	[[nodiscard]] auto get_position() const -> frame_idx     { return {static_cast<int64_t>(position_)}; }
+	// The next read() starts at this frame.
+	auto seek(frame_idx frame) -> void {
+		if (frame.value < 0 || static_cast<uint64_t>(frame.value) > layout_.info.frame_count.value) {
+			throw std::out_of_range{std::format("ads::file_reader::seek(): Frame {} is past the end ({})", frame.value, layout_.info.frame_count.value)};
+		}
+		position_ = static_cast<uint64_t>(frame.value);
+	}
+	// Fills output from the current position, or as much of it as there
+	// are frames left in the file. Returns the number of frames read, and
+	// zero at the end of the file.
+	template <typename Dest>
+		requires concepts::is_mutable_channel_data<Dest> && concepts::is_sample<concepts::channel_value_t<Dest>>
+	auto read(Dest&& output) -> frame_count {
+		if (output.get_channel_count() != layout_.info.channel_count) {
+			throw std::invalid_argument{std::format("ads::file_reader::read(): Channel count mismatch ({} != {})", layout_.info.channel_count.value, output.get_channel_count().value)};
+		}
+		const auto frame_size   = get_frame_size();
+		const auto block_frames = buffer_.size() / frame_size;
+		const auto total        = std::min(output.get_frame_count().value, layout_.info.frame_count.value - position_);
+		uint64_t done = 0;
+		while (done < total) {
+			const auto n = std::min(block_frames, total - done);
+			file_.clear();
+			file_.seekg(static_cast<std::streamoff>(layout_.data_offset + position_ * frame_size));
+			file_.read(reinterpret_cast<char*>(buffer_.data()), static_cast<std::streamsize>(n * frame_size));
+			const auto got = static_cast<uint64_t>(file_.gcount()) / frame_size;
+			if (layout_.big_endian) {
+				detail::io::swap_bytes(buffer_.data(), got * layout_.info.channel_count.value, get_sample_size(layout_.info.format));
+			}
+			detail::convert::visit_format(layout_.info.format, [&]<typename In>(In*) {
+				detail::convert::deinterleave_n(reinterpret_cast<const In*>(buffer_.data()), layout_.info.channel_count.value, done, got, output);
+			});
+			done      += got;
+			position_ += got;
+			if (got < n) {
+				// The file is shorter than its header says.
+				break;
+			}
+		}
+		return {done};
+	}
+private:
+	[[nodiscard]] auto get_frame_size() const -> uint64_t {
+		return get_sample_size(layout_.info.format) * layout_.info.channel_count.value;
+	}
+	std::ifstream file_;
+	detail::io::layout layout_;
+	uint64_t position_ = 0;
+	std::vector<std::byte> buffer_;
+};
+
+// Streams samples to a WAV, W64 or AIFF file. The header is finished
+// by close(), or by the destructor, which ignores errors.
+class file_writer {
+public:
+	file_writer(const std::filesystem::path& path, file_type type, sample_format format, ads::channel_count channel_count, double sample_rate)
+		: file_{path, std::ios::binary | std::ios::trunc}
+		, info_{type, format, channel_count, {0}, sample_rate}
+	{
+		if (!file_) {
+			throw std::runtime_error{std::format("ads::file_writer: Failed to open '{}'", path.string())};
+		}
+		if (channel_count.value == 0 || channel_count.value > detail::SANE_NUMBER_OF_CHANNELS) {
+			throw std::invalid_argument{std::format("ads::file_writer: Unsupported channel count ({})", channel_count.value)};
+		}
+		const auto header = detail::io::make_header(info_, 0);
+		header_size_ = header.size();
+		file_.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+		buffer_.resize(std::max(detail::io::BUFFER_SIZE, get_frame_size()));
+	}
+	file_writer(file_writer&&) = default;
+	~file_writer() {
+		try { close(); } catch (...) {}
+	}
+	[[nodiscard]] auto get_info() const -> const file_info& { return info_; }
+	// Appends every frame of input.
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && concepts::is_sample<concepts::channel_value_t<Src>>
+	auto write(const Src& input) -> void {
+		write_impl(input, nullptr);
+	}
+	// Appends every frame of input, with dither if the file has integer samples.
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && concepts::is_sample<concepts::channel_value_t<Src>>
+	auto write(const Src& input, tpdf_dither& dither) -> void {
+		write_impl(input, &dither);
+	}
+	auto close() -> void {
+		if (!file_.is_open()) {
+			return;
+		}
+		const auto data_size = info_.frame_count.value * get_frame_size();
+		const auto padding   = info_.type == file_type::w64 ? ((8 - data_size % 8) % 8) : (data_size & 1);
+		for (uint64_t i = 0; i < padding; i++) {
+			file_.put(0);
+		}
+		const auto header = detail::io::make_header(info_, data_size);
+		file_.seekp(0);
+		file_.write(reinterpret_cast<const char*>(header.data()), static_cast<std::streamsize>(header.size()));
+		file_.close();
+		if (!file_) {
+			throw std::runtime_error{"ads::file_writer::close(): Failed to write file"};
+		}
+	}
+private:
+	template <typename Src>
+	auto write_impl(const Src& input, tpdf_dither* dither) -> void {
+		if (!file_.is_open()) {
+			throw std::logic_error{"ads::file_writer::write(): File is closed"};
+		}
+		if (input.get_channel_count() != info_.channel_count) {
+			throw std::invalid_argument{std::format("ads::file_writer::write(): Channel count mismatch ({} != {})", input.get_channel_count().value, info_.channel_count.value)};
+		}
+		const auto frame_size  = get_frame_size();
+		const auto frame_count = input.get_frame_count().value;
+		if (info_.type != file_type::w64 && header_size_ + (info_.frame_count.value + frame_count) * frame_size > 0xFFFFFFFEull) {
+			throw std::length_error{"ads::file_writer::write(): WAV and AIFF files are limited to 4 GB, use W64 instead"};
+		}
+		const auto block_frames = buffer_.size() / frame_size;
+		for (uint64_t start = 0; start < frame_count; start += block_frames) {
+			const auto n = std::min(block_frames, frame_count - start);
+			detail::convert::visit_format(info_.format, [&]<typename Out>(Out*) {
+				detail::convert::interleave_n(input, start, n, reinterpret_cast<Out*>(buffer_.data()), dither);
+			});
+			if (info_.type == file_type::aiff) {
+				detail::io::swap_bytes(buffer_.data(), n * info_.channel_count.value, get_sample_size(info_.format));
+			}
+			file_.write(reinterpret_cast<const char*>(buffer_.data()), static_cast<std::streamsize>(n * frame_size));
+		}
+		if (!file_) {
+			throw std::runtime_error{"ads::file_writer::write(): Failed to write file"};
+		}
+		info_.frame_count.value += frame_count;
+	}
+	[[nodiscard]] auto get_frame_size() const -> uint64_t {
+		return get_sample_size(info_.format) * info_.channel_count.value;
+	}
+	std::ofstream file_;
+	file_info info_;
+	uint64_t header_size_ = 0;
+	std::vector<std::byte> buffer_;
+};
+
+// Reads a whole file.
+template <typename ValueType> [[nodiscard]]
+auto read_file(const std::filesystem::path& path) -> data<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT> {
+	auto reader = file_reader{path};
+	auto out    = make_uninitialized<ValueType>(reader.get_info().channel_count, reader.get_info().frame_count);
+	const auto n = reader.read(out);
+	if (n < reader.get_info().frame_count) {
+		throw std::runtime_error{std::format("ads::read_file(): '{}' is truncated", path.string())};
+	}
+	return out;
+}
+
+} // namespace ads
@@ -0,0 +1,306 @@
+#pragma once
+
+#include "ads.hpp"
+#include "ads-simd.hpp"
+
+namespace ads {
+
+namespace detail::kernels {
+
+// Each SIMD kernel processes as many whole vectors as it can and
+// returns the number of frames it processed. The dispatching function
+// finishes the remainder with the scalar loop, which is also the
+// implementation for value types other than float.
+
+#if defined(ADS_SSE2)
+inline auto gain_sse(float* x, uint64_t n, float g) -> uint64_t {
+	const auto gv = _mm_set1_ps(g);
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), gv));
+	}
+	return i;
+}
+
+inline auto ramp_sse(float* x, uint64_t n, float g0, float step) -> uint64_t {
+	const auto steps = _mm_mul_ps(_mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f), _mm_set1_ps(step));
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		const auto gv = _mm_add_ps(_mm_set1_ps(g0 + step * static_cast<float>(i)), steps);
+		_mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), gv));
+	}
+	return i;
+}
+
+inline auto ramp_exp_sse(float* x, uint64_t n, float g0, float ratio) -> uint64_t {
+	const auto r2 = ratio * ratio;
+	auto gv       = _mm_set_ps(g0 * r2 * ratio, g0 * r2, g0 * ratio, g0);
+	const auto rv = _mm_set1_ps(r2 * r2);
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(x + i, _mm_mul_ps(_mm_loadu_ps(x + i), gv));
+		gv = _mm_mul_ps(gv, rv);
+	}
+	return i;
+}
+
+inline auto add_sse(float* dst, const float* src, uint64_t n) -> uint64_t {
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_loadu_ps(src + i)));
+	}
+	return i;
+}
+
+inline auto add_scaled_sse(float* dst, const float* src, uint64_t n, float g) -> uint64_t {
+	const auto gv = _mm_set1_ps(g);
+	uint64_t i = 0;
+	for (; i + 4 <= n; i += 4) {
+		_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(_mm_loadu_ps(src + i), gv)));
+	}
+	return i;
+}
+#endif // ADS_SSE2
+
+#if defined(ADS_AVX2_DISPATCH)
+ADS_TARGET_AVX2 inline auto gain_avx2(float* x, uint64_t n, float g) -> uint64_t {
+	const auto gv = _mm256_set1_ps(g);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), gv));
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto ramp_avx2(float* x, uint64_t n, float g0, float step) -> uint64_t {
+	const auto steps = _mm256_mul_ps(_mm256_set_ps(7.0f, 6.0f, 5.0f, 4.0f, 3.0f, 2.0f, 1.0f, 0.0f), _mm256_set1_ps(step));
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		const auto gv = _mm256_add_ps(_mm256_set1_ps(g0 + step * static_cast<float>(i)), steps);
+		_mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), gv));
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto ramp_exp_avx2(float* x, uint64_t n, float g0, float ratio) -> uint64_t {
+	float gains[8];
+	gains[0] = g0;
+	for (int j = 1; j < 8; j++) { gains[j] = gains[j - 1] * ratio; }
+	auto gv       = _mm256_loadu_ps(gains);
+	const auto rv = _mm256_set1_ps(gains[7] * ratio / g0);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(x + i, _mm256_mul_ps(_mm256_loadu_ps(x + i), gv));
+		gv = _mm256_mul_ps(gv, rv);
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto add_avx2(float* dst, const float* src, uint64_t n) -> uint64_t {
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_loadu_ps(src + i)));
+	}
+	return i;
+}
+
+ADS_TARGET_AVX2 inline auto add_scaled_avx2(float* dst, const float* src, uint64_t n, float g) -> uint64_t {
+	const auto gv = _mm256_set1_ps(g);
+	uint64_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_storeu_ps(dst + i, _mm256_fmadd_ps(_mm256_loadu_ps(src + i), gv, _mm256_loadu_ps(dst + i)));
+	}
+	return i;
+}
+#endif // ADS_AVX2_DISPATCH
+
+template <typename T>
+auto gain(T* x, uint64_t n, T g) -> void {
+	uint64_t i = 0;
+	if constexpr (std::is_same_v<T, float>) {
+#if defined(ADS_AVX2_DISPATCH)
+		i = simd::has_avx2() ? gain_avx2(x, n, g) : gain_sse(x, n, g);
+#elif defined(ADS_SSE2)
+		i = gain_sse(x, n, g);
+#endif
+	}
+	for (; i < n; i++) {
+		x[i] *= g;
+	}
+}
+
+// x[i] *= g0 + step * i
+template <typename T>
+auto ramp(T* x, uint64_t n, T g0, T step) -> void {
+	uint64_t i = 0;
+	if constexpr (std::is_same_v<T, float>) {
+#if defined(ADS_AVX2_DISPATCH)
+		i = simd::has_avx2() ? ramp_avx2(x, n, g0, step) : ramp_sse(x, n, g0, step);
+#elif defined(ADS_SSE2)
+		i = ramp_sse(x, n, g0, step);
+#endif
+	}
+	for (; i < n; i++) {
+		x[i] *= g0 + step * static_cast<T>(i);
+	}
+}
+
+// x[i] *= g0 * ratio^i
+template <typename T>
+auto ramp_exp(T* x, uint64_t n, T g0, T ratio) -> void {
+	uint64_t i = 0;
+	if constexpr (std::is_same_v<T, float>) {
+#if defined(ADS_AVX2_DISPATCH)
+		i = simd::has_avx2() ? ramp_exp_avx2(x, n, g0, ratio) : ramp_exp_sse(x, n, g0, ratio);
+#elif defined(ADS_SSE2)
+		i = ramp_exp_sse(x, n, g0, ratio);
+#endif
+	}
+	auto g = static_cast<T>(g0 * std::pow(ratio, static_cast<T>(i)));
+	for (; i < n; i++) {
+		x[i] *= g;
+		g    *= ratio;
+	}
+}
+
+template <typename T>
+auto add(T* dst, const T* src, uint64_t n) -> void {
+	uint64_t i = 0;
+	if constexpr (std::is_same_v<T, float>) {
+#if defined(ADS_AVX2_DISPATCH)
+		i = simd::has_avx2() ? add_avx2(dst, src, n) : add_sse(dst, src, n);
+#elif defined(ADS_SSE2)
+		i = add_sse(dst, src, n);
+#endif
+	}
+	for (; i < n; i++) {
+		dst[i] += src[i];
+	}
+}
+
+template <typename T>
+auto add_scaled(T* dst, const T* src, uint64_t n, T g) -> void {
+	uint64_t i = 0;
+	if constexpr (std::is_same_v<T, float>) {
+#if defined(ADS_AVX2_DISPATCH)
+		i = simd::has_avx2() ? add_scaled_avx2(dst, src, n, g) : add_scaled_sse(dst, src, n, g);
+#elif defined(ADS_SSE2)
+		i = add_scaled_sse(dst, src, n, g);
+#endif
+	}
+	for (; i < n; i++) {
+		dst[i] += src[i] * g;
+	}
+}
+
+template <typename Dest, typename Src>
+auto check_channel_counts(const char* fn, const Dest& dest, const Src& src) -> void {
+	if (dest.get_channel_count() != src.get_channel_count()) {
+		throw std::invalid_argument{std::format("ads::{}(): Channel count mismatch ({} != {})", fn, src.get_channel_count().value, dest.get_channel_count().value)};
+	}
+}
+
+template <typename Dest, typename T>
+auto check_channel_gains(const char* fn, const Dest& dest, std::span<const T> gains) -> void {
+	if (gains.size() != dest.get_channel_count().value) {
+		throw std::invalid_argument{std::format("ads::{}(): Expected {} channel gains but got {}", fn, dest.get_channel_count().value, gains.size())};
+	}
+}
+
+} // namespace detail::kernels
+
+// These take ads::data or views. The SIMD implementations are for float,
+// and use AVX2 if the CPU supports it.
+
+template <typename Dest>
+	requires concepts::is_mutable_channel_data<Dest>
+auto apply_gain(Dest&& dest, concepts::channel_value_t<Dest> gain) -> void {
+	for (ads::channel_idx ch = {0}; ch < dest.get_channel_count(); ch++) {
+		detail::kernels::gain(dest.data(ch), dest.get_frame_count().value, gain);
+	}
+}
+
+// One gain per channel.
+template <typename Dest>
+	requires concepts::is_mutable_channel_data<Dest>
+auto apply_gain(Dest&& dest, std::span<const concepts::channel_value_t<Dest>> channel_gains) -> void {
+	detail::kernels::check_channel_gains("apply_gain", dest, channel_gains);
+	for (ads::channel_idx ch = {0}; ch < dest.get_channel_count(); ch++) {
+		detail::kernels::gain(dest.data(ch), dest.get_frame_count().value, channel_gains[ch.value]);
+	}
+}
+
+// The gain moves linearly from start towards end, reaching it one frame
+// after the last, so consecutive blocks can be ramped seamlessly.
+template <typename Dest>
+	requires concepts::is_mutable_channel_data<Dest>
+auto apply_gain_ramp(Dest&& dest, concepts::channel_value_t<Dest> start, concepts::channel_value_t<Dest> end) -> void {
+	using value_type = concepts::channel_value_t<Dest>;
+	const auto frame_count = dest.get_frame_count().value;
+	if (frame_count == 0) {
+		return;
+	}
+	const auto step = (end - start) / static_cast<value_type>(frame_count);
+	for (ads::channel_idx ch = {0}; ch < dest.get_channel_count(); ch++) {
+		detail::kernels::ramp(dest.data(ch), frame_count, start, step);
+	}
+}
+
+// The same as apply_gain_ramp() but the gain moves exponentially, i.e.
+// linearly in decibels. Both gains must be greater than zero.
+template <typename Dest>
+	requires concepts::is_mutable_channel_data<Dest>
+auto apply_gain_ramp_exp(Dest&& dest, concepts::channel_value_t<Dest> start, concepts::channel_value_t<Dest> end) -> void {
+	using value_type = concepts::channel_value_t<Dest>;
+	if (!(start > value_type{0}) || !(end > value_type{0})) {
+		throw std::invalid_argument{std::format("ads::apply_gain_ramp_exp(): Gains must be greater than zero ({}, {})", start, end)};
+	}
+	const auto frame_count = dest.get_frame_count().value;
+	if (frame_count == 0) {
+		return;
+	}
+	const auto ratio = static_cast<value_type>(std::pow(end / start, value_type{1} / static_cast<value_type>(frame_count)));
+	for (ads::channel_idx ch = {0}; ch < dest.get_channel_count(); ch++) {
+		detail::kernels::ramp_exp(dest.data(ch), frame_count, start, ratio);
+	}
+}
+
+// dest += src, over as many frames as both have. Returns the number of
+// frames processed.
+template <typename Dest, typename Src>
+	requires concepts::is_mutable_channel_data<Dest> && concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Dest>, concepts::channel_value_t<Src>>
+auto add(Dest&& dest, const Src& src) -> frame_count {
+	detail::kernels::check_channel_counts("add", dest, src);
+	const auto frame_count = std::min(dest.get_frame_count(), src.get_frame_count());
+	for (ads::channel_idx ch = {0}; ch < dest.get_channel_count(); ch++) {
+		detail::kernels::add(dest.data(ch), src.data(ch), frame_count.value);
+	}
+	return frame_count;
+}
+
+// dest += src * gain
+template <typename Dest, typename Src>
+	requires concepts::is_mutable_channel_data<Dest> && concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Dest>, concepts::channel_value_t<Src>>
+auto add_scaled(Dest&& dest, const Src& src, concepts::channel_value_t<Dest> gain) -> frame_count {
+	detail::kernels::check_channel_counts("add_scaled", dest, src);
+	const auto frame_count = std::min(dest.get_frame_count(), src.get_frame_count());
+	for (ads::channel_idx ch = {0}; ch < dest.get_channel_count(); ch++) {
+		detail::kernels::add_scaled(dest.data(ch), src.data(ch), frame_count.value, gain);
+	}
+	return frame_count;
+}
+
+// dest += src * gain, with one gain per channel.
+template <typename Dest, typename Src>
+	requires concepts::is_mutable_channel_data<Dest> && concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Dest>, concepts::channel_value_t<Src>>
+auto add_scaled(Dest&& dest, const Src& src, std::span<const concepts::channel_value_t<Dest>> channel_gains) -> frame_count {
+	detail::kernels::check_channel_counts("add_scaled", dest, src);
+	detail::kernels::check_channel_gains("add_scaled", dest, channel_gains);
+	const auto frame_count = std::min(dest.get_frame_count(), src.get_frame_count());
+	for (ads::channel_idx ch = {0}; ch < dest.get_channel_count(); ch++) {
+		detail::kernels::add_scaled(dest.data(ch), src.data(ch), frame_count.value, channel_gains[ch.value]);
+	}
+	return frame_count;
+}
+
+} // namespace ads
@@ -0,0 +1,260 @@
+#pragma once
+
+#include "ads-view.hpp"
+#include <cerrno>
+#include <filesystem>
+#include <optional>
+#include <utility>
+
+#if defined(_WIN32)
+#	ifndef NOMINMAX
+#		define NOMINMAX
+#	endif
+#	ifndef WIN32_LEAN_AND_MEAN
+#		define WIN32_LEAN_AND_MEAN
+#	endif
+#	include <windows.h>
+#else
+#	include <fcntl.h>
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <unistd.h>
+#endif
+
+namespace ads {
+
+// How a mapping is going to be read, passed on to the OS with madvise().
+enum class access_hint { normal, sequential, random, will_need };
+
+namespace detail {
+
+// A whole file mapped into memory, either read-only or copy-on-write.
+// Copy-on-write mappings can be written to, but the changes are private
+// to the process and are never written back to the file.
+class mapped_file {
+public:
+	mapped_file() = default;
+	mapped_file(const std::filesystem::path& path, bool copy_on_write) {
+#if defined(_WIN32)
+		const auto file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if (file == INVALID_HANDLE_VALUE) {
+			throw std::runtime_error{std::format("ads::mapped_file: Failed to open '{}' ({})", path.string(), GetLastError())};
+		}
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size)) {
+			CloseHandle(file);
+			throw std::runtime_error{std::format("ads::mapped_file: Failed to get the size of '{}' ({})", path.string(), GetLastError())};
+		}
+		size_ = static_cast<size_t>(size.QuadPart);
+		if (size_ > 0) {
+			const auto mapping = CreateFileMappingW(file, nullptr, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+			if (mapping) {
+				data_ = static_cast<std::byte*>(MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0));
+				CloseHandle(mapping);
+			}
+		}
+		const auto error = GetLastError();
+		CloseHandle(file);
+		if (size_ > 0 && !data_) {
+			throw std::runtime_error{std::format("ads::mapped_file: Failed to map '{}' ({})", path.string(), error)};
+		}
+#else
+		const auto fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error{std::format("ads::mapped_file: Failed to open '{}' ({})", path.string(), errno)};
+		}
+		struct stat info;
+		if (::fstat(fd, &info) != 0) {
+			const auto error = errno;
+			::close(fd);
+			throw std::runtime_error{std::format("ads::mapped_file: Failed to get the size of '{}' ({})", path.string(), error)};
+		}
+		size_ = static_cast<size_t>(info.st_size);
+		if (size_ > 0) {
+			const auto prot = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+			const auto ptr  = ::mmap(nullptr, size_, prot, MAP_PRIVATE, fd, 0);
+			if (ptr == MAP_FAILED) {
+				const auto error = errno;
+				::close(fd);
+				throw std::runtime_error{std::format("ads::mapped_file: Failed to map '{}' ({})", path.string(), error)};
+			}
+			data_ = static_cast<std::byte*>(ptr);
+		}
+		// The mapping keeps the file open.
+		::close(fd);
+#endif
+	}
+	mapped_file(const mapped_file&) = delete;
+	mapped_file(mapped_file&& rhs) noexcept
+		: data_{std::exchange(rhs.data_, nullptr)}
+		, size_{std::exchange(rhs.size_, 0)}
+	{}
+	auto operator=(const mapped_file&) -> mapped_file& = delete;
+	auto operator=(mapped_file&& rhs) noexcept -> mapped_file& {
+		if (this != &rhs) {
+			unmap();
+			data_ = std::exchange(rhs.data_, nullptr);
+			size_ = std::exchange(rhs.size_, 0);
+		}
+		return *this;
+	}
+	~mapped_file() {
+		unmap();
+	}
+	[[nodiscard]] auto data() const -> std::byte* { return data_; }
+	[[nodiscard]] auto size() const -> size_t     { return size_; }
+	// Only a hint, so failure is ignored. Does nothing on Windows.
+	auto advise(access_hint hint) const -> void {
+#if !defined(_WIN32)
+		if (!data_) {
+			return;
+		}
+		const auto advice = [hint] {
+			switch (hint) {
+				case access_hint::sequential: { return MADV_SEQUENTIAL; }
+				case access_hint::random:     { return MADV_RANDOM; }
+				case access_hint::will_need:  { return MADV_WILLNEED; }
+				default:                      { return MADV_NORMAL; }
+			}
+		}();
+		::madvise(data_, size_, advice);
+#else
+		static_cast<void>(hint);
+#endif
+	}
+private:
+	auto unmap() -> void {
+		if (!data_) {
+			return;
+		}
+#if defined(_WIN32)
+		UnmapViewOfFile(data_);
+#else
+		::munmap(data_, size_);
+#endif
+		data_ = nullptr;
+		size_ = 0;
+	}
+	std::byte* data_ = nullptr;
+	size_t size_     = 0;
+};
+
+[[nodiscard]] inline
+auto read_u16_le(const std::byte* p) -> uint16_t {
+	return static_cast<uint16_t>(std::to_integer<uint16_t>(p[0]) | (std::to_integer<uint16_t>(p[1]) << 8));
+}
+
+[[nodiscard]] inline
+auto read_u32_le(const std::byte* p) -> uint32_t {
+	return std::to_integer<uint32_t>(p[0]) | (std::to_integer<uint32_t>(p[1]) << 8) | (std::to_integer<uint32_t>(p[2]) << 16) | (std::to_integer<uint32_t>(p[3]) << 24);
+}
+
+struct wav_float_data {
+	uint64_t offset;
+	uint64_t size;
+	uint16_t channel_count;
+};
+
+// Finds the data chunk of a floating point WAV file with the given
+// sample size.
+[[nodiscard]] inline
+auto find_wav_float_data(std::span<const std::byte> file, uint16_t bytes_per_sample) -> wav_float_data {
+	const auto is_id = [](const std::byte* p, const char* id) { return std::memcmp(p, id, 4) == 0; };
+	if (file.size() < 12 || !is_id(file.data(), "RIFF") || !is_id(file.data() + 8, "WAVE")) {
+		throw std::runtime_error{"ads::map_wav(): Not a WAV file"};
+	}
+	std::optional<uint16_t> channel_count;
+	uint64_t pos = 12;
+	while (pos + 8 <= file.size()) {
+		const auto chunk      = file.data() + pos;
+		const auto chunk_size = uint64_t{read_u32_le(chunk + 4)};
+		const auto body       = pos + 8;
+		if (is_id(chunk, "fmt ")) {
+			if (chunk_size < 16 || body + chunk_size > file.size()) {
+				throw std::runtime_error{"ads::map_wav(): Invalid fmt chunk"};
+			}
+			auto format = read_u16_le(chunk + 8);
+			if (format == 0xFFFE && chunk_size >= 40) {
+				// WAVE_FORMAT_EXTENSIBLE. The format is at the start of the sub-format GUID.
+				format = read_u16_le(chunk + 8 + 24);
+			}
+			const auto bits = read_u16_le(chunk + 8 + 14);
+			if (format != 3 || bits != bytes_per_sample * 8) {
+				throw std::runtime_error{std::format("ads::map_wav(): Expected {}-bit floating point samples (format {}, {} bits)", bytes_per_sample * 8, format, bits)};
+			}
+			channel_count = read_u16_le(chunk + 8 + 2);
+		}
+		else if (is_id(chunk, "data")) {
+			if (!channel_count) {
+				throw std::runtime_error{"ads::map_wav(): Missing fmt chunk"};
+			}
+			return {body, std::min(chunk_size, file.size() - body), *channel_count};
+		}
+		pos = body + chunk_size + (chunk_size & 1);
+	}
+	throw std::runtime_error{"ads::map_wav(): Missing data chunk"};
+}
+
+} // namespace detail
+
+// ads::data backed by a memory-mapped file, with the same API as a
+// view. Mapping a const ElementType is read-only, otherwise the mapping
+// is copy-on-write.
+template <typename ElementType, uint64_t Chs = DYNAMIC_EXTENT>
+class mapped : public detail::view_impl<ElementType, Chs, DYNAMIC_EXTENT> {
+public:
+	using view_type = detail::view_impl<ElementType, Chs, DYNAMIC_EXTENT>;
+	mapped() = default;
+	mapped(detail::mapped_file file, view_type view)
+		: view_type{view}
+		, file_{std::move(file)}
+	{}
+	auto advise(access_hint hint) const -> void { file_.advise(hint); }
+	[[nodiscard]] auto as_view() const -> view_type { return *this; }
+private:
+	detail::mapped_file file_;
+};
+
+// Maps a file of planar samples, i.e. each channel stored one after
+// the other.
+template <typename ElementType, uint64_t Chs = DYNAMIC_EXTENT> [[nodiscard]]
+auto map_raw(const std::filesystem::path& path, ads::channel_count channel_count) -> mapped<ElementType, Chs> {
+	using value_type = std::remove_const_t<ElementType>;
+	if (channel_count.value == 0) {
+		throw std::invalid_argument{"ads::map_raw(): Channel count must be greater than zero"};
+	}
+	auto file = detail::mapped_file{path, !std::is_const_v<ElementType>};
+	const auto channel_bytes = channel_count.value * sizeof(value_type);
+	if (file.size() % channel_bytes != 0) {
+		throw std::runtime_error{std::format("ads::map_raw(): Size of '{}' ({}) is not a whole number of {}-channel frames", path.string(), file.size(), channel_count.value)};
+	}
+	const auto frame_count = ads::frame_count{file.size() / channel_bytes};
+	const auto base        = reinterpret_cast<ElementType*>(file.data());
+	return {std::move(file), {base, channel_count, frame_count}};
+}
+
+template <typename ElementType, uint64_t Chs> requires (Chs != DYNAMIC_EXTENT) [[nodiscard]]
+auto map_raw(const std::filesystem::path& path) -> mapped<ElementType, Chs> {
+	return map_raw<ElementType, Chs>(path, ads::channel_count{Chs});
+}
+
+// Maps the data chunk of a floating point WAV file. WAV samples are
+// interleaved, so only mono files can be mapped.
+template <typename ElementType> [[nodiscard]]
+auto map_wav(const std::filesystem::path& path) -> mapped<ElementType, 1> {
+	using value_type = std::remove_const_t<ElementType>;
+	static_assert (std::is_floating_point_v<value_type>, "WAV files can only be mapped as float or double");
+	auto file = detail::mapped_file{path, !std::is_const_v<ElementType>};
+	const auto info = detail::find_wav_float_data({file.data(), file.size()}, sizeof(value_type));
+	if (info.channel_count != 1) {
+		throw std::runtime_error{std::format("ads::map_wav(): '{}' has {} interleaved channels, only mono files can be mapped", path.string(), info.channel_count)};
+	}
+	if (info.offset % alignof(value_type) != 0) {
+		throw std::runtime_error{std::format("ads::map_wav(): Data chunk of '{}' is not aligned", path.string())};
+	}
+	const auto frame_count = ads::frame_count{info.size / sizeof(value_type)};
+	const auto base        = reinterpret_cast<ElementType*>(file.data() + info.offset);
+	return {std::move(file), {base, ads::channel_count{1}, frame_count}};
+}
+
+} // namespace ads
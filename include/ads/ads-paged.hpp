@@ -0,0 +1,427 @@
+#pragma once
+
+#include "ads.hpp"
+
+namespace ads {
+
+// Storage for very long or growing recordings. Frames are stored in
+// fixed-size pages which are allocated on demand, so appending never
+// moves existing audio and memory is only committed as it is used. Each
+// page holds PageSize frames of every channel, one channel after another.
+//
+// read() and write() take the same callbacks as ads::data, but a range
+// which crosses a page boundary is passed to the callback in several
+// pieces.
+template <typename ValueType, uint64_t Chs = DYNAMIC_EXTENT, uint64_t PageSize = 65536, typename Policy = default_policy>
+class paged {
+public:
+	static constexpr auto CHANNEL_COUNT = Chs;
+	static constexpr auto PAGE_SIZE     = PageSize;
+	static constexpr auto ALIGNMENT     = detail::get_alignment<ValueType, Policy>();
+	using value_type     = ValueType;
+	using policy         = Policy;
+	using allocator_type = typename Policy::allocator;
+	static_assert (std::has_single_bit(PageSize), "PageSize must be a power of two");
+	static_assert ((PageSize * sizeof(ValueType)) % ALIGNMENT == 0, "PageSize is too small for the policy's alignment");
+	paged() requires (Chs != DYNAMIC_EXTENT) = default;
+	explicit paged(const allocator_type& alloc) requires (Chs != DYNAMIC_EXTENT)
+		: page_alloc_{alloc}
+		, pages_{page_table_allocator{alloc}}
+	{}
+	explicit paged(ads::channel_count channel_count, const allocator_type& alloc = {})
+		: page_alloc_{alloc}
+		, pages_{page_table_allocator{alloc}}
+		, channel_count_{channel_count.value}
+	{
+		if (Chs != DYNAMIC_EXTENT && channel_count.value != Chs) {
+			throw std::invalid_argument{std::format("ads::paged: Channel count {} doesn't match the static channel count {}", channel_count.value, Chs)};
+		}
+		if (channel_count.value > detail::SANE_NUMBER_OF_CHANNELS) {
+			throw std::underflow_error{std::format("ads::paged: Channel count {} is insane", channel_count.value)};
+		}
+	}
+	paged(const paged& rhs)
+		: page_alloc_{std::allocator_traits<page_allocator>::select_on_container_copy_construction(rhs.page_alloc_)}
+		, pages_{page_table_allocator{allocator_type{page_alloc_.upstream()}}}
+		, channel_count_{rhs.channel_count_}
+	{
+		reserve_pages(rhs.get_page_count(rhs.frame_count_));
+		for (uint64_t p = 0; p < pages_.size(); p++) {
+			std::copy_n(rhs.pages_[p], get_page_values(), pages_[p]);
+		}
+		frame_count_ = rhs.frame_count_;
+	}
+	paged(paged&& rhs) noexcept
+		: page_alloc_{std::move(rhs.page_alloc_)}
+		, pages_{std::move(rhs.pages_)}
+		, channel_count_{rhs.channel_count_}
+		, frame_count_{std::exchange(rhs.frame_count_, 0)}
+	{
+		rhs.pages_.clear();
+	}
+	auto operator=(const paged& rhs) -> paged& {
+		if (this != &rhs) {
+			auto copy = paged{rhs};
+			swap(copy);
+		}
+		return *this;
+	}
+	auto operator=(paged&& rhs) noexcept -> paged& {
+		swap(rhs);
+		return *this;
+	}
+	~paged() {
+		release_pages(0);
+	}
+	auto swap(paged& rhs) noexcept -> void {
+		std::swap(page_alloc_, rhs.page_alloc_);
+		std::swap(pages_, rhs.pages_);
+		std::swap(channel_count_, rhs.channel_count_);
+		std::swap(frame_count_, rhs.frame_count_);
+	}
+	[[nodiscard]] auto get_allocator() const -> allocator_type      { return allocator_type{page_alloc_.upstream()}; }
+	[[nodiscard]] auto get_channel_count() const -> channel_count   { return {channel_count_}; }
+	[[nodiscard]] auto get_frame_count() const -> frame_count       { return {frame_count_}; }
+	[[nodiscard]] auto get_page_count() const -> uint64_t           { return pages_.size(); }
+	// The number of frames which fit in the pages already allocated.
+	[[nodiscard]] auto get_capacity() const -> frame_count          { return {pages_.size() * PageSize}; }
+	// Allocates pages up front, so that growing to this many frames
+	// doesn't allocate.
+	auto reserve(ads::frame_count frame_count) -> void {
+		check_frame_count("reserve", frame_count.value);
+		reserve_pages(get_page_count(frame_count.value));
+	}
+	// Pages beyond the frame count are kept until shrink_to_fit().
+	auto resize(ads::frame_count frame_count) -> void {
+		resize(frame_count, ValueType{});
+	}
+	auto resize(ads::frame_count frame_count, ValueType fill_value) -> void {
+		check_frame_count("resize", frame_count.value);
+		const auto old_frame_count = frame_count_;
+		reserve_pages(get_page_count(frame_count.value));
+		frame_count_ = frame_count.value;
+		if (frame_count_ > old_frame_count) {
+			fill(frame_idx{static_cast<int64_t>(old_frame_count)}, frame_count_ - old_frame_count, fill_value);
+		}
+	}
+	auto clear() -> void {
+		frame_count_ = 0;
+	}
+	auto shrink_to_fit() -> void {
+		release_pages(get_page_count(frame_count_));
+		pages_.shrink_to_fit();
+	}
+	// Appends one frame. Only allocates when a new page is started.
+	auto append(const frame_t<ValueType, Chs>& value) -> void {
+		assert (value.size() == channel_count_);
+		check_frame_count("append", frame_count_ + 1);
+		reserve_pages(get_page_count(frame_count_ + 1));
+		const auto page = pages_[frame_count_ / PageSize];
+		const auto pos  = frame_count_ % PageSize;
+		for (uint64_t c = 0; c < channel_count_; c++) {
+			page[c * PageSize + pos] = value[c];
+		}
+		frame_count_++;
+	}
+	// Appends up to n frames which are filled in by write_fn, and returns
+	// the number of frames written. The frame count only grows by that
+	// many frames, even if more pages than that were allocated.
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto append(ads::frame_count n, WriteFn write_fn) -> frame_count {
+		check_frame_count("append", frame_count_ + n.value);
+		const auto start = frame_idx{static_cast<int64_t>(frame_count_)};
+		reserve_pages(get_page_count(frame_count_ + n.value));
+		const auto old_frame_count = frame_count_;
+		frame_count_ += n.value;
+		auto written = ads::frame_count{0};
+		try {
+			written = write(start, n, write_fn);
+		}
+		catch (...) {
+			frame_count_ = old_frame_count;
+			throw;
+		}
+		frame_count_ = old_frame_count + written.value;
+		return written;
+	}
+	// Appends every frame of src, which must have the same number of
+	// channels.
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Src>, ValueType>
+	auto append(const Src& src) -> frame_count {
+		if (src.get_channel_count() != channel_count_) {
+			throw std::invalid_argument{std::format("ads::paged::append(): Channel count mismatch ({} != {})", src.get_channel_count().value, channel_count_)};
+		}
+		const auto offset = static_cast<int64_t>(frame_count_);
+		return append(src.get_frame_count(), [&src, offset](ValueType* buffer, channel_idx ch, frame_idx start, ads::frame_count n) {
+			std::copy_n(src.data(ch) + (start.value - offset), n.value, buffer);
+			return n;
+		});
+	}
+	[[nodiscard]]
+	auto at(channel_idx ch, frame_idx f) -> ValueType& {
+		detail::check_index<typename Policy::bounds_check>("channel", ch.value, channel_count_);
+		detail::check_index<typename Policy::bounds_check>("frame", static_cast<uint64_t>(f.value), frame_count_);
+		return at_unchecked(ch, f);
+	}
+	[[nodiscard]]
+	auto at(channel_idx ch, frame_idx f) const -> const ValueType& {
+		detail::check_index<typename Policy::bounds_check>("channel", ch.value, channel_count_);
+		detail::check_index<typename Policy::bounds_check>("frame", static_cast<uint64_t>(f.value), frame_count_);
+		return at_unchecked(ch, f);
+	}
+	[[nodiscard]] auto at_unchecked(channel_idx ch, frame_idx f) -> ValueType&             { return pages_[f.value / PageSize][ch.value * PageSize + f.value % PageSize]; }
+	[[nodiscard]] auto at_unchecked(channel_idx ch, frame_idx f) const -> const ValueType& { return pages_[f.value / PageSize][ch.value * PageSize + f.value % PageSize]; }
+	[[nodiscard]] auto at(frame_idx f) -> ValueType&             requires (concepts::is_mono_data<Chs>) { return at(channel_idx{0}, f); }
+	[[nodiscard]] auto at(frame_idx f) const -> const ValueType& requires (concepts::is_mono_data<Chs>) { return at(channel_idx{0}, f); }
+	auto set(channel_idx ch, frame_idx f, ValueType value) -> void {
+		at(ch, f) = value;
+	}
+	auto set(frame_idx f, frame_t<ValueType, Chs> value) -> void {
+		for (uint64_t c = 0; c < channel_count_; c++) {
+			at(channel_idx{c}, f) = value[c];
+		}
+	}
+	auto set_unchecked(channel_idx ch, frame_idx f, ValueType value) -> void {
+		at_unchecked(ch, f) = value;
+	}
+	auto fill(ValueType value) -> void {
+		fill(frame_idx{0}, frame_count_, value);
+	}
+	// Calls fn with contiguous spans of each channel. A span never crosses
+	// a page boundary, and is at most BlockSize frames long.
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename Fn>
+		requires concepts::is_block_visitor_fn<ValueType, Fn>
+	auto visit_blocks(Fn fn) const -> void {
+		for (ads::channel_idx ch = {0}; ch < channel_count_; ch++) {
+			static_cast<void>(for_each_chunk<BlockSize>(ch, frame_idx{0}, get_frame_count(), [ch, &fn](const ValueType* buffer, frame_idx start, ads::frame_count n) {
+				fn(ch, start, std::span{buffer, n.value});
+				return n;
+			}));
+		}
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(ReadFn read_fn) const -> frame_count {
+		return read(frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(frame_idx start, ReadFn read_fn) const -> frame_count {
+		return read(start, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(frame_count n, ReadFn read_fn) const -> frame_count {
+		return read(frame_idx{0}, n, read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return for_each_channel("read", [&](channel_idx ch) { return read(ch, start, n, read_fn); });
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(channel_idx ch, ReadFn read_fn) const -> frame_count {
+		return read(ch, frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(channel_idx ch, frame_idx start, ReadFn read_fn) const -> frame_count {
+		return read(ch, start, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(channel_idx ch, frame_count n, ReadFn read_fn) const -> frame_count {
+		return read(ch, frame_idx{0}, n, read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(channel_idx ch, frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return for_each_chunk<DYNAMIC_EXTENT>(ch, start, n, [ch, &read_fn](const ValueType* buffer, frame_idx chunk_start, ads::frame_count chunk_frames) {
+			if constexpr (concepts::is_single_channel_read_fn<ValueType, ReadFn>) { return read_fn(buffer, chunk_start, chunk_frames); }
+			else                                                                  { return read_fn(buffer, ch, chunk_start, chunk_frames); }
+		});
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(WriteFn write_fn) -> frame_count {
+		return write(frame_idx{0}, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(frame_idx start, WriteFn write_fn) -> frame_count {
+		return write(start, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(frame_count n, WriteFn write_fn) -> frame_count {
+		return write(frame_idx{0}, n, write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
+		return for_each_channel("write", [&](channel_idx ch) { return write(ch, start, n, write_fn); });
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(channel_idx ch, WriteFn write_fn) -> frame_count {
+		return write(ch, frame_idx{0}, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(channel_idx ch, frame_idx start, WriteFn write_fn) -> frame_count {
+		return write(ch, start, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(channel_idx ch, frame_count n, WriteFn write_fn) -> frame_count {
+		return write(ch, frame_idx{0}, n, write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(channel_idx ch, frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
+		return for_each_chunk<DYNAMIC_EXTENT>(ch, start, n, [ch, &write_fn](ValueType* buffer, frame_idx chunk_start, ads::frame_count chunk_frames) {
+			if constexpr (concepts::is_single_channel_write_fn<ValueType, WriteFn>) { return write_fn(buffer, chunk_start, chunk_frames); }
+			else                                                                    { return write_fn(buffer, ch, chunk_start, chunk_frames); }
+		});
+	}
+	// Block callbacks receive a pointer to every channel at once. Blocks
+	// never cross a page boundary, and are at most BlockSize frames long.
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename ReadFn>
+		requires concepts::is_block_read_fn<ValueType, ReadFn>
+	auto read_blocks(ReadFn read_fn) const -> frame_count {
+		return read_blocks<BlockSize>(frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename ReadFn>
+		requires concepts::is_block_read_fn<ValueType, ReadFn>
+	auto read_blocks(frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return for_each_block<BlockSize, const ValueType>(*this, start, n, read_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename WriteFn>
+		requires concepts::is_block_write_fn<ValueType, WriteFn>
+	auto write_blocks(WriteFn write_fn) -> frame_count {
+		return write_blocks<BlockSize>(frame_idx{0}, get_frame_count(), write_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename WriteFn>
+		requires concepts::is_block_write_fn<ValueType, WriteFn>
+	auto write_blocks(frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
+		return for_each_block<BlockSize, ValueType>(*this, start, n, write_fn);
+	}
+private:
+	using page_allocator       = detail::aligned_allocator<ValueType, ALIGNMENT, 0, allocator_type>;
+	using page_table_allocator = detail::rebind_alloc_t<Policy, ValueType*>;
+	[[nodiscard]] static
+	auto get_page_count(uint64_t frame_count) -> uint64_t {
+		return (frame_count + PageSize - 1) / PageSize;
+	}
+	[[nodiscard]]
+	auto get_page_values() const -> uint64_t {
+		return channel_count_ * PageSize;
+	}
+	static
+	auto check_frame_count(const char* fn, uint64_t frame_count) -> void {
+		if (frame_count > detail::SANE_NUMBER_OF_FRAMES) {
+			throw std::underflow_error{std::format("ads::paged::{}(): Frame count {} is insane", fn, frame_count)};
+		}
+	}
+	auto reserve_pages(uint64_t page_count) -> void {
+		if (page_count <= pages_.size()) {
+			return;
+		}
+		pages_.reserve(page_count);
+		while (pages_.size() < page_count) {
+			pages_.push_back(std::allocator_traits<page_allocator>::allocate(page_alloc_, get_page_values()));
+		}
+	}
+	auto release_pages(uint64_t keep) -> void {
+		while (pages_.size() > keep) {
+			std::allocator_traits<page_allocator>::deallocate(page_alloc_, pages_.back(), get_page_values());
+			pages_.pop_back();
+		}
+	}
+	auto fill(frame_idx start, uint64_t n, ValueType value) -> void {
+		for (ads::channel_idx ch = {0}; ch < channel_count_; ch++) {
+			static_cast<void>(for_each_chunk<DYNAMIC_EXTENT>(ch, start, {n}, [value](ValueType* buffer, frame_idx, ads::frame_count chunk_frames) {
+				std::fill_n(buffer, chunk_frames.value, value);
+				return chunk_frames;
+			}));
+		}
+	}
+	template <typename Fn>
+	auto for_each_channel(const char* what, Fn fn) const -> frame_count {
+		auto frames_done = ads::frame_count{0};
+		for (ads::channel_idx ch = {0}; ch < channel_count_; ch++) {
+			const auto channel_frames_done = fn(ch);
+			if (ch.value == 0) { frames_done = channel_frames_done; }
+			else if (frames_done != channel_frames_done) {
+				throw std::runtime_error{std::format("ads::paged::{}() frame count mismatch ({} != {})", what, frames_done.value, channel_frames_done.value)};
+			}
+		}
+		return frames_done;
+	}
+	// Clamps the range to the frame count and calls fn(buffer, start, n)
+	// for each piece of it which lies within a single page. Stops early if
+	// fn returns fewer frames than it was given.
+	template <uint64_t BlockSize, typename Self, typename Fn>
+	static
+	auto for_each_chunk(Self& self, channel_idx ch, frame_idx start, ads::frame_count frame_count, Fn fn) -> ads::frame_count {
+		static_assert (BlockSize > 0, "BlockSize must be greater than zero");
+		if (start.value > static_cast<int64_t>(detail::SANE_NUMBER_OF_FRAMES)) {
+			throw std::underflow_error{std::format("ads::paged: Frame start = {} is insane", start.value)};
+		}
+		detail::check_index<typename Policy::bounds_check>("channel", ch.value, self.channel_count_);
+		if (start.value < 0 || start >= self.get_frame_count()) {
+			return {0};
+		}
+		auto pos       = static_cast<uint64_t>(start.value);
+		const auto end = pos + std::min(frame_count.value, self.frame_count_ - pos);
+		auto done      = ads::frame_count{0};
+		while (pos < end) {
+			const auto offset     = pos % PageSize;
+			const auto max_frames = BlockSize == DYNAMIC_EXTENT ? PageSize - offset : std::min(BlockSize, PageSize - offset);
+			const auto chunk      = ads::frame_count{std::min(max_frames, end - pos)};
+			const auto chunk_done = fn(self.pages_[pos / PageSize] + ch.value * PageSize + offset, frame_idx{static_cast<int64_t>(pos)}, chunk);
+			done += chunk_done;
+			if (chunk_done < chunk) {
+				break;
+			}
+			pos += chunk.value;
+		}
+		return done;
+	}
+	template <uint64_t BlockSize, typename Fn>
+	auto for_each_chunk(channel_idx ch, frame_idx start, ads::frame_count frame_count, Fn fn) const -> ads::frame_count {
+		return for_each_chunk<BlockSize>(*this, ch, start, frame_count, fn);
+	}
+	template <uint64_t BlockSize, typename Fn>
+	auto for_each_chunk(channel_idx ch, frame_idx start, ads::frame_count frame_count, Fn fn) -> ads::frame_count {
+		return for_each_chunk<BlockSize>(*this, ch, start, frame_count, fn);
+	}
+	template <uint64_t BlockSize, typename ElementType, typename Self, typename Fn>
+	static
+	auto for_each_block(Self& self, frame_idx start, ads::frame_count frame_count, Fn fn) -> ads::frame_count {
+		if (self.channel_count_ == 0) {
+			return {0};
+		}
+		detail::channel_pointers_t<ElementType*, Chs> pointers;
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			pointers.resize(self.channel_count_);
+		}
+		// Channel 0 decides where the blocks fall, and the other channels
+		// are at the same offset in the same page.
+		return for_each_chunk<BlockSize>(self, channel_idx{0}, start, frame_count, [&](ElementType* buffer, frame_idx block_start, ads::frame_count block_frames) {
+			for (uint64_t c = 0; c < pointers.size(); c++) {
+				pointers[c] = buffer + c * PageSize;
+			}
+			return fn(std::span<ElementType* const>{pointers.data(), pointers.size()}, block_start, block_frames);
+		});
+	}
+	[[no_unique_address]] page_allocator page_alloc_;
+	std::vector<ValueType*, page_table_allocator> pages_;
+	uint64_t channel_count_ = Chs == DYNAMIC_EXTENT ? 0 : Chs;
+	uint64_t frame_count_   = 0;
+};
+
+} // namespace ads
@@ -0,0 +1,394 @@
+#pragma once
+
+#include "ads.hpp"
+#include "ads-simd.hpp"
+#include <numbers>
+
+namespace ads {
+
+// Trades speed for a flatter passband and a deeper stopband. The tap
+// counts are for upsampling, and grow in proportion to the ratio when
+// downsampling so that the transition band stays as steep.
+enum class resample_quality {
+	fast,   // 16 taps, passband up to 85% of Nyquist
+	medium, // 32 taps, 90%
+	high,   // 64 taps, 94%
+	best,   // 128 taps, 97%
+};
+
+namespace detail::resample {
+
+// The reduced ratio out_rate / in_rate can't have a numerator larger than
+// this, because each step of the numerator needs its own filter phase.
+// All of the common audio sample rates convert with far fewer.
+static constexpr uint64_t MAX_PHASES = 4096;
+// Output frames per task when resampling in parallel.
+static constexpr uint64_t TASK_SIZE = 16384;
+
+struct quality_params {
+	uint64_t half_taps;
+	double rolloff;
+	double kaiser_beta;
+};
+
+[[nodiscard]] constexpr
+auto get_quality_params(resample_quality quality) -> quality_params {
+	switch (quality) {
+		case resample_quality::fast:   { return {8, 0.85, 6.0}; }
+		case resample_quality::medium: { return {16, 0.90, 8.0}; }
+		case resample_quality::high:   { return {32, 0.94, 10.0}; }
+		case resample_quality::best:   { return {64, 0.97, 12.0}; }
+	}
+	throw std::invalid_argument{std::format("ads::resample(): Unknown quality {}", static_cast<int>(quality))};
+}
+
+// The zeroth order modified Bessel function of the first kind, for the
+// Kaiser window.
+[[nodiscard]] inline
+auto bessel_i0(double x) -> double {
+	auto sum  = 1.0;
+	auto term = 1.0;
+	for (int k = 1; k < 100 && term > sum * 1e-17; k++) {
+		const auto half_x_over_k = x / (2.0 * k);
+		term *= half_x_over_k * half_x_over_k;
+		sum  += term;
+	}
+	return sum;
+}
+
+// A Kaiser-windowed sinc lowpass filter, split into one row of
+// coefficients per phase. Output frames fall at multiples of down / up
+// input frames, so only up different fractional positions ever occur
+// and each one has its own row. Output frame n is centred on input
+// position n * down / up, reading the frames from `before` frames before
+// it to `after` frames after it. Rows are padded with zeros to a
+// multiple of 8 taps for the SIMD kernels.
+template <typename ValueType>
+class filter {
+public:
+	filter(uint64_t in_rate, uint64_t out_rate, resample_quality quality) {
+		if (in_rate == 0 || out_rate == 0) {
+			throw std::invalid_argument{std::format("ads::resample(): Sample rates must be greater than zero ({} -> {})", in_rate, out_rate)};
+		}
+		const auto divisor = std::gcd(in_rate, out_rate);
+		up_   = out_rate / divisor;
+		down_ = in_rate / divisor;
+		if (up_ > MAX_PHASES) {
+			throw std::invalid_argument{std::format("ads::resample(): Converting {} to {} needs {} filter phases (the maximum is {})", in_rate, out_rate, up_, MAX_PHASES)};
+		}
+		const auto params = get_quality_params(quality);
+		const auto scale  = std::min(1.0, static_cast<double>(up_) / static_cast<double>(down_));
+		const auto cutoff = params.rolloff * scale;
+		const auto i0     = bessel_i0(params.kaiser_beta);
+		half_ = static_cast<uint64_t>(std::ceil(static_cast<double>(params.half_taps) / scale));
+		taps_ = round_up(2 * half_, 8);
+		coefficients_.resize(up_ * taps_);
+		std::vector<double> row(2 * half_);
+		for (uint64_t p = 0; p < up_; p++) {
+			const auto frac = static_cast<double>(p) / static_cast<double>(up_);
+			auto sum = 0.0;
+			for (uint64_t j = 0; j < row.size(); j++) {
+				const auto d      = static_cast<double>(j) - static_cast<double>(half_ - 1) - frac;
+				const auto x      = std::numbers::pi * cutoff * d;
+				const auto r      = d / static_cast<double>(half_);
+				const auto sinc   = d == 0.0 ? 1.0 : std::sin(x) / x;
+				const auto window = r * r < 1.0 ? bessel_i0(params.kaiser_beta * std::sqrt(1.0 - r * r)) / i0 : 0.0;
+				row[j] = sinc * window;
+				sum   += row[j];
+			}
+			// Each phase passes DC unchanged.
+			for (uint64_t j = 0; j < row.size(); j++) {
+				coefficients_[p * taps_ + j] = static_cast<ValueType>(row[j] / sum);
+			}
+		}
+	}
+	[[nodiscard]] auto get_up() const -> uint64_t                   { return up_; }
+	[[nodiscard]] auto get_down() const -> uint64_t                 { return down_; }
+	[[nodiscard]] auto get_taps() const -> uint64_t                 { return taps_; }
+	[[nodiscard]] auto get_before() const -> uint64_t               { return half_ - 1; }
+	[[nodiscard]] auto get_after() const -> uint64_t                { return taps_ - half_; }
+	[[nodiscard]] auto get_row(uint64_t phase) const -> const ValueType* { return coefficients_.data() + phase * taps_; }
+	// The number of output frames which correspond to frame_count input
+	// frames.
+	[[nodiscard]]
+	auto get_output_frame_count(uint64_t frame_count) const -> uint64_t {
+		return (frame_count * up_ + down_ - 1) / down_;
+	}
+private:
+	uint64_t up_   = 1;
+	uint64_t down_ = 1;
+	uint64_t half_ = 1;
+	uint64_t taps_ = 8;
+	std::vector<ValueType, aligned_allocator<ValueType, 32, 0, std::allocator<std::byte>>> coefficients_;
+};
+
+// Each SIMD kernel computes count outputs, the first at position pos in
+// units of 1 / up input frames and each one down units after the last.
+// Every tap must be inside x.
+
+#if defined(ADS_SSE2)
+inline auto convolve_sse(const filter<float>& f, const float* x, uint64_t pos, uint64_t count, float* out) -> uint64_t {
+	const auto up     = f.get_up();
+	const auto down   = f.get_down();
+	const auto taps   = f.get_taps();
+	const auto before = f.get_before();
+	for (uint64_t k = 0; k < count; k++, pos += down) {
+		const auto h = f.get_row(pos % up);
+		const auto s = x + pos / up - before;
+		auto acc0 = _mm_setzero_ps();
+		auto acc1 = _mm_setzero_ps();
+		for (uint64_t j = 0; j < taps; j += 8) {
+			acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(s + j), _mm_load_ps(h + j)));
+			acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(s + j + 4), _mm_load_ps(h + j + 4)));
+		}
+		const auto acc = _mm_add_ps(acc0, acc1);
+		const auto hi  = _mm_movehl_ps(acc, acc);
+		const auto sum = _mm_add_ps(acc, hi);
+		out[k] = _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1)));
+	}
+	return count;
+}
+#endif // ADS_SSE2
+
+#if defined(ADS_AVX2_DISPATCH)
+ADS_TARGET_AVX2 inline auto convolve_avx2(const filter<float>& f, const float* x, uint64_t pos, uint64_t count, float* out) -> uint64_t {
+	const auto up     = f.get_up();
+	const auto down   = f.get_down();
+	const auto taps   = f.get_taps();
+	const auto before = f.get_before();
+	for (uint64_t k = 0; k < count; k++, pos += down) {
+		const auto h = f.get_row(pos % up);
+		const auto s = x + pos / up - before;
+		auto acc = _mm256_setzero_ps();
+		for (uint64_t j = 0; j < taps; j += 8) {
+			acc = _mm256_fmadd_ps(_mm256_loadu_ps(s + j), _mm256_load_ps(h + j), acc);
+		}
+		const auto quad = _mm_add_ps(_mm256_castps256_ps128(acc), _mm256_extractf128_ps(acc, 1));
+		const auto hi   = _mm_movehl_ps(quad, quad);
+		const auto sum  = _mm_add_ps(quad, hi);
+		out[k] = _mm_cvtss_f32(_mm_add_ss(sum, _mm_shuffle_ps(sum, sum, 1)));
+	}
+	return count;
+}
+#endif // ADS_AVX2_DISPATCH
+
+template <typename ValueType>
+auto convolve(const filter<ValueType>& f, const ValueType* x, uint64_t pos, uint64_t count, ValueType* out) -> void {
+	uint64_t k = 0;
+	if constexpr (std::is_same_v<ValueType, float>) {
+#if defined(ADS_AVX2_DISPATCH)
+		k = simd::has_avx2() ? convolve_avx2(f, x, pos, count, out) : convolve_sse(f, x, pos, count, out);
+#elif defined(ADS_SSE2)
+		k = convolve_sse(f, x, pos, count, out);
+#endif
+	}
+	pos += k * f.get_down();
+	for (; k < count; k++, pos += f.get_down()) {
+		const auto h = f.get_row(pos % f.get_up());
+		const auto s = x + pos / f.get_up() - f.get_before();
+		auto sum = ValueType(0);
+		for (uint64_t j = 0; j < f.get_taps(); j++) {
+			sum += s[j] * h[j];
+		}
+		out[k] = sum;
+	}
+}
+
+// The same as convolve() but for positions near the ends of x, where
+// frames outside it read as zero.
+template <typename ValueType>
+auto convolve_checked(const filter<ValueType>& f, const ValueType* x, uint64_t frame_count, uint64_t pos, uint64_t count, ValueType* out) -> void {
+	for (uint64_t k = 0; k < count; k++, pos += f.get_down()) {
+		const auto h     = f.get_row(pos % f.get_up());
+		const auto first = static_cast<int64_t>(pos / f.get_up()) - static_cast<int64_t>(f.get_before());
+		auto sum = ValueType(0);
+		for (uint64_t j = 0; j < f.get_taps(); j++) {
+			const auto i = first + static_cast<int64_t>(j);
+			if (i >= 0 && i < static_cast<int64_t>(frame_count)) {
+				sum += x[i] * h[j];
+			}
+		}
+		out[k] = sum;
+	}
+}
+
+// Writes output frames [start, start + count) of a whole channel of
+// frame_count input frames. Only the outputs whose taps reach past
+// either end take the checked path.
+template <typename ValueType>
+auto render(const filter<ValueType>& f, const ValueType* x, uint64_t frame_count, uint64_t start, uint64_t count, ValueType* out) -> void {
+	const auto up   = f.get_up();
+	const auto down = f.get_down();
+	const auto end  = start + count;
+	// Output n is safe if before <= n * down / up and
+	// n * down / up + after < frame_count.
+	const auto safe_beg = std::clamp((f.get_before() * up + down - 1) / down, start, end);
+	const auto safe_end = frame_count > f.get_after() ? std::clamp(((frame_count - f.get_after()) * up + down - 1) / down, safe_beg, end) : safe_beg;
+	convolve_checked(f, x, frame_count, start * down, safe_beg - start, out);
+	convolve(f, x, safe_beg * down, safe_end - safe_beg, out + (safe_beg - start));
+	convolve_checked(f, x, frame_count, safe_end * down, end - safe_end, out + (safe_end - start));
+}
+
+template <typename Dest, typename Src>
+auto check_channel_counts(const char* fn, const Dest& dest, const Src& src) -> void {
+	if (dest.get_channel_count() != src.get_channel_count()) {
+		throw std::invalid_argument{std::format("ads::{}(): Channel count mismatch ({} != {})", fn, src.get_channel_count().value, dest.get_channel_count().value)};
+	}
+}
+
+} // namespace detail::resample
+
+// The number of frames resample() produces from frame_count frames.
+[[nodiscard]] inline
+auto get_resampled_frame_count(ads::frame_count frame_count, uint64_t in_rate, uint64_t out_rate) -> ads::frame_count {
+	if (in_rate == 0 || out_rate == 0) {
+		throw std::invalid_argument{std::format("ads::get_resampled_frame_count(): Sample rates must be greater than zero ({} -> {})", in_rate, out_rate)};
+	}
+	const auto divisor = std::gcd(in_rate, out_rate);
+	return {(frame_count.value * (out_rate / divisor) + in_rate / divisor - 1) / (in_rate / divisor)};
+}
+
+// Converts the whole of src from in_rate to out_rate. Channels are split
+// into chunks which are shared out between thread_count threads
+// (including the calling thread.) A thread_count of zero means one per
+// hardware thread. The SIMD implementation is for float, and uses AVX2
+// if the CPU supports it.
+template <typename Src>
+	requires concepts::is_channel_data<Src>
+[[nodiscard]]
+auto resample(const Src& src, uint64_t in_rate, uint64_t out_rate, resample_quality quality = resample_quality::high, unsigned thread_count = 1) -> data<concepts::channel_value_t<Src>, DYNAMIC_EXTENT, DYNAMIC_EXTENT> {
+	using value_type = concepts::channel_value_t<Src>;
+	const auto f             = detail::resample::filter<value_type>{in_rate, out_rate, quality};
+	const auto channel_count = src.get_channel_count();
+	const auto in_frames     = src.get_frame_count().value;
+	const auto out_frames    = f.get_output_frame_count(in_frames);
+	auto out = make_uninitialized<value_type>(channel_count, ads::frame_count{out_frames});
+	detail::channel_pointers_t<const value_type*, DYNAMIC_EXTENT> in_channels;
+	detail::channel_pointers_t<value_type*, DYNAMIC_EXTENT> out_channels;
+	for (ads::channel_idx ch = {0}; ch < channel_count; ch++) {
+		in_channels.push_back(src.data(ch));
+		out_channels.push_back(out.data(ch));
+	}
+	const auto channel_tasks = (out_frames + detail::resample::TASK_SIZE - 1) / detail::resample::TASK_SIZE;
+	detail::parallel_for(channel_count.value * channel_tasks, thread_count, [&](uint64_t task) {
+		const auto ch    = task / channel_tasks;
+		const auto start = (task % channel_tasks) * detail::resample::TASK_SIZE;
+		const auto count = std::min(detail::resample::TASK_SIZE, out_frames - start);
+		detail::resample::render(f, in_channels[ch], in_frames, start, count, out_channels[ch] + start);
+	});
+	return out;
+}
+
+// Converts a stream from in_rate to out_rate one block at a time. The
+// output matches what resample() would produce for the whole stream, up
+// to rounding.
+// Only allocates when a block is bigger than any block before it.
+template <typename ValueType = float>
+class resampler {
+public:
+	resampler(ads::channel_count channel_count, uint64_t in_rate, uint64_t out_rate, resample_quality quality = resample_quality::high)
+		: filter_{in_rate, out_rate, quality}
+		, buffer_{make<ValueType>(channel_count, ads::frame_count{0})}
+	{
+		reset();
+	}
+	[[nodiscard]] auto get_channel_count() const -> channel_count { return buffer_.get_channel_count(); }
+	// Input frames which are needed after an input frame before the output
+	// frames up to it can be written.
+	[[nodiscard]] auto get_latency() const -> frame_count { return {filter_.get_after()}; }
+	// Output frames which are ready but haven't been written yet, because
+	// they didn't fit in dest.
+	[[nodiscard]]
+	auto get_pending_frame_count() const -> frame_count {
+		return {get_ready_frame_count()};
+	}
+	// Takes all of src, then writes as many output frames to the start of
+	// dest as are ready and fit, and returns the number written.
+	template <typename Src, typename Dest>
+		requires concepts::is_channel_data<Src> && concepts::is_mutable_channel_data<Dest> &&
+		         std::same_as<concepts::channel_value_t<Src>, ValueType> && std::same_as<concepts::channel_value_t<Dest>, ValueType>
+	auto process(const Src& src, Dest&& dest) -> frame_count {
+		detail::resample::check_channel_counts("resampler::process", buffer_, src);
+		detail::resample::check_channel_counts("resampler::process", buffer_, dest);
+		if (flushing_) {
+			throw std::logic_error{"ads::resampler::process(): Called after flush() without reset()"};
+		}
+		const auto offset = buffer_.get_frame_count().value;
+		const auto n      = src.get_frame_count().value;
+		buffer_.resize_uninitialized(ads::frame_count{offset + n});
+		for (ads::channel_idx ch = {0}; ch < get_channel_count(); ch++) {
+			std::copy_n(src.data(ch), n, buffer_.data(ch) + offset);
+		}
+		frames_in_ += n;
+		return write(dest);
+	}
+	// Ends the stream, and writes the remaining output frames to dest,
+	// as many as fit. Returns the number written, which is zero once they
+	// have all been written. Call reset() to start a new stream.
+	template <typename Dest>
+		requires concepts::is_mutable_channel_data<Dest> && std::same_as<concepts::channel_value_t<Dest>, ValueType>
+	auto flush(Dest&& dest) -> frame_count {
+		detail::resample::check_channel_counts("resampler::flush", buffer_, dest);
+		if (!flushing_) {
+			buffer_.resize(ads::frame_count{buffer_.get_frame_count().value + filter_.get_after()});
+			flushing_ = true;
+		}
+		return write(dest);
+	}
+	auto reset() -> void {
+		buffer_.resize(ads::frame_count{filter_.get_before()});
+		buffer_.fill(ValueType(0));
+		pos_        = filter_.get_before() * filter_.get_up();
+		frames_in_  = 0;
+		frames_out_ = 0;
+		flushing_   = false;
+	}
+private:
+	// The number of outputs whose taps are all in the buffer. Once the
+	// stream has ended, the padding after the last input frame doesn't
+	// produce any more.
+	[[nodiscard]]
+	auto get_ready_frame_count() const -> uint64_t {
+		const auto buffered = buffer_.get_frame_count().value;
+		if (buffered <= filter_.get_after()) {
+			return 0;
+		}
+		const auto end = (buffered - filter_.get_after()) * filter_.get_up();
+		const auto n   = end > pos_ ? (end - pos_ + filter_.get_down() - 1) / filter_.get_down() : 0;
+		if (flushing_) {
+			return std::min(n, filter_.get_output_frame_count(frames_in_) - frames_out_);
+		}
+		return n;
+	}
+	template <typename Dest>
+	auto write(Dest& dest) -> frame_count {
+		const auto n = std::min(get_ready_frame_count(), dest.get_frame_count().value);
+		for (ads::channel_idx ch = {0}; ch < get_channel_count(); ch++) {
+			detail::resample::convolve(filter_, std::as_const(buffer_).data(ch), pos_, n, dest.data(ch));
+		}
+		pos_        += n * filter_.get_down();
+		frames_out_ += n;
+		// Drop the frames which no output reads any more.
+		const auto drop = pos_ / filter_.get_up() - filter_.get_before();
+		if (drop > 0) {
+			const auto keep = buffer_.get_frame_count().value - drop;
+			for (ads::channel_idx ch = {0}; ch < get_channel_count(); ch++) {
+				const auto channel = buffer_.data(ch);
+				std::copy(channel + drop, channel + drop + keep, channel);
+			}
+			buffer_.resize(ads::frame_count{keep});
+			pos_ -= drop * filter_.get_up();
+		}
+		return {n};
+	}
+	detail::resample::filter<ValueType> filter_;
+	data<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT> buffer_;
+	// The position of the next output frame in the buffer, in units of
+	// 1 / up input frames.
+	uint64_t pos_        = 0;
+	uint64_t frames_in_  = 0;
+	uint64_t frames_out_ = 0;
+	bool flushing_       = false;
+};
+
+} // namespace ads
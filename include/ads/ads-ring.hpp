@@ -0,0 +1,184 @@
+#pragma once
+
+#include "ads.hpp"
+
+namespace ads {
+
+// A lock-free single-producer, single-consumer ring buffer of
+// multichannel audio. Chs and Frs have the same meaning as for
+// ads::data, with Frs being the capacity. One thread may write while
+// another reads, and neither ever allocates, locks or waits.
+//
+// write() and read() take the same callbacks as ads::data, with the
+// frame start relative to the beginning of the transfer. A transfer
+// which crosses the end of the buffer is passed to the callback in two
+// contiguous pieces, and it stops early if a callback returns fewer
+// frames than it was given.
+template <typename ValueType, uint64_t Chs = DYNAMIC_EXTENT, uint64_t Frs = DYNAMIC_EXTENT, typename Policy = default_policy>
+class ring_buffer {
+public:
+	using value_type   = ValueType;
+	using storage_type = data<ValueType, Chs, Frs, Policy>;
+	ring_buffer() requires (Chs != DYNAMIC_EXTENT && Frs != DYNAMIC_EXTENT)
+		: ring_buffer{storage_type{}}
+	{}
+	explicit ring_buffer(ads::frame_count capacity) requires (Chs != DYNAMIC_EXTENT && Frs == DYNAMIC_EXTENT)
+		: ring_buffer{make<ValueType, Chs, Policy>(capacity)}
+	{}
+	explicit ring_buffer(ads::channel_count channel_count) requires (Chs == DYNAMIC_EXTENT && Frs != DYNAMIC_EXTENT)
+		: ring_buffer{make<ValueType, Frs, Policy>(channel_count)}
+	{}
+	ring_buffer(ads::channel_count channel_count, ads::frame_count capacity) requires (Chs == DYNAMIC_EXTENT && Frs == DYNAMIC_EXTENT)
+		: ring_buffer{make<ValueType, Policy>(channel_count, capacity)}
+	{}
+	ring_buffer(const ring_buffer&) = delete;
+	auto operator=(const ring_buffer&) -> ring_buffer& = delete;
+	[[nodiscard]] auto get_channel_count() const -> channel_count { return data_.get_channel_count(); }
+	[[nodiscard]] auto get_capacity() const -> frame_count        { return {capacity_}; }
+	// Frames which can be read. Exact when called from the consumer, and
+	// a lower bound from the producer.
+	[[nodiscard]]
+	auto get_read_available() const -> frame_count {
+		return {write_pos_.load(std::memory_order_acquire) - read_pos_.load(std::memory_order_acquire)};
+	}
+	// Frames which can be written. Exact when called from the producer,
+	// and a lower bound from the consumer.
+	[[nodiscard]]
+	auto get_write_available() const -> frame_count {
+		return {capacity_ - (write_pos_.load(std::memory_order_acquire) - read_pos_.load(std::memory_order_acquire))};
+	}
+	// Empties the buffer. Neither thread may be using it at the time.
+	auto reset() -> void {
+		write_pos_.store(0, std::memory_order_relaxed);
+		read_pos_.store(0, std::memory_order_relaxed);
+	}
+	// Producer only. Writes at most n frames, or as many as there is room
+	// for, and returns the number of frames written.
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn> || concepts::is_block_write_fn<ValueType, WriteFn>
+	auto write(ads::frame_count n, WriteFn write_fn) -> frame_count {
+		const auto pos  = write_pos_.load(std::memory_order_relaxed);
+		const auto free = capacity_ - (pos - read_pos_.load(std::memory_order_acquire));
+		const auto done = transfer(write_pointers_, pos, std::min(n.value, free), write_fn);
+		write_pos_.store(pos + done.value, std::memory_order_release);
+		return done;
+	}
+	// Producer only. Writes as many frames of src as there is room for.
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Src>, ValueType>
+	auto write(const Src& src) -> frame_count {
+		check_channel_count("write", src.get_channel_count());
+		return write(src.get_frame_count(), [&src](std::span<ValueType* const> channels, frame_idx start, ads::frame_count n) {
+			for (ads::channel_idx ch = {0}; ch < channels.size(); ch++) {
+				std::copy_n(src.data(ch) + start.value, n.value, channels[ch.value]);
+			}
+			return n;
+		});
+	}
+	// Consumer only. Reads at most n frames, or as many as are available,
+	// and returns the number of frames read.
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn> || concepts::is_block_read_fn<ValueType, ReadFn>
+	auto read(ads::frame_count n, ReadFn read_fn) -> frame_count {
+		const auto pos       = read_pos_.load(std::memory_order_relaxed);
+		const auto available = write_pos_.load(std::memory_order_acquire) - pos;
+		const auto done      = transfer(read_pointers_, pos, std::min(n.value, available), read_fn);
+		read_pos_.store(pos + done.value, std::memory_order_release);
+		return done;
+	}
+	// Consumer only. Reads as many frames into dest as are available.
+	template <typename Dest>
+		requires concepts::is_mutable_channel_data<Dest> && std::same_as<concepts::channel_value_t<Dest>, ValueType>
+	auto read(Dest&& dest) -> frame_count {
+		check_channel_count("read", dest.get_channel_count());
+		return read(dest.get_frame_count(), [&dest](std::span<const ValueType* const> channels, frame_idx start, ads::frame_count n) {
+			for (ads::channel_idx ch = {0}; ch < channels.size(); ch++) {
+				std::copy_n(channels[ch.value], n.value, dest.data(ch) + start.value);
+			}
+			return n;
+		});
+	}
+	// Consumer only. Discards at most n frames and returns the number of
+	// frames discarded.
+	auto skip(ads::frame_count n) -> frame_count {
+		const auto pos  = read_pos_.load(std::memory_order_relaxed);
+		const auto done = std::min(n.value, write_pos_.load(std::memory_order_acquire) - pos);
+		read_pos_.store(pos + done, std::memory_order_release);
+		return {done};
+	}
+private:
+	template <typename Pointer> using pointers_t = detail::channel_pointers_t<Pointer, Chs>;
+	explicit ring_buffer(storage_type&& data)
+		: data_{std::move(data)}
+		, capacity_{data_.get_frame_count().value}
+		, write_pointers_{make_pointers<ValueType*>(data_)}
+		, read_pointers_{make_pointers<const ValueType*>(data_)}
+		, base_pointers_{make_pointers<ValueType*>(data_)}
+	{}
+	template <typename Pointer> [[nodiscard]] static
+	auto make_pointers(storage_type& data) -> pointers_t<Pointer> {
+		pointers_t<Pointer> pointers;
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			pointers.resize(data.get_channel_count().value);
+		}
+		for (ads::channel_idx ch = {0}; ch < data.get_channel_count(); ch++) {
+			pointers[ch.value] = data.data(ch);
+		}
+		return pointers;
+	}
+	auto check_channel_count(const char* fn, ads::channel_count channel_count) const -> void {
+		if (channel_count != get_channel_count()) {
+			throw std::invalid_argument{std::format("ads::ring_buffer::{}(): Channel count mismatch ({} != {})", fn, channel_count.value, get_channel_count().value)};
+		}
+	}
+	// Calls fn for the part of [pos, pos + n) before the end of the buffer
+	// and then for the part after it. pointers is scratch space belonging
+	// to the calling thread.
+	template <typename Pointers, typename Fn>
+	auto transfer(Pointers& pointers, uint64_t pos, uint64_t n, Fn fn) -> frame_count {
+		if (n == 0) {
+			return {0};
+		}
+		const auto offset = pos % capacity_;
+		const auto first  = std::min(n, capacity_ - offset);
+		const auto done   = transfer_part(pointers, offset, frame_idx{0}, {first}, fn);
+		if (done.value < first || first == n) {
+			return done;
+		}
+		return done + transfer_part(pointers, 0, frame_idx{static_cast<int64_t>(first)}, {n - first}, fn);
+	}
+	template <typename Pointers, typename Fn>
+	auto transfer_part(Pointers& pointers, uint64_t offset, frame_idx start, ads::frame_count n, Fn& fn) -> frame_count {
+		for (size_t c = 0; c < pointers.size(); c++) {
+			pointers[c] = base_pointers_[c] + offset;
+		}
+		if constexpr (concepts::is_block_read_fn<ValueType, Fn> || concepts::is_block_write_fn<ValueType, Fn>) {
+			return fn(std::span<typename Pointers::value_type const>{pointers.data(), pointers.size()}, start, n);
+		}
+		else {
+			auto frames_done = ads::frame_count{0};
+			for (ads::channel_idx ch = {0}; ch < pointers.size(); ch++) {
+				ads::frame_count channel_frames_done;
+				if constexpr (concepts::is_single_channel_read_fn<ValueType, Fn> || concepts::is_single_channel_write_fn<ValueType, Fn>) { channel_frames_done = fn(pointers[ch.value], start, n); }
+				else                                                                                                                    { channel_frames_done = fn(pointers[ch.value], ch, start, n); }
+				if (ch.value == 0) { frames_done = channel_frames_done; }
+				else if (frames_done != channel_frames_done) {
+					throw std::runtime_error{std::format("ads::ring_buffer: Frame count mismatch ({} != {})", frames_done.value, channel_frames_done.value)};
+				}
+			}
+			return frames_done;
+		}
+	}
+	storage_type data_;
+	uint64_t capacity_;
+	pointers_t<ValueType*> write_pointers_;
+	pointers_t<const ValueType*> read_pointers_;
+	pointers_t<ValueType*> base_pointers_;
+	// Frames written and read since the buffer was created or reset. Each
+	// is only stored by one thread, and they are kept on separate cache
+	// lines so that the two threads don't contend.
+	alignas(64) std::atomic<uint64_t> write_pos_ = 0;
+	alignas(64) std::atomic<uint64_t> read_pos_  = 0;
+};
+
+} // namespace ads
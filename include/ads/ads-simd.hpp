@@ -0,0 +1,330 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define ADS_SSE2 1
+#	include <immintrin.h>
+#endif
+#if defined(ADS_SSE2) && defined(__AVX__)
+#	define ADS_AVX 1
+#endif
+#if defined(ADS_SSE2) && defined(__AVX2__) && defined(__FMA__)
+#	define ADS_AVX2 1
+#endif
+
+// Kernels marked ADS_TARGET_AVX2 are compiled for AVX2 and FMA whatever
+// the project's target, and are only called if has_avx2() says the CPU
+// supports them. MSVC doesn't need the attribute to use the intrinsics.
+#if defined(ADS_SSE2) && (defined(__GNUC__) || defined(__clang__) || defined(_MSC_VER))
+#	define ADS_AVX2_DISPATCH 1
+#	if defined(_MSC_VER) && !defined(__clang__)
+#		include <intrin.h>
+#		define ADS_TARGET_AVX2
+#	else
+#		define ADS_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#	endif
+#endif
+
+namespace ads::detail::simd {
+
+#if defined(ADS_AVX2_DISPATCH)
+[[nodiscard]] inline
+auto detect_avx2() -> bool {
+#	if defined(ADS_AVX2)
+	return true;
+#	elif defined(_MSC_VER) && !defined(__clang__)
+	int info[4];
+	__cpuid(info, 0);
+	if (info[0] < 7) { return false; }
+	__cpuid(info, 1);
+	const auto fma     = (info[2] & (1 << 12)) != 0;
+	const auto osxsave = (info[2] & (1 << 27)) != 0;
+	const auto avx     = (info[2] & (1 << 28)) != 0;
+	if (!fma || !osxsave || !avx || (_xgetbv(0) & 6) != 6) { return false; }
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#	else
+	return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#	endif
+}
+
+[[nodiscard]] inline
+auto has_avx2() -> bool {
+	static const auto result = detect_avx2();
+	return result;
+}
+#endif
+
+// Shuffle kernels for converting between separate channel buffers and
+// interleaved frames. Each kernel handles as many whole blocks of
+// frames as it can and returns the number of frames it processed, and
+// the caller is responsible for the remainder. These are selected at
+// compile time, so the AVX paths are only used if the project is built
+// with AVX enabled.
+
+#if defined(ADS_SSE2)
+
+inline auto transpose4(__m128& r0, __m128& r1, __m128& r2, __m128& r3) -> void {
+	_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+}
+
+inline auto interleave2(const float* const* in, uint64_t frames, float* out) -> uint64_t {
+	const auto c0 = in[0];
+	const auto c1 = in[1];
+	uint64_t f = 0;
+#	if defined(ADS_AVX)
+	for (; f + 8 <= frames; f += 8) {
+		const auto a  = _mm256_loadu_ps(c0 + f);
+		const auto b  = _mm256_loadu_ps(c1 + f);
+		const auto lo = _mm256_unpacklo_ps(a, b);
+		const auto hi = _mm256_unpackhi_ps(a, b);
+		_mm256_storeu_ps(out + f * 2, _mm256_permute2f128_ps(lo, hi, 0x20));
+		_mm256_storeu_ps(out + f * 2 + 8, _mm256_permute2f128_ps(lo, hi, 0x31));
+	}
+#	endif
+	for (; f + 4 <= frames; f += 4) {
+		const auto a = _mm_loadu_ps(c0 + f);
+		const auto b = _mm_loadu_ps(c1 + f);
+		_mm_storeu_ps(out + f * 2, _mm_unpacklo_ps(a, b));
+		_mm_storeu_ps(out + f * 2 + 4, _mm_unpackhi_ps(a, b));
+	}
+	return f;
+}
+
+inline auto deinterleave2(const float* in, uint64_t frames, float* const* out) -> uint64_t {
+	const auto c0 = out[0];
+	const auto c1 = out[1];
+	uint64_t f = 0;
+#	if defined(ADS_AVX)
+	for (; f + 8 <= frames; f += 8) {
+		const auto a  = _mm256_loadu_ps(in + f * 2);
+		const auto b  = _mm256_loadu_ps(in + f * 2 + 8);
+		const auto lo = _mm256_permute2f128_ps(a, b, 0x20);
+		const auto hi = _mm256_permute2f128_ps(a, b, 0x31);
+		_mm256_storeu_ps(c0 + f, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm256_storeu_ps(c1 + f, _mm256_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+#	endif
+	for (; f + 4 <= frames; f += 4) {
+		const auto a = _mm_loadu_ps(in + f * 2);
+		const auto b = _mm_loadu_ps(in + f * 2 + 4);
+		_mm_storeu_ps(c0 + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(c1 + f, _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+	return f;
+}
+
+inline auto interleave4(const float* const* in, uint64_t frames, float* out) -> uint64_t {
+	uint64_t f = 0;
+	for (; f + 4 <= frames; f += 4) {
+		auto r0 = _mm_loadu_ps(in[0] + f);
+		auto r1 = _mm_loadu_ps(in[1] + f);
+		auto r2 = _mm_loadu_ps(in[2] + f);
+		auto r3 = _mm_loadu_ps(in[3] + f);
+		transpose4(r0, r1, r2, r3);
+		_mm_storeu_ps(out + f * 4, r0);
+		_mm_storeu_ps(out + f * 4 + 4, r1);
+		_mm_storeu_ps(out + f * 4 + 8, r2);
+		_mm_storeu_ps(out + f * 4 + 12, r3);
+	}
+	return f;
+}
+
+inline auto deinterleave4(const float* in, uint64_t frames, float* const* out) -> uint64_t {
+	uint64_t f = 0;
+	for (; f + 4 <= frames; f += 4) {
+		auto r0 = _mm_loadu_ps(in + f * 4);
+		auto r1 = _mm_loadu_ps(in + f * 4 + 4);
+		auto r2 = _mm_loadu_ps(in + f * 4 + 8);
+		auto r3 = _mm_loadu_ps(in + f * 4 + 12);
+		transpose4(r0, r1, r2, r3);
+		_mm_storeu_ps(out[0] + f, r0);
+		_mm_storeu_ps(out[1] + f, r1);
+		_mm_storeu_ps(out[2] + f, r2);
+		_mm_storeu_ps(out[3] + f, r3);
+	}
+	return f;
+}
+
+// 6 channels are a 4x4 transpose of the first four channels plus pairs
+// of the last two.
+inline auto interleave6(const float* const* in, uint64_t frames, float* out) -> uint64_t {
+	uint64_t f = 0;
+	for (; f + 4 <= frames; f += 4) {
+		auto r0 = _mm_loadu_ps(in[0] + f);
+		auto r1 = _mm_loadu_ps(in[1] + f);
+		auto r2 = _mm_loadu_ps(in[2] + f);
+		auto r3 = _mm_loadu_ps(in[3] + f);
+		const auto c4 = _mm_loadu_ps(in[4] + f);
+		const auto c5 = _mm_loadu_ps(in[5] + f);
+		transpose4(r0, r1, r2, r3);
+		const auto lo = _mm_unpacklo_ps(c4, c5);
+		const auto hi = _mm_unpackhi_ps(c4, c5);
+		const auto dest = out + f * 6;
+		_mm_storeu_ps(dest, r0);
+		_mm_storel_pi(reinterpret_cast<__m64*>(dest + 4), lo);
+		_mm_storeu_ps(dest + 6, r1);
+		_mm_storeh_pi(reinterpret_cast<__m64*>(dest + 10), lo);
+		_mm_storeu_ps(dest + 12, r2);
+		_mm_storel_pi(reinterpret_cast<__m64*>(dest + 16), hi);
+		_mm_storeu_ps(dest + 18, r3);
+		_mm_storeh_pi(reinterpret_cast<__m64*>(dest + 22), hi);
+	}
+	return f;
+}
+
+inline auto deinterleave6(const float* in, uint64_t frames, float* const* out) -> uint64_t {
+	uint64_t f = 0;
+	for (; f + 4 <= frames; f += 4) {
+		const auto src = in + f * 6;
+		auto r0 = _mm_loadu_ps(src);
+		auto r1 = _mm_loadu_ps(src + 6);
+		auto r2 = _mm_loadu_ps(src + 12);
+		auto r3 = _mm_loadu_ps(src + 18);
+		transpose4(r0, r1, r2, r3);
+		auto lo = _mm_setzero_ps();
+		auto hi = _mm_setzero_ps();
+		lo = _mm_loadl_pi(lo, reinterpret_cast<const __m64*>(src + 4));
+		lo = _mm_loadh_pi(lo, reinterpret_cast<const __m64*>(src + 10));
+		hi = _mm_loadl_pi(hi, reinterpret_cast<const __m64*>(src + 16));
+		hi = _mm_loadh_pi(hi, reinterpret_cast<const __m64*>(src + 22));
+		_mm_storeu_ps(out[0] + f, r0);
+		_mm_storeu_ps(out[1] + f, r1);
+		_mm_storeu_ps(out[2] + f, r2);
+		_mm_storeu_ps(out[3] + f, r3);
+		_mm_storeu_ps(out[4] + f, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(2, 0, 2, 0)));
+		_mm_storeu_ps(out[5] + f, _mm_shuffle_ps(lo, hi, _MM_SHUFFLE(3, 1, 3, 1)));
+	}
+	return f;
+}
+
+#	if defined(ADS_AVX)
+inline auto transpose8(__m256 (&r)[8]) -> void {
+	const auto t0 = _mm256_unpacklo_ps(r[0], r[1]);
+	const auto t1 = _mm256_unpackhi_ps(r[0], r[1]);
+	const auto t2 = _mm256_unpacklo_ps(r[2], r[3]);
+	const auto t3 = _mm256_unpackhi_ps(r[2], r[3]);
+	const auto t4 = _mm256_unpacklo_ps(r[4], r[5]);
+	const auto t5 = _mm256_unpackhi_ps(r[4], r[5]);
+	const auto t6 = _mm256_unpacklo_ps(r[6], r[7]);
+	const auto t7 = _mm256_unpackhi_ps(r[6], r[7]);
+	const auto s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+	const auto s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+	const auto s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	const auto s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+	const auto s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+	const auto s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+	const auto s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+	const auto s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+	r[0] = _mm256_permute2f128_ps(s0, s4, 0x20);
+	r[1] = _mm256_permute2f128_ps(s1, s5, 0x20);
+	r[2] = _mm256_permute2f128_ps(s2, s6, 0x20);
+	r[3] = _mm256_permute2f128_ps(s3, s7, 0x20);
+	r[4] = _mm256_permute2f128_ps(s0, s4, 0x31);
+	r[5] = _mm256_permute2f128_ps(s1, s5, 0x31);
+	r[6] = _mm256_permute2f128_ps(s2, s6, 0x31);
+	r[7] = _mm256_permute2f128_ps(s3, s7, 0x31);
+}
+#	endif
+
+inline auto interleave8(const float* const* in, uint64_t frames, float* out) -> uint64_t {
+	uint64_t f = 0;
+#	if defined(ADS_AVX)
+	for (; f + 8 <= frames; f += 8) {
+		__m256 r[8];
+		for (int c = 0; c < 8; c++) { r[c] = _mm256_loadu_ps(in[c] + f); }
+		transpose8(r);
+		for (int i = 0; i < 8; i++) { _mm256_storeu_ps(out + (f + i) * 8, r[i]); }
+	}
+#	endif
+	for (; f + 4 <= frames; f += 4) {
+		auto a0 = _mm_loadu_ps(in[0] + f);
+		auto a1 = _mm_loadu_ps(in[1] + f);
+		auto a2 = _mm_loadu_ps(in[2] + f);
+		auto a3 = _mm_loadu_ps(in[3] + f);
+		auto b0 = _mm_loadu_ps(in[4] + f);
+		auto b1 = _mm_loadu_ps(in[5] + f);
+		auto b2 = _mm_loadu_ps(in[6] + f);
+		auto b3 = _mm_loadu_ps(in[7] + f);
+		transpose4(a0, a1, a2, a3);
+		transpose4(b0, b1, b2, b3);
+		const auto dest = out + f * 8;
+		_mm_storeu_ps(dest, a0);      _mm_storeu_ps(dest + 4, b0);
+		_mm_storeu_ps(dest + 8, a1);  _mm_storeu_ps(dest + 12, b1);
+		_mm_storeu_ps(dest + 16, a2); _mm_storeu_ps(dest + 20, b2);
+		_mm_storeu_ps(dest + 24, a3); _mm_storeu_ps(dest + 28, b3);
+	}
+	return f;
+}
+
+inline auto deinterleave8(const float* in, uint64_t frames, float* const* out) -> uint64_t {
+	uint64_t f = 0;
+#	if defined(ADS_AVX)
+	for (; f + 8 <= frames; f += 8) {
+		__m256 r[8];
+		for (int i = 0; i < 8; i++) { r[i] = _mm256_loadu_ps(in + (f + i) * 8); }
+		transpose8(r);
+		for (int c = 0; c < 8; c++) { _mm256_storeu_ps(out[c] + f, r[c]); }
+	}
+#	endif
+	for (; f + 4 <= frames; f += 4) {
+		const auto src = in + f * 8;
+		auto a0 = _mm_loadu_ps(src);      auto b0 = _mm_loadu_ps(src + 4);
+		auto a1 = _mm_loadu_ps(src + 8);  auto b1 = _mm_loadu_ps(src + 12);
+		auto a2 = _mm_loadu_ps(src + 16); auto b2 = _mm_loadu_ps(src + 20);
+		auto a3 = _mm_loadu_ps(src + 24); auto b3 = _mm_loadu_ps(src + 28);
+		transpose4(a0, a1, a2, a3);
+		transpose4(b0, b1, b2, b3);
+		_mm_storeu_ps(out[0] + f, a0);
+		_mm_storeu_ps(out[1] + f, a1);
+		_mm_storeu_ps(out[2] + f, a2);
+		_mm_storeu_ps(out[3] + f, a3);
+		_mm_storeu_ps(out[4] + f, b0);
+		_mm_storeu_ps(out[5] + f, b1);
+		_mm_storeu_ps(out[6] + f, b2);
+		_mm_storeu_ps(out[7] + f, b3);
+	}
+	return f;
+}
+
+#endif // ADS_SSE2
+
+[[nodiscard]] inline
+auto interleave(const float* const* in, uint64_t channel_count, uint64_t frames, float* out) -> uint64_t {
+	if (channel_count == 1) {
+		if (frames > 0) { std::memcpy(out, in[0], frames * sizeof(float)); }
+		return frames;
+	}
+#if defined(ADS_SSE2)
+	switch (channel_count) {
+		case 2: { return interleave2(in, frames, out); }
+		case 4: { return interleave4(in, frames, out); }
+		case 6: { return interleave6(in, frames, out); }
+		case 8: { return interleave8(in, frames, out); }
+		default: { break; }
+	}
+#endif
+	return 0;
+}
+
+[[nodiscard]] inline
+auto deinterleave(const float* in, uint64_t channel_count, uint64_t frames, float* const* out) -> uint64_t {
+	if (channel_count == 1) {
+		if (frames > 0) { std::memcpy(out[0], in, frames * sizeof(float)); }
+		return frames;
+	}
+#if defined(ADS_SSE2)
+	switch (channel_count) {
+		case 2: { return deinterleave2(in, frames, out); }
+		case 4: { return deinterleave4(in, frames, out); }
+		case 6: { return deinterleave6(in, frames, out); }
+		case 8: { return deinterleave8(in, frames, out); }
+		default: { break; }
+	}
+#endif
+	return 0;
+}
+
+} // namespace ads::detail::simd
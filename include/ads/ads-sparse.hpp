@@ -0,0 +1,433 @@
+#pragma once
+
+#include "ads.hpp"
+
+namespace ads {
+
+// Storage for audio which is mostly silence, e.g. the tracks of a
+// multitrack recording. Each channel is split into blocks of BlockSize
+// frames, and a block which is silent is not allocated at all and reads
+// back as zeros. A block is silent if the magnitude of every sample is
+// no greater than the threshold, which is zero unless one is given.
+// Samples below a non-zero threshold are lost when their block is
+// released.
+//
+// read() and write() take the same callbacks as ads::data, split at block
+// boundaries. read_sparse() callbacks are given a null buffer for silent
+// blocks, so they can skip them. Writing allocates any silent blocks in
+// the range and releases them again if they are still silent afterwards.
+template <typename ValueType, uint64_t Chs = DYNAMIC_EXTENT, uint64_t BlockSize = 4096, typename Policy = default_policy>
+class sparse {
+public:
+	static constexpr auto CHANNEL_COUNT = Chs;
+	static constexpr auto BLOCK_SIZE    = BlockSize;
+	static constexpr auto ALIGNMENT     = detail::get_alignment<ValueType, Policy>();
+	using value_type     = ValueType;
+	using policy         = Policy;
+	using allocator_type = typename Policy::allocator;
+	static_assert (std::has_single_bit(BlockSize), "BlockSize must be a power of two");
+	static_assert ((BlockSize * sizeof(ValueType)) % ALIGNMENT == 0, "BlockSize is too small for the policy's alignment");
+	sparse() requires (Chs != DYNAMIC_EXTENT) = default;
+	explicit sparse(ads::frame_count frame_count, ValueType threshold = ValueType{0}, const allocator_type& alloc = {}) requires (Chs != DYNAMIC_EXTENT)
+		: sparse{ads::channel_count{Chs}, frame_count, threshold, alloc}
+	{}
+	sparse(ads::channel_count channel_count, ads::frame_count frame_count, ValueType threshold = ValueType{0}, const allocator_type& alloc = {})
+		: block_alloc_{alloc}
+		, blocks_{block_table_allocator{alloc}}
+		, channel_count_{channel_count.value}
+		, threshold_{threshold}
+	{
+		if (Chs != DYNAMIC_EXTENT && channel_count.value != Chs) {
+			throw std::invalid_argument{std::format("ads::sparse: Channel count {} doesn't match the static channel count {}", channel_count.value, Chs)};
+		}
+		if (channel_count.value > detail::SANE_NUMBER_OF_CHANNELS) { throw std::underflow_error{std::format("ads::sparse: Channel count {} is insane", channel_count.value)}; }
+		if (frame_count.value > detail::SANE_NUMBER_OF_FRAMES)     { throw std::underflow_error{std::format("ads::sparse: Frame count {} is insane", frame_count.value)}; }
+		resize(frame_count);
+	}
+	sparse(const sparse& rhs)
+		: block_alloc_{std::allocator_traits<block_allocator>::select_on_container_copy_construction(rhs.block_alloc_)}
+		, blocks_{rhs.blocks_.size(), nullptr, block_table_allocator{allocator_type{block_alloc_.upstream()}}}
+		, channel_count_{rhs.channel_count_}
+		, block_count_{rhs.block_count_}
+		, frame_count_{rhs.frame_count_}
+		, threshold_{rhs.threshold_}
+	{
+		for (size_t b = 0; b < blocks_.size(); b++) {
+			if (rhs.blocks_[b]) {
+				blocks_[b] = allocate_block();
+				std::copy_n(rhs.blocks_[b], BlockSize, blocks_[b]);
+			}
+		}
+	}
+	sparse(sparse&& rhs) noexcept
+		: block_alloc_{std::move(rhs.block_alloc_)}
+		, blocks_{std::move(rhs.blocks_)}
+		, channel_count_{rhs.channel_count_}
+		, block_count_{std::exchange(rhs.block_count_, 0)}
+		, frame_count_{std::exchange(rhs.frame_count_, 0)}
+		, threshold_{rhs.threshold_}
+	{
+		rhs.blocks_.clear();
+	}
+	auto operator=(const sparse& rhs) -> sparse& {
+		if (this != &rhs) {
+			auto copy = sparse{rhs};
+			swap(copy);
+		}
+		return *this;
+	}
+	auto operator=(sparse&& rhs) noexcept -> sparse& {
+		swap(rhs);
+		return *this;
+	}
+	~sparse() {
+		for (auto& block : blocks_) {
+			release_block(block);
+		}
+	}
+	auto swap(sparse& rhs) noexcept -> void {
+		std::swap(block_alloc_, rhs.block_alloc_);
+		std::swap(blocks_, rhs.blocks_);
+		std::swap(channel_count_, rhs.channel_count_);
+		std::swap(block_count_, rhs.block_count_);
+		std::swap(frame_count_, rhs.frame_count_);
+		std::swap(threshold_, rhs.threshold_);
+	}
+	[[nodiscard]] auto get_allocator() const -> allocator_type    { return allocator_type{block_alloc_.upstream()}; }
+	[[nodiscard]] auto get_channel_count() const -> channel_count { return {channel_count_}; }
+	[[nodiscard]] auto get_frame_count() const -> frame_count     { return {frame_count_}; }
+	[[nodiscard]] auto get_threshold() const -> ValueType         { return threshold_; }
+	// The number of blocks in each channel.
+	[[nodiscard]] auto get_block_count() const -> uint64_t        { return block_count_; }
+	// The number of blocks which are allocated, across all channels.
+	[[nodiscard]]
+	auto get_allocated_block_count() const -> uint64_t {
+		return static_cast<uint64_t>(std::ranges::count_if(blocks_, [](const ValueType* block) { return block != nullptr; }));
+	}
+	[[nodiscard]]
+	auto is_silent(channel_idx ch, frame_idx f) const -> bool {
+		detail::check_index<typename Policy::bounds_check>("channel", ch.value, channel_count_);
+		detail::check_index<typename Policy::bounds_check>("frame", static_cast<uint64_t>(f.value), frame_count_);
+		return block(ch, static_cast<uint64_t>(f.value) / BlockSize) == nullptr;
+	}
+	// New frames are silent.
+	auto resize(ads::frame_count frame_count) -> void {
+		if (frame_count.value > detail::SANE_NUMBER_OF_FRAMES) {
+			throw std::underflow_error{std::format("ads::sparse::resize(): Frame count {} is insane", frame_count.value)};
+		}
+		const auto new_block_count = (frame_count.value + BlockSize - 1) / BlockSize;
+		if (frame_count.value < frame_count_) {
+			// Zero what is left of the last block, so it reads back as
+			// silence if the frame count grows again.
+			clear(frame_idx{static_cast<int64_t>(frame_count.value)}, std::min(frame_count_, new_block_count * BlockSize) - frame_count.value);
+		}
+		if (new_block_count != block_count_) {
+			std::vector<ValueType*, block_table_allocator> blocks(channel_count_ * new_block_count, nullptr, blocks_.get_allocator());
+			for (uint64_t c = 0; c < channel_count_; c++) {
+				for (uint64_t b = 0; b < block_count_; b++) {
+					auto& old_block = blocks_[c * block_count_ + b];
+					if (b < new_block_count) { blocks[c * new_block_count + b] = std::exchange(old_block, nullptr); }
+					else                     { release_block(old_block); }
+				}
+			}
+			blocks_      = std::move(blocks);
+			block_count_ = new_block_count;
+		}
+		frame_count_ = frame_count.value;
+	}
+	[[nodiscard]]
+	auto at(channel_idx ch, frame_idx f) const -> ValueType {
+		detail::check_index<typename Policy::bounds_check>("channel", ch.value, channel_count_);
+		detail::check_index<typename Policy::bounds_check>("frame", static_cast<uint64_t>(f.value), frame_count_);
+		return at_unchecked(ch, f);
+	}
+	[[nodiscard]]
+	auto at_unchecked(channel_idx ch, frame_idx f) const -> ValueType {
+		const auto b = block(ch, static_cast<uint64_t>(f.value) / BlockSize);
+		return b ? b[f.value % BlockSize] : ValueType{0};
+	}
+	[[nodiscard]] auto at(frame_idx f) const -> ValueType requires (concepts::is_mono_data<Chs>) { return at(channel_idx{0}, f); }
+	// Setting a sample in a silent block to a value above the threshold
+	// allocates the block. Setting samples to zero never releases a block,
+	// but compact() does.
+	auto set(channel_idx ch, frame_idx f, ValueType value) -> void {
+		detail::check_index<typename Policy::bounds_check>("channel", ch.value, channel_count_);
+		detail::check_index<typename Policy::bounds_check>("frame", static_cast<uint64_t>(f.value), frame_count_);
+		auto& b = block(ch, static_cast<uint64_t>(f.value) / BlockSize);
+		if (!b) {
+			if (is_silent_value(value)) {
+				return;
+			}
+			b = allocate_silent_block();
+		}
+		b[f.value % BlockSize] = value;
+	}
+	auto set(frame_idx f, frame_t<ValueType, Chs> value) -> void {
+		for (uint64_t c = 0; c < channel_count_; c++) {
+			set(channel_idx{c}, f, value[c]);
+		}
+	}
+	// Releases every block which is silent.
+	auto compact() -> void {
+		for (auto& b : blocks_) {
+			if (b && is_silent_block(b)) {
+				release_block(b);
+			}
+		}
+	}
+	// Filling with a silent value releases every block.
+	auto fill(ValueType value) -> void {
+		if (is_silent_value(value)) {
+			for (auto& b : blocks_) { release_block(b); }
+			return;
+		}
+		for (ads::channel_idx ch = {0}; ch < channel_count_; ch++) {
+			static_cast<void>(write(ch, [value](ValueType* buffer, frame_idx, ads::frame_count n) {
+				std::fill_n(buffer, n.value, value);
+				return n;
+			}));
+		}
+	}
+	// Copies src into the storage starting at frame start, which must
+	// have the same number of channels, and returns the number of frames
+	// copied. Blocks of src which are silent are not allocated.
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Src>, ValueType>
+	auto write(frame_idx start, const Src& src) -> frame_count {
+		if (src.get_channel_count() != channel_count_) {
+			throw std::invalid_argument{std::format("ads::sparse::write(): Channel count mismatch ({} != {})", src.get_channel_count().value, channel_count_)};
+		}
+		return write(start, src.get_frame_count(), [&src, start](ValueType* buffer, channel_idx ch, frame_idx chunk_start, ads::frame_count n) {
+			std::copy_n(src.data(ch) + (chunk_start.value - start.value), n.value, buffer);
+			return n;
+		});
+	}
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Src>, ValueType>
+	auto write(const Src& src) -> frame_count {
+		return write(frame_idx{0}, src);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(ReadFn read_fn) const -> frame_count {
+		return read(frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(frame_idx start, ReadFn read_fn) const -> frame_count {
+		return read(start, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(frame_count n, ReadFn read_fn) const -> frame_count {
+		return read(frame_idx{0}, n, read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return for_each_channel("read", [&](channel_idx ch) { return read(ch, start, n, read_fn); });
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(channel_idx ch, ReadFn read_fn) const -> frame_count {
+		return read(ch, frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(channel_idx ch, frame_idx start, ReadFn read_fn) const -> frame_count {
+		return read(ch, start, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(channel_idx ch, frame_count n, ReadFn read_fn) const -> frame_count {
+		return read(ch, frame_idx{0}, n, read_fn);
+	}
+	// Silent blocks are passed as zeros.
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read(channel_idx ch, frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return read_sparse(ch, start, n, [ch, &read_fn](const ValueType* buffer, frame_idx chunk_start, ads::frame_count chunk_frames) {
+			if (!buffer) {
+				buffer = ZEROS.data() + chunk_start.value % BlockSize;
+			}
+			if constexpr (concepts::is_single_channel_read_fn<ValueType, ReadFn>) { return read_fn(buffer, chunk_start, chunk_frames); }
+			else                                                                  { return read_fn(buffer, ch, chunk_start, chunk_frames); }
+		});
+	}
+	// The same as read(), except that buffer is null if the frames are
+	// silent.
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read_sparse(frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return for_each_channel("read_sparse", [&](channel_idx ch) { return read_sparse(ch, start, n, read_fn); });
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read_sparse(ReadFn read_fn) const -> frame_count {
+		return read_sparse(frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read_sparse(channel_idx ch, ReadFn read_fn) const -> frame_count {
+		return read_sparse(ch, frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<ValueType, ReadFn>
+	auto read_sparse(channel_idx ch, frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return for_each_chunk(ch, start, n, [this, ch, &read_fn](uint64_t b, uint64_t offset, frame_idx chunk_start, ads::frame_count chunk_frames) {
+			const ValueType* buffer = block(ch, b);
+			if (buffer) {
+				buffer += offset;
+			}
+			if constexpr (concepts::is_single_channel_read_fn<ValueType, ReadFn>) { return read_fn(buffer, chunk_start, chunk_frames); }
+			else                                                                  { return read_fn(buffer, ch, chunk_start, chunk_frames); }
+		});
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(WriteFn write_fn) -> frame_count {
+		return write(frame_idx{0}, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(frame_idx start, WriteFn write_fn) -> frame_count {
+		return write(start, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(frame_count n, WriteFn write_fn) -> frame_count {
+		return write(frame_idx{0}, n, write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
+		return for_each_channel("write", [&](channel_idx ch) { return write(ch, start, n, write_fn); });
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(channel_idx ch, WriteFn write_fn) -> frame_count {
+		return write(ch, frame_idx{0}, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(channel_idx ch, frame_idx start, WriteFn write_fn) -> frame_count {
+		return write(ch, start, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(channel_idx ch, frame_count n, WriteFn write_fn) -> frame_count {
+		return write(ch, frame_idx{0}, n, write_fn);
+	}
+	template <typename WriteFn>
+		requires concepts::is_write_fn<ValueType, WriteFn>
+	auto write(channel_idx ch, frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
+		return for_each_chunk(ch, start, n, [this, ch, &write_fn](uint64_t b, uint64_t offset, frame_idx chunk_start, ads::frame_count chunk_frames) {
+			auto& buffer = block(ch, b);
+			if (!buffer) {
+				buffer = allocate_silent_block();
+			}
+			auto done = ads::frame_count{0};
+			try {
+				if constexpr (concepts::is_single_channel_write_fn<ValueType, WriteFn>) { done = write_fn(buffer + offset, chunk_start, chunk_frames); }
+				else                                                                    { done = write_fn(buffer + offset, ch, chunk_start, chunk_frames); }
+			}
+			catch (...) {
+				if (is_silent_block(buffer)) { release_block(buffer); }
+				throw;
+			}
+			if (is_silent_block(buffer)) {
+				release_block(buffer);
+			}
+			return done;
+		});
+	}
+private:
+	using block_allocator       = detail::aligned_allocator<ValueType, ALIGNMENT, 0, allocator_type>;
+	using block_table_allocator = detail::rebind_alloc_t<Policy, ValueType*>;
+	alignas(ALIGNMENT) static constexpr std::array<ValueType, BlockSize> ZEROS = {};
+	[[nodiscard]] auto block(channel_idx ch, uint64_t b) -> ValueType*&            { return blocks_[ch.value * block_count_ + b]; }
+	[[nodiscard]] auto block(channel_idx ch, uint64_t b) const -> const ValueType* { return blocks_[ch.value * block_count_ + b]; }
+	[[nodiscard]]
+	auto is_silent_value(ValueType value) const -> bool {
+		return !(value > threshold_ || value < -threshold_);
+	}
+	[[nodiscard]]
+	auto is_silent_block(const ValueType* b) const -> bool {
+		return std::all_of(b, b + BlockSize, [this](ValueType value) { return is_silent_value(value); });
+	}
+	[[nodiscard]]
+	auto allocate_block() -> ValueType* {
+		return std::allocator_traits<block_allocator>::allocate(block_alloc_, BlockSize);
+	}
+	[[nodiscard]]
+	auto allocate_silent_block() -> ValueType* {
+		const auto b = allocate_block();
+		std::fill_n(b, BlockSize, ValueType{0});
+		return b;
+	}
+	auto release_block(ValueType*& b) -> void {
+		if (b) {
+			std::allocator_traits<block_allocator>::deallocate(block_alloc_, b, BlockSize);
+			b = nullptr;
+		}
+	}
+	// Zeroes n frames of every channel, without allocating.
+	auto clear(frame_idx start, uint64_t n) -> void {
+		for (ads::channel_idx ch = {0}; ch < channel_count_; ch++) {
+			static_cast<void>(for_each_chunk(ch, start, {n}, [this, ch](uint64_t b, uint64_t offset, frame_idx, ads::frame_count chunk_frames) {
+				if (const auto buffer = block(ch, b)) {
+					std::fill_n(buffer + offset, chunk_frames.value, ValueType{0});
+				}
+				return chunk_frames;
+			}));
+		}
+	}
+	template <typename Fn>
+	auto for_each_channel(const char* what, Fn fn) const -> frame_count {
+		auto frames_done = ads::frame_count{0};
+		for (ads::channel_idx ch = {0}; ch < channel_count_; ch++) {
+			const auto channel_frames_done = fn(ch);
+			if (ch.value == 0) { frames_done = channel_frames_done; }
+			else if (frames_done != channel_frames_done) {
+				throw std::runtime_error{std::format("ads::sparse::{}() frame count mismatch ({} != {})", what, frames_done.value, channel_frames_done.value)};
+			}
+		}
+		return frames_done;
+	}
+	// Clamps the range to the frame count and calls fn(block, offset,
+	// start, n) for each piece of it which lies within a single block.
+	// Stops early if fn returns fewer frames than it was given.
+	template <typename Fn>
+	auto for_each_chunk(channel_idx ch, frame_idx start, ads::frame_count frame_count, Fn fn) const -> ads::frame_count {
+		if (start.value > static_cast<int64_t>(detail::SANE_NUMBER_OF_FRAMES)) {
+			throw std::underflow_error{std::format("ads::sparse: Frame start = {} is insane", start.value)};
+		}
+		detail::check_index<typename Policy::bounds_check>("channel", ch.value, channel_count_);
+		if (start.value < 0 || start >= get_frame_count()) {
+			return {0};
+		}
+		auto pos       = static_cast<uint64_t>(start.value);
+		const auto end = pos + std::min(frame_count.value, frame_count_ - pos);
+		auto done      = ads::frame_count{0};
+		while (pos < end) {
+			const auto offset     = pos % BlockSize;
+			const auto chunk      = ads::frame_count{std::min(BlockSize - offset, end - pos)};
+			const auto chunk_done = fn(pos / BlockSize, offset, frame_idx{static_cast<int64_t>(pos)}, chunk);
+			done += chunk_done;
+			if (chunk_done < chunk) {
+				break;
+			}
+			pos += chunk.value;
+		}
+		return done;
+	}
+	[[no_unique_address]] block_allocator block_alloc_;
+	// Channel c's blocks are at [c * block_count_, (c + 1) * block_count_).
+	std::vector<ValueType*, block_table_allocator> blocks_;
+	uint64_t channel_count_ = Chs == DYNAMIC_EXTENT ? 0 : Chs;
+	uint64_t block_count_   = 0;
+	uint64_t frame_count_   = 0;
+	ValueType threshold_    = ValueType{0};
+};
+
+} // namespace ads
@@ -0,0 +1,527 @@
+#pragma once
+
+#include "ads.hpp"
+#include "ads-simd.hpp"
+
+namespace ads {
+
+// Summary statistics of a run of samples, from one channel or from
+// several channels together.
+template <typename ValueType>
+struct stats {
+	ValueType min           = std::numeric_limits<ValueType>::max();
+	ValueType max           = std::numeric_limits<ValueType>::lowest();
+	double sum              = 0.0;
+	double sum_of_squares   = 0.0;
+	// Samples whose magnitude is at least the clip level.
+	uint64_t clip_count     = 0;
+	uint64_t sample_count   = 0;
+	[[nodiscard]] auto peak() const -> ValueType { return sample_count == 0 ? ValueType(0) : std::max<ValueType>(max, -min); }
+	// The DC offset.
+	[[nodiscard]] auto mean() const -> double    { return sample_count == 0 ? 0.0 : sum / static_cast<double>(sample_count); }
+	[[nodiscard]] auto rms() const -> double     { return sample_count == 0 ? 0.0 : std::sqrt(sum_of_squares / static_cast<double>(sample_count)); }
+	// Combines the statistics of two runs of samples.
+	auto merge(const stats& other) -> void {
+		min             = std::min(min, other.min);
+		max             = std::max(max, other.max);
+		sum            += other.sum;
+		sum_of_squares += other.sum_of_squares;
+		clip_count     += other.clip_count;
+		sample_count   += other.sample_count;
+	}
+};
+
+namespace detail::stats {
+
+// The SIMD kernels accumulate sums in float lanes for this many samples
+// at a time and then add them to the double totals, which keeps the
+// rounding error of long runs close to that of double accumulation.
+static constexpr uint64_t FLUSH_SIZE = 1024;
+// Frames per task when running in parallel.
+static constexpr uint64_t TASK_SIZE = 65536;
+
+// Each SIMD kernel processes as many whole vectors as it can, adds them
+// to s and returns the number of samples processed.
+
+#if defined(ADS_SSE2)
+inline auto hsum_sse(__m128 v) -> double {
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, v);
+	return (static_cast<double>(lanes[0]) + lanes[1]) + (static_cast<double>(lanes[2]) + lanes[3]);
+}
+
+inline auto accumulate_sse(const float* x, uint64_t n, float clip_level, ads::stats<float>& s) -> uint64_t {
+	const auto sign_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const auto clip      = _mm_set1_ps(clip_level);
+	auto lo    = _mm_set1_ps(s.min);
+	auto hi    = _mm_set1_ps(s.max);
+	uint64_t i = 0;
+	while (i + 4 <= n) {
+		const auto end = std::min(n - n % 4, i + FLUSH_SIZE);
+		auto sum    = _mm_setzero_ps();
+		auto sum_sq = _mm_setzero_ps();
+		auto clips  = _mm_setzero_si128();
+		for (; i < end; i += 4) {
+			const auto v = _mm_loadu_ps(x + i);
+			lo     = _mm_min_ps(lo, v);
+			hi     = _mm_max_ps(hi, v);
+			sum    = _mm_add_ps(sum, v);
+			sum_sq = _mm_add_ps(sum_sq, _mm_mul_ps(v, v));
+			// A true comparison is all ones, i.e. -1.
+			clips  = _mm_sub_epi32(clips, _mm_castps_si128(_mm_cmpge_ps(_mm_and_ps(v, sign_mask), clip)));
+		}
+		alignas(16) int32_t counts[4];
+		_mm_store_si128(reinterpret_cast<__m128i*>(counts), clips);
+		s.sum            += hsum_sse(sum);
+		s.sum_of_squares += hsum_sse(sum_sq);
+		s.clip_count     += static_cast<uint64_t>(counts[0]) + counts[1] + counts[2] + counts[3];
+	}
+	alignas(16) float lanes[4];
+	_mm_store_ps(lanes, lo);
+	s.min = std::min({lanes[0], lanes[1], lanes[2], lanes[3]});
+	_mm_store_ps(lanes, hi);
+	s.max = std::max({lanes[0], lanes[1], lanes[2], lanes[3]});
+	s.sample_count += i;
+	return i;
+}
+#endif // ADS_SSE2
+
+#if defined(ADS_AVX2_DISPATCH)
+ADS_TARGET_AVX2 inline auto hsum_avx2(__m256 v) -> double {
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, v);
+	auto sum = 0.0;
+	for (const auto lane : lanes) { sum += lane; }
+	return sum;
+}
+
+ADS_TARGET_AVX2 inline auto accumulate_avx2(const float* x, uint64_t n, float clip_level, ads::stats<float>& s) -> uint64_t {
+	const auto sign_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7fffffff));
+	const auto clip      = _mm256_set1_ps(clip_level);
+	auto lo    = _mm256_set1_ps(s.min);
+	auto hi    = _mm256_set1_ps(s.max);
+	uint64_t i = 0;
+	while (i + 8 <= n) {
+		const auto end = std::min(n - n % 8, i + FLUSH_SIZE);
+		auto sum    = _mm256_setzero_ps();
+		auto sum_sq = _mm256_setzero_ps();
+		auto clips  = _mm256_setzero_si256();
+		for (; i < end; i += 8) {
+			const auto v = _mm256_loadu_ps(x + i);
+			lo     = _mm256_min_ps(lo, v);
+			hi     = _mm256_max_ps(hi, v);
+			sum    = _mm256_add_ps(sum, v);
+			sum_sq = _mm256_fmadd_ps(v, v, sum_sq);
+			clips  = _mm256_sub_epi32(clips, _mm256_castps_si256(_mm256_cmp_ps(_mm256_and_ps(v, sign_mask), clip, _CMP_GE_OQ)));
+		}
+		alignas(32) int32_t counts[8];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(counts), clips);
+		s.sum            += hsum_avx2(sum);
+		s.sum_of_squares += hsum_avx2(sum_sq);
+		for (const auto count : counts) { s.clip_count += static_cast<uint64_t>(count); }
+	}
+	alignas(32) float lanes[8];
+	_mm256_store_ps(lanes, lo);
+	s.min = *std::min_element(lanes, lanes + 8);
+	_mm256_store_ps(lanes, hi);
+	s.max = *std::max_element(lanes, lanes + 8);
+	s.sample_count += i;
+	return i;
+}
+#endif // ADS_AVX2_DISPATCH
+
+template <typename T>
+auto accumulate(const T* x, uint64_t n, T clip_level, ads::stats<T>& s) -> void {
+	uint64_t i = 0;
+	if constexpr (std::is_same_v<T, float>) {
+#if defined(ADS_AVX2_DISPATCH)
+		i = simd::has_avx2() ? accumulate_avx2(x, n, clip_level, s) : accumulate_sse(x, n, clip_level, s);
+#elif defined(ADS_SSE2)
+		i = accumulate_sse(x, n, clip_level, s);
+#endif
+	}
+	for (; i < n; i++) {
+		const auto v = x[i];
+		const auto d = static_cast<double>(v);
+		s.min             = std::min(s.min, v);
+		s.max             = std::max(s.max, v);
+		s.sum            += d;
+		s.sum_of_squares += d * d;
+		s.clip_count     += (v < T(0) ? -d : d) >= static_cast<double>(clip_level) ? 1 : 0;
+		s.sample_count++;
+	}
+}
+
+template <typename Src>
+auto check_region(const char* fn, const Src& src, ads::region region) -> void {
+	if (region.beg.value < 0 || region.end < region.beg || region.end > src.get_frame_count()) {
+		throw std::out_of_range{std::format("ads::{}(): Region [{}, {}) is out of range (frame count = {})", fn, region.beg.value, region.end.value, src.get_frame_count().value)};
+	}
+}
+
+// Returns the statistics of each channel in channels over region. The
+// region is split into tasks of TASK_SIZE frames which are shared out
+// between threads, and merged in order.
+template <typename T>
+auto get_stats(std::span<const T* const> channels, ads::region region, T clip_level, unsigned thread_count) -> std::vector<ads::stats<T>> {
+	const auto frame_count   = region.size().value;
+	const auto channel_tasks = (frame_count + TASK_SIZE - 1) / TASK_SIZE;
+	std::vector<ads::stats<T>> results(channels.size() * channel_tasks);
+	parallel_for(results.size(), thread_count, [&](uint64_t task) {
+		const auto start = (task % channel_tasks) * TASK_SIZE;
+		const auto x     = channels[task / channel_tasks] + region.beg.value + start;
+		accumulate(x, std::min(TASK_SIZE, frame_count - start), clip_level, results[task]);
+	});
+	std::vector<ads::stats<T>> out(channels.size());
+	for (uint64_t task = 0; task < results.size(); task++) {
+		out[task / channel_tasks].merge(results[task]);
+	}
+	return out;
+}
+
+template <typename Src>
+auto get_channel_pointers(const Src& src) -> channel_pointers_t<const concepts::channel_value_t<Src>*, DYNAMIC_EXTENT> {
+	channel_pointers_t<const concepts::channel_value_t<Src>*, DYNAMIC_EXTENT> channels;
+	for (ads::channel_idx ch = {0}; ch < src.get_channel_count(); ch++) {
+		channels.push_back(src.data(ch));
+	}
+	return channels;
+}
+
+} // namespace detail::stats
+
+// Min, max, peak, DC offset, RMS and clip count over a region of an
+// ads::data or view. A sample clips if its magnitude is at least
+// clip_level. thread_count threads (including the calling thread) share
+// the work out in chunks, and zero means one per hardware thread. The
+// SIMD implementation is for float, and uses AVX2 if the CPU supports it.
+
+// The statistics of one channel.
+template <typename Src>
+	requires concepts::is_channel_data<Src>
+[[nodiscard]]
+auto get_stats(const Src& src, channel_idx ch, ads::region region, concepts::channel_value_t<Src> clip_level = 1, unsigned thread_count = 1) -> stats<concepts::channel_value_t<Src>> {
+	using value_type = concepts::channel_value_t<Src>;
+	detail::stats::check_region("get_stats", src, region);
+	const auto channel = static_cast<const value_type*>(src.data(ch));
+	return detail::stats::get_stats(std::span{&channel, 1}, region, clip_level, thread_count)[0];
+}
+
+// The statistics of every channel together.
+template <typename Src>
+	requires concepts::is_channel_data<Src>
+[[nodiscard]]
+auto get_stats(const Src& src, ads::region region, concepts::channel_value_t<Src> clip_level = 1, unsigned thread_count = 1) -> stats<concepts::channel_value_t<Src>> {
+	detail::stats::check_region("get_stats", src, region);
+	const auto channels = detail::stats::get_channel_pointers(src);
+	auto out = stats<concepts::channel_value_t<Src>>{};
+	for (const auto& channel_stats : detail::stats::get_stats(std::span{channels.data(), channels.size()}, region, clip_level, thread_count)) {
+		out.merge(channel_stats);
+	}
+	return out;
+}
+
+// The statistics of each channel separately.
+template <typename Src>
+	requires concepts::is_channel_data<Src>
+[[nodiscard]]
+auto get_channel_stats(const Src& src, ads::region region, concepts::channel_value_t<Src> clip_level = 1, unsigned thread_count = 1) -> std::vector<stats<concepts::channel_value_t<Src>>> {
+	detail::stats::check_region("get_channel_stats", src, region);
+	const auto channels = detail::stats::get_channel_pointers(src);
+	return detail::stats::get_stats(std::span{channels.data(), channels.size()}, region, clip_level, thread_count);
+}
+
+// Blocked prefix sums of the samples and squared samples of each channel
+// of an ads::data or view, for O(1) energy, mean and RMS queries over
+// arbitrary regions. The sums are kept per BlockSize frames, so for float
+// data the index takes about 1/20 of the sample memory at the default
+// block size. Queries combine the prefix sums of the whole blocks in the
+// region with a scan of at most two partial blocks of the source, which
+// must therefore be passed to every query.
+//
+// The index doesn't observe the source. After rewriting a region (e.g.
+// with write()), call update() with that region, which rescans only the
+// blocks it touches and then re-accumulates the prefix sums after them.
+// After resizing the source, call rebuild(). The prefix sums use Kahan
+// summation, so they stay accurate over very long recordings.
+template <uint64_t BlockSize = 256>
+class energy_index {
+public:
+	static_assert(BlockSize > 0);
+	energy_index() = default;
+	template <typename Src>
+		requires concepts::is_channel_data<Src>
+	explicit energy_index(const Src& src) {
+		rebuild(src);
+	}
+	[[nodiscard]] auto get_channel_count() const -> channel_count { return {channel_count_}; }
+	[[nodiscard]] auto get_frame_count() const -> frame_count     { return {frame_count_}; }
+	// Sum of the squared samples in region of channel ch.
+	template <typename Src>
+		requires concepts::is_channel_data<Src>
+	[[nodiscard]]
+	auto get_energy(const Src& src, channel_idx ch, ads::region region) const -> double {
+		return query(src, ch, region).sum_of_squares;
+	}
+	// The DC offset of region of channel ch.
+	template <typename Src>
+		requires concepts::is_channel_data<Src>
+	[[nodiscard]]
+	auto get_mean(const Src& src, channel_idx ch, ads::region region) const -> double {
+		return region.size() == 0 ? 0.0 : query(src, ch, region).sum / static_cast<double>(region.size().value);
+	}
+	template <typename Src>
+		requires concepts::is_channel_data<Src>
+	[[nodiscard]]
+	auto get_rms(const Src& src, channel_idx ch, ads::region region) const -> double {
+		return region.size() == 0 ? 0.0 : std::sqrt(std::max(0.0, get_energy(src, ch, region)) / static_cast<double>(region.size().value));
+	}
+	// Discards the index and builds it again for the current size of src.
+	template <typename Src>
+		requires concepts::is_channel_data<Src>
+	auto rebuild(const Src& src) -> void {
+		channel_count_ = src.get_channel_count().value;
+		frame_count_   = src.get_frame_count().value;
+		block_count_   = (frame_count_ + BlockSize - 1) / BlockSize;
+		blocks_.assign(channel_count_ * block_count_, {});
+		prefix_.assign(channel_count_ * (block_count_ + 1), {});
+		update(src, {frame_idx{0}, frame_idx{static_cast<int64_t>(frame_count_)}});
+	}
+	// Updates the index after region of src has been rewritten.
+	template <typename Src>
+		requires concepts::is_channel_data<Src>
+	auto update(const Src& src, ads::region region) -> void {
+		check_source("update", src);
+		detail::stats::check_region("energy_index::update", src, region);
+		if (region.size() == 0) {
+			return;
+		}
+		const auto first = static_cast<uint64_t>(region.beg.value) / BlockSize;
+		const auto last  = (static_cast<uint64_t>(region.end.value) + BlockSize - 1) / BlockSize;
+		for (ads::channel_idx ch = {0}; ch < channel_count_; ch++) {
+			for (auto b = first; b < last; b++) {
+				const auto beg = b * BlockSize;
+				const auto s   = scan(src, ch, beg, std::min(beg + BlockSize, frame_count_));
+				blocks_[ch.value * block_count_ + b] = {s.sum, s.sum_of_squares};
+			}
+			accumulate_prefix(ch, first);
+		}
+	}
+private:
+	struct sums { double sum = 0.0; double sum_of_squares = 0.0; };
+	template <typename Src>
+	auto check_source(const char* fn, const Src& src) const -> void {
+		if (src.get_channel_count() != channel_count_ || src.get_frame_count() != frame_count_) {
+			throw std::invalid_argument{std::format("ads::energy_index::{}(): Source size mismatch ({}x{} != {}x{})", fn, src.get_channel_count().value, src.get_frame_count().value, channel_count_, frame_count_)};
+		}
+	}
+	template <typename Src> [[nodiscard]] static
+	auto scan(const Src& src, channel_idx ch, uint64_t beg, uint64_t end) -> sums {
+		using value_type = concepts::channel_value_t<Src>;
+		auto s = stats<value_type>{};
+		detail::stats::accumulate(static_cast<const value_type*>(src.data(ch)) + beg, end - beg, std::numeric_limits<value_type>::max(), s);
+		return {s.sum, s.sum_of_squares};
+	}
+	// Recomputes the prefix sums of channel ch from block first onwards.
+	// The running totals carry on from the stored prefix, and so does the
+	// Kahan compensation, which is kept alongside it.
+	auto accumulate_prefix(channel_idx ch, uint64_t first) -> void {
+		const auto blocks = blocks_.data() + ch.value * block_count_;
+		const auto prefix = prefix_.data() + ch.value * (block_count_ + 1);
+		auto total = prefix[first];
+		for (auto b = first; b < block_count_; b++) {
+			kahan_add(&total.sum, &total.sum_c, blocks[b].sum);
+			kahan_add(&total.sum_of_squares, &total.sum_of_squares_c, blocks[b].sum_of_squares);
+			prefix[b + 1] = total;
+		}
+	}
+	static auto kahan_add(double* total, double* c, double value) -> void {
+		const auto y = value - *c;
+		const auto t = *total + y;
+		*c     = (t - *total) - y;
+		*total = t;
+	}
+	template <typename Src> [[nodiscard]]
+	auto query(const Src& src, channel_idx ch, ads::region region) const -> sums {
+		check_source("query", src);
+		detail::stats::check_region("energy_index::query", src, region);
+		if (ch >= channel_count_) {
+			throw std::out_of_range{std::format("ads::energy_index::query(): Channel {} is out of range (channel count = {})", ch.value, channel_count_)};
+		}
+		const auto beg   = static_cast<uint64_t>(region.beg.value);
+		const auto end   = static_cast<uint64_t>(region.end.value);
+		const auto first = (beg + BlockSize - 1) / BlockSize;
+		const auto last  = end / BlockSize;
+		if (first >= last) {
+			return scan(src, ch, beg, end);
+		}
+		const auto prefix = prefix_.data() + ch.value * (block_count_ + 1);
+		const auto head   = scan(src, ch, beg, first * BlockSize);
+		const auto tail   = scan(src, ch, last * BlockSize, end);
+		return {
+			(prefix[last].sum - prefix[first].sum) + head.sum + tail.sum,
+			(prefix[last].sum_of_squares - prefix[first].sum_of_squares) + head.sum_of_squares + tail.sum_of_squares,
+		};
+	}
+	struct prefix_sums {
+		double sum = 0.0;
+		double sum_of_squares = 0.0;
+		double sum_c = 0.0;
+		double sum_of_squares_c = 0.0;
+	};
+	uint64_t channel_count_ = 0;
+	uint64_t frame_count_   = 0;
+	uint64_t block_count_   = 0;
+	// The sums of each block, channel by channel.
+	std::vector<sums> blocks_;
+	// The sums of the blocks before each block boundary, including the
+	// end, channel by channel.
+	std::vector<prefix_sums> prefix_;
+};
+
+// The exact minimum and maximum of a region.
+template <typename ValueType>
+struct minmax {
+	ValueType min = std::numeric_limits<ValueType>::max();
+	ValueType max = std::numeric_limits<ValueType>::lowest();
+	[[nodiscard]] auto is_empty() const -> bool  { return max < min; }
+	[[nodiscard]] auto peak() const -> ValueType { return is_empty() ? ValueType(0) : std::max<ValueType>(max, -min); }
+	auto merge(const minmax& other) -> void {
+		min = std::min(min, other.min);
+		max = std::max(max, other.max);
+	}
+};
+
+// A block sparse table over each channel of an ads::data or view, for
+// exact min/max queries over arbitrary regions in constant time, unlike
+// ads::mipmap which is approximate between its levels. Level k of the
+// table holds the min/max of each run of 2^k blocks of BlockSize frames,
+// so any run of whole blocks is covered by two overlapping entries. The
+// partial blocks at either end of a query are scanned from the source,
+// which must therefore be passed to every query. For float data each
+// level takes 1/256 of the sample memory at the default block size, and
+// there are log2 of the block count levels.
+//
+// As with ads::energy_index, call update() with a region after
+// rewriting it, and rebuild() after resizing the source. update()
+// rescans only the blocks the region touches, and then recomputes the
+// table entries which cover them, which on each level is at most the
+// number of dirty blocks plus the length of that level's runs.
+template <typename ValueType, uint64_t BlockSize = 512>
+class minmax_index {
+public:
+	static_assert(BlockSize > 0);
+	using value_type = ValueType;
+	minmax_index() = default;
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Src>, ValueType>
+	explicit minmax_index(const Src& src) {
+		rebuild(src);
+	}
+	[[nodiscard]] auto get_channel_count() const -> channel_count { return {channel_count_}; }
+	[[nodiscard]] auto get_frame_count() const -> frame_count     { return {frame_count_}; }
+	// The min/max of region of channel ch. An empty region gives an empty
+	// result.
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Src>, ValueType>
+	[[nodiscard]]
+	auto get(const Src& src, channel_idx ch, ads::region region) const -> minmax<ValueType> {
+		check_source("get", src);
+		detail::stats::check_region("minmax_index::get", src, region);
+		if (ch >= channel_count_) {
+			throw std::out_of_range{std::format("ads::minmax_index::get(): Channel {} is out of range (channel count = {})", ch.value, channel_count_)};
+		}
+		const auto beg   = static_cast<uint64_t>(region.beg.value);
+		const auto end   = static_cast<uint64_t>(region.end.value);
+		const auto first = (beg + BlockSize - 1) / BlockSize;
+		const auto last  = end / BlockSize;
+		if (first >= last) {
+			return scan(src, ch, beg, end);
+		}
+		const auto level = static_cast<uint64_t>(std::bit_width(last - first)) - 1;
+		auto out = scan(src, ch, beg, first * BlockSize);
+		out.merge(scan(src, ch, last * BlockSize, end));
+		out.merge(entry(ch, level, first));
+		out.merge(entry(ch, level, last - (uint64_t{1} << level)));
+		return out;
+	}
+	// The min/max of region across every channel.
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Src>, ValueType>
+	[[nodiscard]]
+	auto get(const Src& src, ads::region region) const -> minmax<ValueType> {
+		auto out = minmax<ValueType>{};
+		for (ads::channel_idx ch = {0}; ch < channel_count_; ch++) {
+			out.merge(get(src, ch, region));
+		}
+		return out;
+	}
+	// Discards the index and builds it again for the current size of src.
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Src>, ValueType>
+	auto rebuild(const Src& src) -> void {
+		channel_count_ = src.get_channel_count().value;
+		frame_count_   = src.get_frame_count().value;
+		block_count_   = (frame_count_ + BlockSize - 1) / BlockSize;
+		level_count_   = block_count_ == 0 ? 0 : static_cast<uint64_t>(std::bit_width(block_count_));
+		table_.assign(channel_count_ * level_count_ * block_count_, {});
+		update(src, {frame_idx{0}, frame_idx{static_cast<int64_t>(frame_count_)}});
+	}
+	// Updates the index after region of src has been rewritten.
+	template <typename Src>
+		requires concepts::is_channel_data<Src> && std::same_as<concepts::channel_value_t<Src>, ValueType>
+	auto update(const Src& src, ads::region region) -> void {
+		check_source("update", src);
+		detail::stats::check_region("minmax_index::update", src, region);
+		if (region.size() == 0) {
+			return;
+		}
+		const auto first = static_cast<uint64_t>(region.beg.value) / BlockSize;
+		const auto last  = (static_cast<uint64_t>(region.end.value) + BlockSize - 1) / BlockSize;
+		for (ads::channel_idx ch = {0}; ch < channel_count_; ch++) {
+			for (auto b = first; b < last; b++) {
+				const auto beg = b * BlockSize;
+				entry(ch, 0, b) = scan(src, ch, beg, std::min(beg + BlockSize, frame_count_));
+			}
+			for (uint64_t level = 1; level < level_count_; level++) {
+				const auto half = uint64_t{1} << (level - 1);
+				const auto run  = half * 2;
+				const auto beg  = first + 1 > run ? first + 1 - run : 0;
+				const auto end  = std::min(last, block_count_ - run + 1);
+				for (auto b = beg; b < end; b++) {
+					auto value = entry(ch, level - 1, b);
+					value.merge(entry(ch, level - 1, b + half));
+					entry(ch, level, b) = value;
+				}
+			}
+		}
+	}
+private:
+	template <typename Src>
+	auto check_source(const char* fn, const Src& src) const -> void {
+		if (src.get_channel_count() != channel_count_ || src.get_frame_count() != frame_count_) {
+			throw std::invalid_argument{std::format("ads::minmax_index::{}(): Source size mismatch ({}x{} != {}x{})", fn, src.get_channel_count().value, src.get_frame_count().value, channel_count_, frame_count_)};
+		}
+	}
+	template <typename Src> [[nodiscard]] static
+	auto scan(const Src& src, channel_idx ch, uint64_t beg, uint64_t end) -> minmax<ValueType> {
+		auto s = stats<ValueType>{};
+		detail::stats::accumulate(static_cast<const ValueType*>(src.data(ch)) + beg, end - beg, std::numeric_limits<ValueType>::max(), s);
+		return {s.min, s.max};
+	}
+	[[nodiscard]] auto entry(channel_idx ch, uint64_t level, uint64_t block) -> minmax<ValueType>& {
+		return table_[(ch.value * level_count_ + level) * block_count_ + block];
+	}
+	[[nodiscard]] auto entry(channel_idx ch, uint64_t level, uint64_t block) const -> const minmax<ValueType>& {
+		return table_[(ch.value * level_count_ + level) * block_count_ + block];
+	}
+	uint64_t channel_count_ = 0;
+	uint64_t frame_count_   = 0;
+	uint64_t block_count_   = 0;
+	uint64_t level_count_   = 0;
+	// Channel by channel, then level by level, one entry per block. The
+	// last 2^level - 1 entries of each level are unused.
+	std::vector<minmax<ValueType>> table_;
+};
+
+} // namespace ads
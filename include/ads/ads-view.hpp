@@ -0,0 +1,416 @@
+#pragma once
+
+#include "ads.hpp"
+
+namespace ads {
+
+namespace detail {
+
+template <typename ElementType>
+struct view_channel_iterator {
+	using iterator_category = std::random_access_iterator_tag;
+	using value_type        = channel_span<ElementType>;
+	using difference_type   = int64_t;
+	using reference         = value_type;
+	ElementType* const* pos = nullptr;
+	uint64_t frames         = 0;
+	[[nodiscard]] auto operator*() const -> value_type                 { return {*pos, frames}; }
+	[[nodiscard]] auto operator[](int64_t n) const -> value_type       { return {pos[n], frames}; }
+	auto operator++() -> view_channel_iterator&                        { ++pos; return *this; }
+	auto operator--() -> view_channel_iterator&                        { --pos; return *this; }
+	auto operator++(int) -> view_channel_iterator                      { auto copy = *this; ++pos; return copy; }
+	auto operator--(int) -> view_channel_iterator                      { auto copy = *this; --pos; return copy; }
+	auto operator+=(int64_t n) -> view_channel_iterator&               { pos += n; return *this; }
+	auto operator-=(int64_t n) -> view_channel_iterator&               { pos -= n; return *this; }
+	[[nodiscard]] auto operator+(int64_t n) const -> view_channel_iterator { return {pos + n, frames}; }
+	[[nodiscard]] auto operator-(int64_t n) const -> view_channel_iterator { return {pos - n, frames}; }
+	[[nodiscard]] auto operator-(const view_channel_iterator& other) const -> difference_type { return pos - other.pos; }
+	[[nodiscard]] auto operator==(const view_channel_iterator& other) const -> bool { return pos == other.pos; }
+	[[nodiscard]] auto operator<=>(const view_channel_iterator& other) const { return pos <=> other.pos; }
+	[[nodiscard]] friend auto operator+(int64_t n, const view_channel_iterator& it) -> view_channel_iterator { return it + n; }
+};
+
+// Models the same storage interface as detail::storage, so all of the
+// generic detail functions work on views. ElementType is const for a
+// read-only view. Views are bounds-checked according to the default
+// policy.
+template <typename ElementType, uint64_t Chs, uint64_t Frs>
+struct view_storage {
+	static constexpr auto CHANNEL_COUNT = Chs;
+	static constexpr auto FRAME_COUNT   = Frs;
+	using value_type             = std::remove_const_t<ElementType>;
+	using element_type           = ElementType;
+	using policy                 = default_policy;
+	using channel_ref            = channel_span<ElementType>;
+	using const_channel_ref      = channel_span<const value_type>;
+	using channel_iterator       = view_channel_iterator<ElementType>;
+	using const_channel_iterator = view_channel_iterator<const value_type>;
+	using channels_type          = channel_pointers_t<ElementType*, Chs>;
+	channels_type channels = {};
+	uint64_t frame_count   = Frs == DYNAMIC_EXTENT ? 0 : Frs;
+	[[nodiscard]] auto size() const -> size_t                          { return channels.size(); }
+	[[nodiscard]] auto empty() const -> bool                           { return channels.empty(); }
+	[[nodiscard]] auto operator[](size_t c) -> channel_ref             { return {channels[c], frame_count}; }
+	[[nodiscard]] auto operator[](size_t c) const -> const_channel_ref { return {channels[c], frame_count}; }
+	[[nodiscard]] auto front() -> channel_ref                          { return (*this)[0]; }
+	[[nodiscard]] auto front() const -> const_channel_ref              { return (*this)[0]; }
+	[[nodiscard]] auto begin() -> channel_iterator                     { return {channels.data(), frame_count}; }
+	[[nodiscard]] auto end() -> channel_iterator                       { return {channels.data() + channels.size(), frame_count}; }
+	[[nodiscard]] auto begin() const -> const_channel_iterator         { return {channels.data(), frame_count}; }
+	[[nodiscard]] auto end() const -> const_channel_iterator           { return {channels.data() + channels.size(), frame_count}; }
+	[[nodiscard]] auto cbegin() const -> const_channel_iterator        { return begin(); }
+	[[nodiscard]] auto cend() const -> const_channel_iterator          { return end(); }
+	[[nodiscard]]
+	auto at(size_t c) -> channel_ref {
+		if (c >= size()) { throw std::out_of_range{std::format("ads::detail::view_storage::at() channel {} is out of range (size = {})", c, size())}; }
+		return (*this)[c];
+	}
+	[[nodiscard]]
+	auto at(size_t c) const -> const_channel_ref {
+		if (c >= size()) { throw std::out_of_range{std::format("ads::detail::view_storage::at() channel {} is out of range (size = {})", c, size())}; }
+		return (*this)[c];
+	}
+};
+
+[[nodiscard]] constexpr auto is_compatible_extent(uint64_t to, uint64_t from) -> bool { return to == DYNAMIC_EXTENT || from == DYNAMIC_EXTENT || to == from; }
+[[nodiscard]] constexpr auto is_narrowing(uint64_t to, uint64_t from) -> bool         { return to != DYNAMIC_EXTENT && from == DYNAMIC_EXTENT; }
+
+template <typename ElementType, uint64_t Chs, uint64_t Frs>
+struct view_impl {
+	static constexpr auto IS_CONST = std::is_const_v<ElementType>;
+	using value_type     = std::remove_const_t<ElementType>;
+	using storage_type   = view_storage<ElementType, Chs, Frs>;
+	using frame_iterator = frame_iterator_base<storage_type, IS_CONST>;
+	view_impl() = default;
+	// Views a list of channel pointers which each point to at least
+	// frame_count frames.
+	view_impl(std::span<ElementType* const> channels, ads::frame_count frame_count) {
+		set_frame_count(frame_count);
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			if (channels.size() > SANE_NUMBER_OF_CHANNELS) {
+				throw std::invalid_argument{std::format("ads::view: Channel count {} is too high", channels.size())};
+			}
+			st_.channels.assign(channels.begin(), channels.end());
+		}
+		else {
+			if (channels.size() != Chs) {
+				throw std::invalid_argument{std::format("ads::view: Expected {} channels but got {}", Chs, channels.size())};
+			}
+			std::ranges::copy(channels, st_.channels.begin());
+		}
+	}
+	// Views channel_count channels in one buffer, each beginning stride
+	// frames after the last.
+	view_impl(ElementType* base, ads::channel_count channel_count, ads::frame_count frame_count, uint64_t stride) {
+		set_frame_count(frame_count);
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			if (channel_count.value > SANE_NUMBER_OF_CHANNELS) {
+				throw std::invalid_argument{std::format("ads::view: Channel count {} is too high", channel_count.value)};
+			}
+			st_.channels.resize(channel_count.value);
+		}
+		else if (channel_count.value != Chs) {
+			throw std::invalid_argument{std::format("ads::view: Expected {} channels but got {}", Chs, channel_count.value)};
+		}
+		for (uint64_t c = 0; c < channel_count.value; c++) {
+			st_.channels[c] = base + c * stride;
+		}
+	}
+	view_impl(ElementType* base, ads::channel_count channel_count, ads::frame_count frame_count)
+		: view_impl{base, channel_count, frame_count, frame_count.value}
+	{}
+	// Conversion is implicit unless a dynamic extent is being narrowed
+	// to a fixed one, in which case it is checked at runtime (the same
+	// as std::span.)
+	template <uint64_t DataChs, uint64_t DataFrs, typename Policy>
+		requires (!IS_CONST && is_compatible_extent(Chs, DataChs) && is_compatible_extent(Frs, DataFrs))
+	explicit(is_narrowing(Chs, DataChs) || is_narrowing(Frs, DataFrs))
+	view_impl(impl<value_type, DataChs, DataFrs, Policy>& data) {
+		init_from(data);
+	}
+	template <uint64_t DataChs, uint64_t DataFrs, typename Policy>
+		requires (IS_CONST && is_compatible_extent(Chs, DataChs) && is_compatible_extent(Frs, DataFrs))
+	explicit(is_narrowing(Chs, DataChs) || is_narrowing(Frs, DataFrs))
+	view_impl(const impl<value_type, DataChs, DataFrs, Policy>& data) {
+		init_from(data);
+	}
+	// A view converts to a const view.
+	template <typename OtherElementType, uint64_t OtherChs, uint64_t OtherFrs>
+		requires (
+			!std::is_same_v<view_impl, view_impl<OtherElementType, OtherChs, OtherFrs>> &&
+			std::is_convertible_v<OtherElementType(*)[], ElementType(*)[]> &&
+			is_compatible_extent(Chs, OtherChs) &&
+			is_compatible_extent(Frs, OtherFrs))
+	explicit(is_narrowing(Chs, OtherChs) || is_narrowing(Frs, OtherFrs))
+	view_impl(const view_impl<OtherElementType, OtherChs, OtherFrs>& other) {
+		init_from(other);
+	}
+	[[nodiscard]] constexpr
+	auto get_channel_count() const -> channel_count {
+		if constexpr (Chs == DYNAMIC_EXTENT) { return detail::get_channel_count(st_); }
+		else                                 { return {Chs}; }
+	}
+	[[nodiscard]] constexpr
+	auto get_frame_count() const -> frame_count {
+		if constexpr (Frs == DYNAMIC_EXTENT) { return {st_.frame_count}; }
+		else                                 { return {Frs}; }
+	}
+	// Returns a view of the frames in the region, without copying.
+	[[nodiscard]]
+	auto slice(ads::region region) const -> view_impl<ElementType, Chs, DYNAMIC_EXTENT> {
+		if (region.beg.value < 0 || region.end < region.beg || region.end > get_frame_count()) {
+			throw std::out_of_range{std::format("ads::view::slice() region [{}, {}) is out of range (frame count = {})", region.beg.value, region.end.value, get_frame_count().value)};
+		}
+		auto channels = st_.channels;
+		for (auto& channel : channels) {
+			channel += region.beg.value;
+		}
+		return {std::span<ElementType* const>{channels.data(), channels.size()}, region.size()};
+	}
+	[[nodiscard]] auto at(channel_idx ch) -> channel_span<ElementType>                 { return detail::at(st(), ch); }
+	[[nodiscard]] auto at(channel_idx ch) const -> channel_span<const value_type>      { return detail::at(st_, ch); }
+	[[nodiscard]] auto at(channel_idx ch, frame_idx f) -> ElementType&                 { return detail::at(st(), ch, f); }
+	[[nodiscard]] auto at(channel_idx ch, frame_idx f) const -> const value_type       { return detail::at(st_, ch, f); }
+	[[nodiscard]] auto at(channel_idx ch, double f) const -> value_type                { return detail::at(st_, ch, f); }
+	[[nodiscard]] auto at_unchecked(channel_idx ch) -> channel_span<ElementType>            { return detail::at_unchecked(st(), ch); }
+	[[nodiscard]] auto at_unchecked(channel_idx ch) const -> channel_span<const value_type> { return detail::at_unchecked(st_, ch); }
+	[[nodiscard]] auto at_unchecked(channel_idx ch, frame_idx f) -> ElementType&            { return detail::at_unchecked(st(), ch, f); }
+	[[nodiscard]] auto at_unchecked(channel_idx ch, frame_idx f) const -> const value_type& { return detail::at_unchecked(st_, ch, f); }
+	[[nodiscard]] auto begin() -> frame_iterator                                       { return {st_}; }
+	[[nodiscard]] auto end() -> frame_iterator                                         { return {}; }
+	[[nodiscard]] auto begin() const -> const_frame_iterator<storage_type>             { return {st_}; }
+	[[nodiscard]] auto end() const -> const_frame_iterator<storage_type>               { return {}; }
+	[[nodiscard]] auto cbegin() const -> const_frame_iterator<storage_type>            { return {st_}; }
+	[[nodiscard]] auto cend() const -> const_frame_iterator<storage_type>              { return {}; }
+	[[nodiscard]] auto channels_begin() -> typename storage_type::channel_iterator     { return std::begin(st_); }
+	[[nodiscard]] auto channels_end()   -> typename storage_type::channel_iterator     { return std::end(st_); }
+	[[nodiscard]] auto channels_begin() const                                          { return std::cbegin(st_); }
+	[[nodiscard]] auto channels_end() const                                            { return std::cend(st_); }
+	[[nodiscard]] auto channels_cbegin() const                                         { return std::cbegin(st_); }
+	[[nodiscard]] auto channels_cend() const                                           { return std::cend(st_); }
+	[[nodiscard]] auto data(channel_idx ch) -> ElementType*                            { return detail::data(st(), ch); }
+	[[nodiscard]] auto data(channel_idx ch) const -> const value_type*                 { return detail::data(st_, ch); }
+	[[nodiscard]] auto at() -> channel_span<ElementType>                requires (concepts::is_mono_data<Chs>) { return detail::at(st(), channel_idx{0}); }
+	[[nodiscard]] auto at() const -> channel_span<const value_type>     requires (concepts::is_mono_data<Chs>) { return detail::at(st_, channel_idx{0}); }
+	[[nodiscard]] auto data() -> ElementType*                           requires (concepts::is_mono_data<Chs>) { return detail::data(st(), channel_idx{0}); }
+	[[nodiscard]] auto data() const -> const value_type*                requires (concepts::is_mono_data<Chs>) { return detail::data(st_, channel_idx{0}); }
+	[[nodiscard]] auto at(frame_idx f) -> ElementType&                  requires (concepts::is_mono_data<Chs>) { return detail::at(st(), channel_idx{0}, f); }
+	[[nodiscard]] auto at(frame_idx f) const -> const value_type&       requires (concepts::is_mono_data<Chs>) { return detail::at(st_, channel_idx{0}, f); }
+	[[nodiscard]] auto at(double f) const -> value_type                 requires (concepts::is_mono_data<Chs>) { return detail::at(st_, channel_idx{0}, f); }
+	template <typename Fn>
+		requires concepts::is_value_visitor_fn<value_type, Fn>
+	auto visit(Fn fn) const -> void {
+		detail::visit(st_, fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename Fn>
+		requires concepts::is_block_visitor_fn<value_type, Fn>
+	auto visit_blocks(Fn fn) const -> void {
+		detail::visit_blocks<BlockSize>(st_, fn);
+	}
+	template <uint64_t BlockSize = 65536, typename Fn>
+		requires concepts::is_block_visitor_fn<value_type, Fn>
+	auto visit_blocks_parallel(Fn fn, unsigned thread_count = 0) const -> void {
+		detail::visit_blocks_parallel<BlockSize>(st_, fn, thread_count);
+	}
+	auto set(frame_idx f, frame_t<value_type, Chs> value) -> void requires (!IS_CONST) {
+		auto pos = std::begin(value);
+		for (size_t c = 0; c < detail::get_channel_count(st_).value; c++) {
+			detail::set(st_, channel_idx{c}, f, *pos++);
+		}
+	}
+	auto set(channel_idx ch, frame_idx f, value_type value) -> void requires (!IS_CONST) {
+		detail::set(st_, ch, f, value);
+	}
+	auto set_unchecked(channel_idx ch, frame_idx f, value_type value) -> void requires (!IS_CONST) {
+		detail::at_unchecked(st_, ch, f) = value;
+	}
+	auto fill(value_type value) -> void requires (!IS_CONST) {
+		detail::fill(st_, value);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<value_type, ReadFn>
+	auto read(ReadFn read_fn) const -> frame_count {
+		return detail::read(st_, frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<value_type, ReadFn>
+	auto read(frame_idx start, ReadFn read_fn) const -> frame_count {
+		return detail::read(st_, start, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<value_type, ReadFn>
+	auto read(frame_count n, ReadFn read_fn) const -> frame_count {
+		return detail::read(st_, frame_idx{0}, n, read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<value_type, ReadFn>
+	auto read(frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return detail::read(st_, start, n, read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<value_type, ReadFn>
+	auto read(channel_idx ch, ReadFn read_fn) const -> frame_count {
+		return detail::read(st_, ch, frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<value_type, ReadFn>
+	auto read(channel_idx ch, frame_idx start, ReadFn read_fn) const -> frame_count {
+		return detail::read(st_, ch, start, get_frame_count(), read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<value_type, ReadFn>
+	auto read(channel_idx ch, frame_count n, ReadFn read_fn) const -> frame_count {
+		return detail::read(st_, ch, frame_idx{0}, n, read_fn);
+	}
+	template <typename ReadFn>
+		requires concepts::is_read_fn<value_type, ReadFn>
+	auto read(channel_idx ch, frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return detail::read(st_, ch, start, n, read_fn);
+	}
+	// Copies from another view (or anything which converts to one, such
+	// as ads::data) with the same number of channels.
+	auto write(frame_idx start, const view_impl<const value_type, DYNAMIC_EXTENT, DYNAMIC_EXTENT>& src) -> frame_count requires (!IS_CONST) {
+		if (src.get_channel_count() != get_channel_count()) {
+			throw std::invalid_argument{std::format("ads::view::write() channel count mismatch ({} != {})", src.get_channel_count().value, get_channel_count().value)};
+		}
+		return detail::write(st_, start, src.get_frame_count(), [&src](value_type* buffer, channel_idx ch, frame_idx frame_start, ads::frame_count frame_count) {
+			std::copy_n(src.data(ch), frame_count.value, buffer);
+			return frame_count;
+		});
+	}
+	auto write(const view_impl<const value_type, DYNAMIC_EXTENT, DYNAMIC_EXTENT>& src) -> frame_count requires (!IS_CONST) {
+		return write(frame_idx{0}, src);
+	}
+	template <typename WriteFn>
+		requires (!IS_CONST && concepts::is_write_fn<value_type, WriteFn>)
+	auto write(WriteFn write_fn) -> frame_count {
+		return detail::write(st_, frame_idx{0}, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires (!IS_CONST && concepts::is_write_fn<value_type, WriteFn>)
+	auto write(frame_count n, WriteFn write_fn) -> frame_count {
+		return detail::write(st_, frame_idx{0}, n, write_fn);
+	}
+	template <typename WriteFn>
+		requires (!IS_CONST && concepts::is_write_fn<value_type, WriteFn>)
+	auto write(frame_idx start, WriteFn write_fn) -> frame_count {
+		return detail::write(st_, start, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires (!IS_CONST && concepts::is_write_fn<value_type, WriteFn>)
+	auto write(frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
+		return detail::write(st_, start, n, write_fn);
+	}
+	template <typename WriteFn>
+		requires (!IS_CONST && concepts::is_write_fn<value_type, WriteFn>)
+	auto write(channel_idx ch, WriteFn write_fn) -> frame_count {
+		return detail::write(st_, ch, frame_idx{0}, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires (!IS_CONST && concepts::is_write_fn<value_type, WriteFn>)
+	auto write(channel_idx ch, frame_count n, WriteFn write_fn) -> frame_count {
+		return detail::write(st_, ch, frame_idx{0}, n, write_fn);
+	}
+	template <typename WriteFn>
+		requires (!IS_CONST && concepts::is_write_fn<value_type, WriteFn>)
+	auto write(channel_idx ch, frame_idx start, WriteFn write_fn) -> frame_count {
+		return detail::write(st_, ch, start, get_frame_count(), write_fn);
+	}
+	template <typename WriteFn>
+		requires (!IS_CONST && concepts::is_write_fn<value_type, WriteFn>)
+	auto write(channel_idx ch, frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
+		return detail::write(st_, ch, start, n, write_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename ReadFn>
+		requires concepts::is_block_read_fn<value_type, ReadFn>
+	auto read_blocks(ReadFn read_fn) const -> frame_count {
+		return detail::read_blocks<BlockSize>(st_, frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename ReadFn>
+		requires concepts::is_block_read_fn<value_type, ReadFn>
+	auto read_blocks(frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return detail::read_blocks<BlockSize>(st_, start, n, read_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename WriteFn>
+		requires (!IS_CONST && concepts::is_block_write_fn<value_type, WriteFn>)
+	auto write_blocks(WriteFn write_fn) -> frame_count {
+		return detail::write_blocks<BlockSize>(st_, frame_idx{0}, get_frame_count(), write_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename WriteFn>
+		requires (!IS_CONST && concepts::is_block_write_fn<value_type, WriteFn>)
+	auto write_blocks(frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
+		return detail::write_blocks<BlockSize>(st_, start, n, write_fn);
+	}
+private:
+	// Mutable access to the storage, unless this is a const view.
+	[[nodiscard]] auto st() -> std::conditional_t<IS_CONST, const storage_type&, storage_type&> { return st_; }
+	auto set_frame_count(ads::frame_count frame_count) -> void {
+		if constexpr (Frs == DYNAMIC_EXTENT) {
+			if (frame_count.value > SANE_NUMBER_OF_FRAMES) {
+				throw std::invalid_argument{std::format("ads::view: Frame count {} is too high", frame_count.value)};
+			}
+			st_.frame_count = frame_count.value;
+		}
+		else if (frame_count.value != Frs) {
+			throw std::invalid_argument{std::format("ads::view: Expected {} frames but got {}", Frs, frame_count.value)};
+		}
+	}
+	template <typename Src>
+	auto init_from(Src& src) -> void {
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			st_.channels.resize(src.get_channel_count().value);
+		}
+		else if (src.get_channel_count() != Chs) {
+			throw std::invalid_argument{std::format("ads::view: Expected {} channels but got {}", Chs, src.get_channel_count().value)};
+		}
+		if constexpr (Frs != DYNAMIC_EXTENT) {
+			if (src.get_frame_count() != Frs) {
+				throw std::invalid_argument{std::format("ads::view: Expected {} frames but got {}", Frs, src.get_frame_count().value)};
+			}
+		}
+		for (ads::channel_idx ch = {0}; ch < src.get_channel_count(); ch++) {
+			st_.channels[ch.value] = src.data(ch);
+		}
+		if constexpr (Frs == DYNAMIC_EXTENT) {
+			st_.frame_count = src.get_frame_count().value;
+		}
+	}
+	storage_type st_;
+};
+
+} // namespace detail
+
+// Non-owning views of channel data, with the same extent model as
+// ads::data. Copying a view never copies the audio.
+template <typename ValueType, uint64_t Chs = DYNAMIC_EXTENT, uint64_t Frs = DYNAMIC_EXTENT> using view       = detail::view_impl<ValueType, Chs, Frs>;
+template <typename ValueType, uint64_t Chs = DYNAMIC_EXTENT, uint64_t Frs = DYNAMIC_EXTENT> using const_view = detail::view_impl<const ValueType, Chs, Frs>;
+
+template <typename ElementType, uint64_t Chs, uint64_t Frs> [[nodiscard]] auto as_channel_range(detail::view_impl<ElementType, Chs, Frs>& v)       { return std::ranges::subrange(v.channels_begin(), v.channels_end()); }
+template <typename ElementType, uint64_t Chs, uint64_t Frs> [[nodiscard]] auto as_channel_range(const detail::view_impl<ElementType, Chs, Frs>& v) { return std::ranges::subrange(v.channels_cbegin(), v.channels_cend()); }
+
+template <typename ElementType, uint64_t Chs, uint64_t Frs, typename OutputIterator>
+auto interleave(const detail::view_impl<ElementType, Chs, Frs>& input, OutputIterator output) -> void {
+	interleave(as_channel_range(input), output);
+}
+
+template <typename ElementType, uint64_t Chs, uint64_t Frs>
+auto interleave(const detail::view_impl<ElementType, Chs, Frs>& input, interleaved<std::remove_const_t<ElementType>>& output) -> frame_count {
+	if (input.get_channel_count() != output.get_channel_count()) {
+		throw std::invalid_argument{std::format("ads::interleave(): Channel count mismatch ({} != {})", input.get_channel_count().value, output.get_channel_count().value)};
+	}
+	const auto frame_count = std::min(input.get_frame_count(), output.get_frame_count());
+	detail::interleave<Chs>(detail::get_channel_pointers(input).data(), input.get_channel_count().value, frame_count.value, output.data());
+	return frame_count;
+}
+
+template <typename ValueType, uint64_t Chs, uint64_t Frs>
+auto deinterleave(const interleaved<ValueType>& input, view<ValueType, Chs, Frs> output) -> frame_count {
+	if (input.get_channel_count() != output.get_channel_count()) {
+		throw std::invalid_argument{std::format("ads::deinterleave(): Channel count mismatch ({} != {})", input.get_channel_count().value, output.get_channel_count().value)};
+	}
+	const auto frame_count = std::min(input.get_frame_count(), output.get_frame_count());
+	detail::deinterleave<Chs>(input.data(), output.get_channel_count().value, frame_count.value, detail::get_channel_pointers(output).data());
+	return frame_count;
+}
+
+} // namespace ads
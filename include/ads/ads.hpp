@@ -1,16 +1,27 @@
 #pragma once
 
 #include "ads-concepts-fns.hpp"
+#include "ads-simd.hpp"
 #include <algorithm>
 #include <array>
-#include <boost/align/aligned_allocator.hpp>
+#include <atomic>
+#include <bit>
 #include <boost/container/small_vector.hpp>
 #include <cmath>
+#include <cstddef>
+#include <exception>
 #include <format>
 #include <limits>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <optional>
 #include <ranges>
+#include <scoped_allocator>
 #include <span>
 #include <stdexcept>
+#include <thread>
 #include <vector>
 
 namespace ads {
@@ -30,6 +41,98 @@ template <typename ValueType, uint64_t Chs>             struct frame_ref<ValueTy
 template <typename ValueType, uint64_t Chs>             struct frame_ref<ValueType, Chs, true>             { using type = std::array<const ValueType*, Chs>; };
 template <typename ValueType, uint64_t Chs, bool Const> using frame_ref_t = typename frame_ref<ValueType, Chs, Const>::type;
 
+namespace layout {
+
+// Each channel is stored in its own separately allocated buffer.
+struct separate {};
+
+// All channels share one contiguous allocation with a fixed stride
+// between the start of each channel. This only changes anything when
+// the frame count is dynamic, because storage with a compile-time
+// frame count is already contiguous.
+struct planar {};
+
+// Each channel is a separately allocated, reference-counted buffer.
+// Copying the data only copies the references, and a channel is copied
+// the first time it is written to while it is still shared. Like
+// planar, this only applies when the frame count is dynamic.
+struct shared {};
+
+} // namespace layout
+
+namespace bounds {
+
+// Out of range channel or frame indices throw std::out_of_range.
+struct checked {};
+// Out of range indices are caught by assert() in debug builds only.
+struct debug {};
+// Indices are never checked.
+struct unchecked {};
+
+} // namespace bounds
+
+// The bounds checking of ads::data types which use the default policy,
+// e.g. -DADS_DEFAULT_BOUNDS_CHECK=unchecked
+#if !defined(ADS_DEFAULT_BOUNDS_CHECK)
+#	define ADS_DEFAULT_BOUNDS_CHECK checked
+#endif
+
+struct default_policy {
+	using layout = ads::layout::separate;
+	// Byte alignment of the first sample of each channel. For storage
+	// with a compile-time frame count this is the alignment of the
+	// storage as a whole, unless channel_padding is also set.
+	static constexpr size_t alignment = 16;
+	// If non-zero, each channel's buffer is padded out to a whole
+	// multiple of this many bytes. The padding is allocated memory which
+	// SIMD kernels may read and write past the last frame, and channels
+	// which are padded to a cache line never share one.
+	static constexpr size_t channel_padding = 0;
+	// Allocator for dynamic storage. It is rebound to whatever is being
+	// allocated, and alignment and padding are applied on top of it, so
+	// any standard-conforming allocator will do.
+	using allocator = std::allocator<std::byte>;
+	// Applies to at(), set() and data(). The unchecked accessors and
+	// frame iteration are never checked.
+	using bounds_check = ads::bounds::ADS_DEFAULT_BOUNDS_CHECK;
+};
+
+struct planar_policy : default_policy {
+	using layout = ads::layout::planar;
+};
+
+struct shared_policy : default_policy {
+	using layout = ads::layout::shared;
+};
+
+template <typename Base, typename Allocator>
+struct with_allocator : Base {
+	using allocator = Allocator;
+};
+
+template <typename Base, typename BoundsCheck>
+struct with_bounds_check : Base {
+	using bounds_check = BoundsCheck;
+};
+
+// e.g. ads::with_alignment<ads::planar_policy, 64> aligns and pads every
+// channel to a 64-byte cache line.
+template <typename Base, size_t Alignment, size_t Padding = Alignment>
+struct with_alignment : Base {
+	static constexpr size_t alignment       = Alignment;
+	static constexpr size_t channel_padding = Padding;
+};
+
+namespace pmr {
+
+// Storage is allocated from a std::pmr::memory_resource, e.g.
+// ads::make<float, ads::pmr::policy>(ads::channel_count{2}, ads::frame_count{512}, &arena);
+using policy        = with_allocator<default_policy, std::pmr::polymorphic_allocator<std::byte>>;
+using planar_policy = with_allocator<ads::planar_policy, std::pmr::polymorphic_allocator<std::byte>>;
+using shared_policy = with_allocator<ads::shared_policy, std::pmr::polymorphic_allocator<std::byte>>;
+
+} // namespace pmr
+
 template <typename T, typename ValueType>
 concept is_frame_ref =
 	std::same_as<std::ranges::range_value_t<T>, ValueType*> ||
@@ -42,26 +145,530 @@ namespace detail {
 static constexpr auto SANE_NUMBER_OF_CHANNELS = 1024ULL;
 static constexpr auto SANE_NUMBER_OF_FRAMES   = 44100ULL * 604800ULL; // 1 week of audio at 44100 Hz
 
-template <typename ValueType, uint64_t Frs> struct channel_data                            { using type = std::array<ValueType, Frs>; };
-template <typename ValueType>               struct channel_data<ValueType, DYNAMIC_EXTENT> { using type = std::vector<ValueType, boost::alignment::aligned_allocator<ValueType, 16>>; };
-template <typename ValueType, uint64_t Frs> using channel_data_t = channel_data<ValueType, Frs>::type;
+[[nodiscard]] constexpr
+auto round_up(uint64_t value, uint64_t multiple) -> uint64_t {
+	return multiple == 0 ? value : ((value + multiple - 1) / multiple) * multiple;
+}
 
-template <uint64_t Chs, typename ChannelData> struct channels                              { using type = std::array<ChannelData, Chs>; };
-template <typename ChannelData>               struct channels<DYNAMIC_EXTENT, ChannelData> { using type = std::vector<ChannelData>; };
-template <uint64_t Chs, typename ChannelData> using channels_t = typename channels<Chs, ChannelData>::type;
+template <typename ValueType, typename Policy> [[nodiscard]] constexpr
+auto get_alignment() -> size_t {
+	static_assert (std::has_single_bit(Policy::alignment), "Policy::alignment must be a power of two");
+	static_assert (Policy::channel_padding == 0 || std::has_single_bit(Policy::channel_padding), "Policy::channel_padding must be zero or a power of two");
+	return std::max(Policy::alignment, alignof(ValueType));
+}
 
-template <typename ValueType, uint64_t Frs> using channel_iterator_t       = typename channel_data_t<ValueType, Frs>::iterator;
-template <typename ValueType, uint64_t Frs> using const_channel_iterator_t = typename channel_data_t<ValueType, Frs>::const_iterator;
+// Number of frames which fit in a channel buffer once it has been
+// padded according to the policy.
+template <typename ValueType, typename Policy> [[nodiscard]] constexpr
+auto get_padded_frame_count(uint64_t frame_count) -> uint64_t {
+	return round_up(frame_count * sizeof(ValueType), Policy::channel_padding) / sizeof(ValueType);
+}
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs>
-struct storage : channels_t<Chs, channel_data_t<ValueType, Frs>> {
+template <typename Policy, typename T> using rebind_alloc_t = typename std::allocator_traits<typename Policy::allocator>::template rebind_alloc<T>;
+
+// One pointer per channel. A dynamic number of channels is stored inline
+// up to 8 so that typical multichannel layouts never allocate.
+template <typename Pointer, uint64_t Chs> struct channel_pointers                          { using type = std::array<Pointer, Chs>; };
+template <typename Pointer>               struct channel_pointers<Pointer, DYNAMIC_EXTENT> { using type = boost::container::small_vector<Pointer, 8>; };
+template <typename Pointer, uint64_t Chs> using channel_pointers_t = typename channel_pointers<Pointer, Chs>::type;
+
+// Adapts the upstream allocator to hand out memory with the requested
+// alignment, rounded up to the requested padding. Memory is requested
+// from upstream as an array of over-aligned blocks, so the upstream
+// allocator only has to honour alignof() like any other allocator.
+template <typename T, size_t Alignment, size_t Padding, typename Upstream>
+struct aligned_allocator {
+	struct alignas(Alignment) block { std::byte bytes[Alignment]; };
+	using value_type      = T;
+	using upstream_type   = typename std::allocator_traits<Upstream>::template rebind_alloc<block>;
+	using upstream_traits = std::allocator_traits<upstream_type>;
+	using propagate_on_container_copy_assignment = typename upstream_traits::propagate_on_container_copy_assignment;
+	using propagate_on_container_move_assignment = typename upstream_traits::propagate_on_container_move_assignment;
+	using propagate_on_container_swap            = typename upstream_traits::propagate_on_container_swap;
+	using is_always_equal                        = typename upstream_traits::is_always_equal;
+	template <typename U> struct rebind { using other = aligned_allocator<U, Alignment, Padding, Upstream>; };
+	aligned_allocator() = default;
+	aligned_allocator(const Upstream& upstream) noexcept : upstream_{upstream} {}
+	template <typename U> aligned_allocator(const aligned_allocator<U, Alignment, Padding, Upstream>& other) noexcept : upstream_{other.upstream()} {}
+	[[nodiscard]]
+	auto allocate(size_t n) -> T* {
+		return reinterpret_cast<T*>(upstream_traits::allocate(upstream_, get_block_count(n)));
+	}
+	auto deallocate(T* ptr, size_t n) noexcept -> void {
+		upstream_traits::deallocate(upstream_, reinterpret_cast<block*>(ptr), get_block_count(n));
+	}
+	[[nodiscard]]
+	auto select_on_container_copy_construction() const -> aligned_allocator {
+		return {Upstream{upstream_traits::select_on_container_copy_construction(upstream_)}};
+	}
+	[[nodiscard]] auto upstream() const -> const upstream_type& { return upstream_; }
+	[[nodiscard]] friend auto operator==(const aligned_allocator& a, const aligned_allocator& b) -> bool { return a.upstream_ == b.upstream_; }
+private:
+	[[nodiscard]] static
+	auto get_block_count(size_t n) -> size_t {
+		return std::max(round_up(round_up(n * sizeof(T), Padding), Alignment) / Alignment, uint64_t{1});
+	}
+	[[no_unique_address]] upstream_type upstream_;
+};
+
+// Default-initializes elements which are constructed without
+// arguments, so that resize(n) leaves new samples uninitialized and
+// their memory isn't touched until something writes to it. Everything
+// else is passed on to the adapted allocator.
+template <typename Allocator>
+struct default_init_allocator : Allocator {
+	using traits = std::allocator_traits<Allocator>;
+	template <typename U> struct rebind { using other = default_init_allocator<typename traits::template rebind_alloc<U>>; };
+	using Allocator::Allocator;
+	default_init_allocator() = default;
+	default_init_allocator(const Allocator& alloc) noexcept : Allocator{alloc} {}
+	template <typename U> default_init_allocator(const default_init_allocator<U>& other) noexcept : Allocator{static_cast<const U&>(other)} {}
+	[[nodiscard]]
+	auto select_on_container_copy_construction() const -> default_init_allocator {
+		return {traits::select_on_container_copy_construction(*this)};
+	}
+	template <typename U>
+	auto construct(U* ptr) noexcept(std::is_nothrow_default_constructible_v<U>) -> void {
+		::new (static_cast<void*>(ptr)) U;
+	}
+	template <typename U, typename... Args>
+	auto construct(U* ptr, Args&&... args) -> void {
+		traits::construct(static_cast<Allocator&>(*this), ptr, std::forward<Args>(args)...);
+	}
+};
+
+// A compile-time sized channel which is individually aligned, so its
+// size is also rounded up to a multiple of the alignment.
+template <typename ValueType, uint64_t Frs, size_t Alignment>
+struct alignas(Alignment) aligned_array : std::array<ValueType, Frs> {};
+
+template <typename ValueType, uint64_t Frs, typename Policy> struct channel_data {
+	using type = std::conditional_t<Policy::channel_padding == 0,
+		std::array<ValueType, Frs>,
+		aligned_array<ValueType, Frs, std::max(get_alignment<ValueType, Policy>(), Policy::channel_padding)>>;
+};
+template <typename ValueType, typename Policy> struct channel_data<ValueType, DYNAMIC_EXTENT, Policy> {
+	using type = std::vector<ValueType, default_init_allocator<aligned_allocator<ValueType, get_alignment<ValueType, Policy>(), Policy::channel_padding, typename Policy::allocator>>>;
+};
+template <typename ValueType, uint64_t Frs, typename Policy = default_policy> using channel_data_t = channel_data<ValueType, Frs, Policy>::type;
+
+template <typename ChannelData>
+concept is_allocator_aware = requires { typename ChannelData::allocator_type; };
+
+// A dynamic number of channels is a vector of channels. If the channels
+// allocate then the scoped allocator passes the allocator down to them.
+template <uint64_t Chs, typename ChannelData, typename Policy> struct channels { using type = std::array<ChannelData, Chs>; };
+template <typename ChannelData, typename Policy>               struct channels<DYNAMIC_EXTENT, ChannelData, Policy> { using type = std::vector<ChannelData, rebind_alloc_t<Policy, ChannelData>>; };
+template <typename ChannelData, typename Policy> requires is_allocator_aware<ChannelData> struct channels<DYNAMIC_EXTENT, ChannelData, Policy> {
+	using type = std::vector<ChannelData, std::scoped_allocator_adaptor<rebind_alloc_t<Policy, ChannelData>, typename ChannelData::allocator_type>>;
+};
+template <uint64_t Chs, typename ChannelData, typename Policy> using channels_t = typename channels<Chs, ChannelData, Policy>::type;
+
+template <uint64_t Chs, typename ChannelData, typename Policy> using channel_iterator_t       = typename channels_t<Chs, ChannelData, Policy>::iterator;
+template <uint64_t Chs, typename ChannelData, typename Policy> using const_channel_iterator_t = typename channels_t<Chs, ChannelData, Policy>::const_iterator;
+
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy = default_policy>
+struct storage : channels_t<Chs, channel_data_t<ValueType, Frs, Policy>, Policy> {
 	static constexpr auto CHANNEL_COUNT = Chs;
 	static constexpr auto FRAME_COUNT   = Frs;
 	using value_type             = ValueType;
-	using channel_iterator       = channel_iterator_t<ValueType, Frs>;
-	using const_channel_iterator = const_channel_iterator_t<ValueType, Frs>;
+	using policy                 = Policy;
+	using allocator_type         = typename Policy::allocator;
+	using channel_type           = channel_data_t<ValueType, Frs, Policy>;
+	using base_type              = channels_t<Chs, channel_type, Policy>;
+	using channel_ref            = channel_type&;
+	using const_channel_ref      = const channel_type&;
+	using channel_iterator       = channel_iterator_t<Chs, channel_type, Policy>;
+	using const_channel_iterator = const_channel_iterator_t<Chs, channel_type, Policy>;
+	storage() = default;
+	explicit storage(const allocator_type& alloc) : base_type{make_channels(alloc, std::make_index_sequence<Chs == DYNAMIC_EXTENT ? 0 : Chs>{})} {}
+	[[nodiscard]]
+	auto get_allocator() const -> allocator_type {
+		if constexpr (Chs == DYNAMIC_EXTENT)                            { return allocator_type{this->base_type::get_allocator()}; }
+		else if constexpr (is_allocator_aware<channel_type> && Chs > 0) { return allocator_type{this->front().get_allocator().upstream()}; }
+		else                                                            { return allocator_type{}; }
+	}
+	// The number of frames every channel can grow to without reallocating.
+	[[nodiscard]]
+	auto get_frame_capacity() const -> uint64_t {
+		if constexpr (Frs != DYNAMIC_EXTENT) { return Frs; }
+		else {
+			auto capacity = this->empty() ? uint64_t{0} : std::numeric_limits<uint64_t>::max();
+			for (const auto& channel : *this) {
+				capacity = std::min<uint64_t>(capacity, channel.capacity());
+			}
+			return capacity;
+		}
+	}
+	[[nodiscard]]
+	auto get_channel_capacity() const -> uint64_t {
+		if constexpr (Chs == DYNAMIC_EXTENT) { return this->capacity(); }
+		else                                 { return Chs; }
+	}
+	// New channels always allocate their own buffers, unless the frame
+	// count is zero or fixed.
+	[[nodiscard]]
+	auto can_resize(uint64_t channel_count, uint64_t frame_count) const -> bool {
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			if (channel_count > this->capacity()) { return false; }
+		}
+		if constexpr (Frs == DYNAMIC_EXTENT) {
+			if (channel_count > this->size() && frame_count > 0) { return false; }
+			const auto keep_chs = std::min<uint64_t>(channel_count, this->size());
+			for (uint64_t c = 0; c < keep_chs; c++) {
+				if (frame_count > (*this)[c].capacity()) { return false; }
+			}
+		}
+		return true;
+	}
+	auto reserve(uint64_t channel_count, uint64_t frame_count) -> void {
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			this->base_type::reserve(channel_count);
+		}
+		if constexpr (Frs == DYNAMIC_EXTENT) {
+			for (auto& channel : *this) {
+				channel.reserve(frame_count);
+			}
+		}
+	}
+private:
+	template <size_t... Is> [[nodiscard]] static
+	auto make_channels(const allocator_type& alloc, std::index_sequence<Is...>) -> base_type {
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			if constexpr (is_allocator_aware<channel_type>) { return base_type(typename base_type::allocator_type(alloc, alloc)); }
+			else                                            { return base_type(typename base_type::allocator_type(alloc)); }
+		}
+		else if constexpr (is_allocator_aware<channel_type>) { return base_type{(static_cast<void>(Is), channel_type(alloc))...}; }
+		else                                                 { return base_type{}; }
+	}
+};
+
+// std::span with a bounds-checked at(), so that a channel of planar
+// storage can be used anywhere a channel vector can.
+template <typename ValueType>
+struct channel_span : std::span<ValueType> {
+	using std::span<ValueType>::span;
+	[[nodiscard]]
+	auto at(size_t index) const -> ValueType& {
+		if (index >= this->size()) {
+			throw std::out_of_range{std::format("ads::detail::channel_span::at() index {} is out of range (size = {})", index, this->size())};
+		}
+		return (*this)[index];
+	}
+};
+
+template <typename ValueType, bool Const>
+struct planar_channel_iterator_base {
+	using iterator_category = std::random_access_iterator_tag;
+	using element_type      = std::conditional_t<Const, const ValueType, ValueType>;
+	using value_type        = channel_span<element_type>;
+	using difference_type   = int64_t;
+	using reference         = value_type;
+	element_type* base = nullptr;
+	uint64_t stride    = 0;
+	uint64_t frames    = 0;
+	uint64_t channel   = 0;
+	[[nodiscard]] auto operator*() const -> value_type                 { return {base + channel * stride, frames}; }
+	[[nodiscard]] auto operator[](int64_t n) const -> value_type       { return *(*this + n); }
+	auto operator++() -> planar_channel_iterator_base&                 { ++channel; return *this; }
+	auto operator--() -> planar_channel_iterator_base&                 { --channel; return *this; }
+	auto operator++(int) -> planar_channel_iterator_base               { auto copy = *this; ++channel; return copy; }
+	auto operator--(int) -> planar_channel_iterator_base               { auto copy = *this; --channel; return copy; }
+	auto operator+=(int64_t n) -> planar_channel_iterator_base&        { channel += n; return *this; }
+	auto operator-=(int64_t n) -> planar_channel_iterator_base&        { channel -= n; return *this; }
+	[[nodiscard]] auto operator+(int64_t n) const -> planar_channel_iterator_base { auto copy = *this; copy.channel += n; return copy; }
+	[[nodiscard]] auto operator-(int64_t n) const -> planar_channel_iterator_base { auto copy = *this; copy.channel -= n; return copy; }
+	[[nodiscard]] auto operator-(const planar_channel_iterator_base& other) const -> difference_type { return static_cast<int64_t>(channel) - static_cast<int64_t>(other.channel); }
+	[[nodiscard]] auto operator==(const planar_channel_iterator_base& other) const -> bool { return channel == other.channel; }
+	[[nodiscard]] auto operator<=>(const planar_channel_iterator_base& other) const { return channel <=> other.channel; }
+	[[nodiscard]] friend auto operator+(int64_t n, const planar_channel_iterator_base& it) -> planar_channel_iterator_base { return it + n; }
+};
+
+// A single allocation holding every channel, one after another.
+// The stride between channels is the padded frame capacity rounded up so
+// that every channel begins on the same alignment boundary as the buffer.
+// Resizing within the capacity never moves a channel.
+template <typename ValueType, uint64_t Chs, typename Policy = planar_policy>
+struct planar_storage {
+	static constexpr auto CHANNEL_COUNT = Chs;
+	static constexpr auto FRAME_COUNT   = DYNAMIC_EXTENT;
+	static constexpr auto ALIGNMENT     = get_alignment<ValueType, Policy>();
+	using value_type             = ValueType;
+	using policy                 = Policy;
+	using channel_ref            = channel_span<ValueType>;
+	using const_channel_ref      = channel_span<const ValueType>;
+	using channel_iterator       = planar_channel_iterator_base<ValueType, false>;
+	using const_channel_iterator = planar_channel_iterator_base<ValueType, true>;
+	using allocator_type         = typename Policy::allocator;
+	using buffer_type            = std::vector<ValueType, default_init_allocator<aligned_allocator<ValueType, ALIGNMENT, 0, allocator_type>>>;
+	planar_storage() = default;
+	explicit planar_storage(const allocator_type& alloc) : buffer_{typename buffer_type::allocator_type{alloc}} {}
+	[[nodiscard]] auto get_allocator() const -> allocator_type         { return allocator_type{buffer_.get_allocator().upstream()}; }
+	[[nodiscard]] auto size() const -> size_t                          { return channel_count_; }
+	[[nodiscard]] auto empty() const -> bool                           { return channel_count_ == 0; }
+	[[nodiscard]] auto stride() const -> uint64_t                      { return stride_; }
+	[[nodiscard]] auto operator[](size_t c) -> channel_ref             { return {buffer_.data() + c * stride_, frame_count_}; }
+	[[nodiscard]] auto operator[](size_t c) const -> const_channel_ref { return {buffer_.data() + c * stride_, frame_count_}; }
+	[[nodiscard]] auto front() -> channel_ref                          { return (*this)[0]; }
+	[[nodiscard]] auto front() const -> const_channel_ref              { return (*this)[0]; }
+	[[nodiscard]] auto begin() -> channel_iterator                     { return {buffer_.data(), stride_, frame_count_, 0}; }
+	[[nodiscard]] auto end() -> channel_iterator                       { return {buffer_.data(), stride_, frame_count_, size()}; }
+	[[nodiscard]] auto begin() const -> const_channel_iterator         { return {buffer_.data(), stride_, frame_count_, 0}; }
+	[[nodiscard]] auto end() const -> const_channel_iterator           { return {buffer_.data(), stride_, frame_count_, size()}; }
+	[[nodiscard]] auto cbegin() const -> const_channel_iterator        { return begin(); }
+	[[nodiscard]] auto cend() const -> const_channel_iterator          { return end(); }
+	[[nodiscard]]
+	auto at(size_t c) -> channel_ref {
+		if (c >= size()) { throw std::out_of_range{std::format("ads::detail::planar_storage::at() channel {} is out of range (size = {})", c, size())}; }
+		return (*this)[c];
+	}
+	[[nodiscard]]
+	auto at(size_t c) const -> const_channel_ref {
+		if (c >= size()) { throw std::out_of_range{std::format("ads::detail::planar_storage::at() channel {} is out of range (size = {})", c, size())}; }
+		return (*this)[c];
+	}
+	// The number of frames each channel can grow to without moving.
+	[[nodiscard]] auto get_frame_capacity() const -> uint64_t { return frame_capacity_; }
+	[[nodiscard]]
+	auto get_channel_capacity() const -> uint64_t {
+		return stride_ == 0 ? channel_count_ : std::max<uint64_t>(channel_count_, buffer_.capacity() / stride_);
+	}
+	[[nodiscard]]
+	auto can_resize(uint64_t channel_count, uint64_t frame_count) const -> bool {
+		return frame_count <= frame_capacity_ && channel_count * stride_ <= buffer_.capacity();
+	}
+	auto reserve(uint64_t channel_count, uint64_t frame_count) -> void {
+		if (frame_count > frame_capacity_) {
+			relayout(channel_count_, frame_count_, frame_count, std::max(channel_count, channel_count_), ValueType{});
+			return;
+		}
+		buffer_.reserve(channel_count * stride_);
+	}
+	// New frames are set to fill_value, or left uninitialized if there
+	// isn't one.
+	auto resize(uint64_t channel_count, uint64_t frame_count, std::optional<ValueType> fill_value) -> void {
+		if (frame_count > frame_capacity_) {
+			relayout(channel_count, frame_count, frame_count, channel_count, fill_value);
+			return;
+		}
+		// The stride stays the same, so nothing moves. Frames past the end
+		// of each channel are left zeroed, unless they were never
+		// initialized.
+		const auto keep_chs = std::min(channel_count, channel_count_);
+		for (uint64_t c = 0; c < keep_chs; c++) {
+			const auto channel = buffer_.data() + c * stride_;
+			if (frame_count > frame_count_) { if (fill_value) { std::fill(channel + frame_count_, channel + frame_count, *fill_value); } }
+			else                            { std::fill(channel + frame_count, channel + frame_count_, ValueType{}); }
+		}
+		if (!fill_value) {
+			buffer_.resize(channel_count * stride_);
+		}
+		else {
+			buffer_.resize(channel_count * stride_, ValueType{});
+			for (uint64_t c = keep_chs; c < channel_count; c++) {
+				const auto channel = buffer_.data() + c * stride_;
+				std::fill(channel, channel + frame_count, *fill_value);
+			}
+		}
+		channel_count_ = channel_count;
+		frame_count_   = frame_count;
+	}
+private:
+	[[nodiscard]] static
+	auto get_stride(uint64_t frame_count) -> uint64_t {
+		constexpr auto unit = std::lcm(ALIGNMENT, sizeof(ValueType)) / sizeof(ValueType);
+		return round_up(get_padded_frame_count<ValueType, Policy>(frame_count), unit);
+	}
+	// Moves every channel to a new buffer with room for frame_capacity
+	// frames per channel.
+	auto relayout(uint64_t channel_count, uint64_t frame_count, uint64_t frame_capacity, uint64_t channel_capacity, std::optional<ValueType> fill_value) -> void {
+		const auto new_stride = get_stride(frame_capacity);
+		const auto keep_chs   = std::min(channel_count, channel_count_);
+		const auto keep_frs   = std::min(frame_count, frame_count_);
+		buffer_type buffer(buffer_.get_allocator());
+		buffer.reserve(channel_capacity * new_stride);
+		if (fill_value) { buffer.resize(channel_count * new_stride, ValueType{}); }
+		else            { buffer.resize(channel_count * new_stride); }
+		for (uint64_t c = 0; c < channel_count; c++) {
+			const auto dest = buffer.data() + c * new_stride;
+			const auto kept = c < keep_chs ? keep_frs : 0;
+			std::copy_n(buffer_.data() + c * stride_, kept, dest);
+			if (fill_value) {
+				std::fill(dest + kept, dest + frame_count, *fill_value);
+			}
+		}
+		buffer_         = std::move(buffer);
+		channel_count_  = channel_count;
+		frame_count_    = frame_count;
+		frame_capacity_ = frame_capacity;
+		stride_         = new_stride;
+	}
+	buffer_type buffer_;
+	uint64_t channel_count_  = Chs == DYNAMIC_EXTENT ? 0 : Chs;
+	uint64_t frame_count_    = 0;
+	uint64_t frame_capacity_ = 0;
+	uint64_t stride_         = 0;
 };
 
+template <typename ValueType, typename Buffer, bool Const>
+struct shared_channel_iterator_base {
+	using iterator_category = std::random_access_iterator_tag;
+	using element_type      = std::conditional_t<Const, const ValueType, ValueType>;
+	using value_type        = channel_span<element_type>;
+	using difference_type   = int64_t;
+	using reference         = value_type;
+	const std::shared_ptr<Buffer>* pos = nullptr;
+	[[nodiscard]] static auto get(const std::shared_ptr<Buffer>& buffer) -> value_type { return buffer ? value_type{buffer->data(), buffer->size()} : value_type{}; }
+	[[nodiscard]] auto operator*() const -> value_type                 { return get(*pos); }
+	[[nodiscard]] auto operator[](int64_t n) const -> value_type       { return get(pos[n]); }
+	auto operator++() -> shared_channel_iterator_base&                 { ++pos; return *this; }
+	auto operator--() -> shared_channel_iterator_base&                 { --pos; return *this; }
+	auto operator++(int) -> shared_channel_iterator_base               { auto copy = *this; ++pos; return copy; }
+	auto operator--(int) -> shared_channel_iterator_base               { auto copy = *this; --pos; return copy; }
+	auto operator+=(int64_t n) -> shared_channel_iterator_base&        { pos += n; return *this; }
+	auto operator-=(int64_t n) -> shared_channel_iterator_base&        { pos -= n; return *this; }
+	[[nodiscard]] auto operator+(int64_t n) const -> shared_channel_iterator_base { return {pos + n}; }
+	[[nodiscard]] auto operator-(int64_t n) const -> shared_channel_iterator_base { return {pos - n}; }
+	[[nodiscard]] auto operator-(const shared_channel_iterator_base& other) const -> difference_type { return pos - other.pos; }
+	[[nodiscard]] auto operator==(const shared_channel_iterator_base& other) const -> bool { return pos == other.pos; }
+	[[nodiscard]] auto operator<=>(const shared_channel_iterator_base& other) const { return pos <=> other.pos; }
+	[[nodiscard]] friend auto operator+(int64_t n, const shared_channel_iterator_base& it) -> shared_channel_iterator_base { return it + n; }
+};
+
+// Copy-on-write channels. Copying the storage shares every channel
+// buffer, and any non-const access to a channel which is shared copies
+// it first, so the copy costs O(channels) however long the channels are.
+// Const access never copies. As with std::shared_ptr, separate copies
+// can be used from different threads, but one copy can't be written in
+// one thread while it is read or copied in another.
+template <typename ValueType, uint64_t Chs, typename Policy = shared_policy>
+struct shared_storage {
+	static constexpr auto CHANNEL_COUNT = Chs;
+	static constexpr auto FRAME_COUNT   = DYNAMIC_EXTENT;
+	using value_type             = ValueType;
+	using policy                 = Policy;
+	using allocator_type         = typename Policy::allocator;
+	using buffer_type            = channel_data_t<ValueType, DYNAMIC_EXTENT, Policy>;
+	using channel_ref            = channel_span<ValueType>;
+	using const_channel_ref      = channel_span<const ValueType>;
+	using channel_iterator       = shared_channel_iterator_base<ValueType, buffer_type, false>;
+	using const_channel_iterator = shared_channel_iterator_base<ValueType, buffer_type, true>;
+	shared_storage() = default;
+	explicit shared_storage(const allocator_type& alloc) : alloc_{alloc} {}
+	[[nodiscard]] auto get_allocator() const -> allocator_type         { return alloc_; }
+	[[nodiscard]] auto size() const -> size_t                          { return channels_.size(); }
+	[[nodiscard]] auto empty() const -> bool                           { return channels_.empty(); }
+	[[nodiscard]] auto operator[](size_t c) -> channel_ref             { return channel_iterator::get(detach(c)); }
+	[[nodiscard]] auto operator[](size_t c) const -> const_channel_ref { return const_channel_iterator::get(channels_[c]); }
+	[[nodiscard]] auto front() -> channel_ref                          { return (*this)[0]; }
+	[[nodiscard]] auto front() const -> const_channel_ref              { return (*this)[0]; }
+	[[nodiscard]] auto begin() -> channel_iterator                     { detach_all(); return {channels_.data()}; }
+	[[nodiscard]] auto end() -> channel_iterator                       { return {channels_.data() + channels_.size()}; }
+	[[nodiscard]] auto begin() const -> const_channel_iterator         { return {channels_.data()}; }
+	[[nodiscard]] auto end() const -> const_channel_iterator           { return {channels_.data() + channels_.size()}; }
+	[[nodiscard]] auto cbegin() const -> const_channel_iterator        { return begin(); }
+	[[nodiscard]] auto cend() const -> const_channel_iterator          { return end(); }
+	[[nodiscard]]
+	auto at(size_t c) -> channel_ref {
+		if (c >= size()) { throw std::out_of_range{std::format("ads::detail::shared_storage::at() channel {} is out of range (size = {})", c, size())}; }
+		return (*this)[c];
+	}
+	[[nodiscard]]
+	auto at(size_t c) const -> const_channel_ref {
+		if (c >= size()) { throw std::out_of_range{std::format("ads::detail::shared_storage::at() channel {} is out of range (size = {})", c, size())}; }
+		return (*this)[c];
+	}
+	// True if channel c is shared with another copy, i.e. writing to it
+	// would copy it.
+	[[nodiscard]]
+	auto is_shared(size_t c) const -> bool {
+		return channels_[c] && channels_[c].use_count() > 1;
+	}
+	[[nodiscard]]
+	auto get_frame_capacity() const -> uint64_t {
+		auto capacity = channels_.empty() ? uint64_t{0} : std::numeric_limits<uint64_t>::max();
+		for (const auto& channel : channels_) {
+			capacity = std::min<uint64_t>(capacity, channel ? channel->capacity() : 0);
+		}
+		return capacity;
+	}
+	[[nodiscard]]
+	auto get_channel_capacity() const -> uint64_t {
+		if constexpr (Chs == DYNAMIC_EXTENT) { return channels_.capacity(); }
+		else                                 { return Chs; }
+	}
+	// Resizing a channel which is shared always copies it.
+	[[nodiscard]]
+	auto can_resize(uint64_t channel_count, uint64_t frame_count) const -> bool {
+		if (channel_count > get_channel_capacity())               { return false; }
+		if (channel_count > channels_.size() && frame_count > 0) { return false; }
+		const auto keep_chs = std::min<uint64_t>(channel_count, channels_.size());
+		for (uint64_t c = 0; c < keep_chs; c++) {
+			const auto& channel = channels_[c];
+			if (!channel)                                                          { if (frame_count > 0) { return false; } }
+			else if (channel->size() != frame_count && (is_shared(c) || frame_count > channel->capacity())) { return false; }
+		}
+		return true;
+	}
+	// Unshares every channel.
+	auto reserve(uint64_t channel_count, uint64_t frame_count) -> void {
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			channels_.reserve(channel_count);
+		}
+		for (size_t c = 0; c < channels_.size(); c++) {
+			if (!channels_[c]) {
+				channels_[c] = make_buffer();
+			}
+			detach(c)->reserve(frame_count);
+		}
+	}
+	// New frames are set to fill_value, or left uninitialized if there
+	// isn't one.
+	auto resize(uint64_t channel_count, uint64_t frame_count, std::optional<ValueType> fill_value) -> void {
+		if constexpr (Chs == DYNAMIC_EXTENT) {
+			channels_.resize(channel_count);
+		}
+		for (auto& channel : channels_) {
+			if (!channel) {
+				channel = make_buffer();
+			}
+			else if (channel->size() != frame_count && channel.use_count() > 1) {
+				// A shared channel only needs the frames which are kept.
+				auto copy = make_buffer();
+				copy->assign(channel->begin(), channel->begin() + std::min<uint64_t>(channel->size(), frame_count));
+				channel = std::move(copy);
+			}
+			if (fill_value) { channel->resize(frame_count, *fill_value); }
+			else            { channel->resize(frame_count); }
+		}
+	}
+private:
+	using channels_type = channel_pointers_t<std::shared_ptr<buffer_type>, Chs>;
+	[[nodiscard]]
+	auto make_buffer() const -> std::shared_ptr<buffer_type> {
+		return std::allocate_shared<buffer_type>(rebind_alloc_t<Policy, buffer_type>{alloc_}, typename buffer_type::allocator_type{alloc_});
+	}
+	auto detach(size_t c) -> const std::shared_ptr<buffer_type>& {
+		auto& channel = channels_[c];
+		if (channel && channel.use_count() > 1) {
+			channel = std::allocate_shared<buffer_type>(rebind_alloc_t<Policy, buffer_type>{alloc_}, *channel, typename buffer_type::allocator_type{alloc_});
+		}
+		return channel;
+	}
+	auto detach_all() -> void {
+		for (size_t c = 0; c < channels_.size(); c++) {
+			static_cast<void>(detach(c));
+		}
+	}
+	[[no_unique_address]] allocator_type alloc_;
+	channels_type channels_ = {};
+};
+
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy, typename Layout> struct select_storage                                                          { using type = storage<ValueType, Chs, Frs, Policy>; };
+template <typename ValueType, uint64_t Chs, typename Policy>                                struct select_storage<ValueType, Chs, DYNAMIC_EXTENT, Policy, layout::planar> { using type = planar_storage<ValueType, Chs, Policy>; };
+template <typename ValueType, uint64_t Chs, typename Policy>                                struct select_storage<ValueType, Chs, DYNAMIC_EXTENT, Policy, layout::shared> { using type = shared_storage<ValueType, Chs, Policy>; };
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy> using select_storage_t = typename select_storage<ValueType, Chs, Frs, Policy, typename Policy::layout>::type;
+
 template <typename Storage> [[nodiscard]] consteval auto get_channel_count() -> channel_count { return {Storage::CHANNEL_COUNT}; }
 template <typename Storage> [[nodiscard]] consteval auto get_frame_count()   -> frame_count   { return {Storage::FRAME_COUNT}; }
 
@@ -79,24 +686,65 @@ auto get_frame_count(const Storage&) -> frame_count {
 	return frame_count{Storage::FRAME_COUNT};
 }
 
+template <typename Storage> using bounds_check_t = typename Storage::policy::bounds_check;
+
+template <typename BoundsCheck>
+auto check_index(const char* what, uint64_t index, uint64_t size) -> void {
+	if constexpr (std::is_same_v<BoundsCheck, bounds::checked>) {
+		if (index >= size) {
+			throw std::out_of_range{std::format("ads: {} index {} is out of range (size = {})", what, index, size)};
+		}
+	}
+	else if constexpr (std::is_same_v<BoundsCheck, bounds::debug>) {
+		assert (index < size);
+	}
+}
+
 template <typename Storage> [[nodiscard]]
-auto at(Storage& st, channel_idx channel) -> channel_data_t<typename Storage::value_type, Storage::FRAME_COUNT>& {
-	return st.at(channel.value);
+auto at(Storage& st, channel_idx channel) -> typename Storage::channel_ref {
+	check_index<bounds_check_t<Storage>>("channel", channel.value, st.size());
+	return st[channel.value];
 }
 
 template <typename Storage> [[nodiscard]]
-auto at(const Storage& st, channel_idx channel) -> const channel_data_t<typename Storage::value_type, Storage::FRAME_COUNT>& {
-	return st.at(channel.value);
+auto at(const Storage& st, channel_idx channel) -> typename Storage::const_channel_ref {
+	check_index<bounds_check_t<Storage>>("channel", channel.value, st.size());
+	return st[channel.value];
 }
 
 template <typename Storage> [[nodiscard]]
 auto at(const Storage& st, channel_idx channel, frame_idx frame) -> const typename Storage::value_type& {
-	return st.at(channel.value).at(frame.value);
+	const auto& ch = at(st, channel);
+	check_index<bounds_check_t<Storage>>("frame", static_cast<uint64_t>(frame.value), ch.size());
+	return ch.data()[frame.value];
 }
 
 template <typename Storage> [[nodiscard]]
 auto at(Storage& st, channel_idx channel, frame_idx frame) -> typename Storage::value_type& {
-	return st.at(channel.value).at(frame.value);
+	auto&& ch = at(st, channel);
+	check_index<bounds_check_t<Storage>>("frame", static_cast<uint64_t>(frame.value), ch.size());
+	return ch.data()[frame.value];
+}
+
+// Never bounds-checked, whatever the policy.
+template <typename Storage> [[nodiscard]]
+auto at_unchecked(Storage& st, channel_idx channel) -> typename Storage::channel_ref {
+	return st[channel.value];
+}
+
+template <typename Storage> [[nodiscard]]
+auto at_unchecked(const Storage& st, channel_idx channel) -> typename Storage::const_channel_ref {
+	return st[channel.value];
+}
+
+template <typename Storage> [[nodiscard]]
+auto at_unchecked(const Storage& st, channel_idx channel, frame_idx frame) -> const typename Storage::value_type& {
+	return st[channel.value].data()[frame.value];
+}
+
+template <typename Storage> [[nodiscard]]
+auto at_unchecked(Storage& st, channel_idx channel, frame_idx frame) -> typename Storage::value_type& {
+	return st[channel.value].data()[frame.value];
 }
 
 template <typename Storage> [[nodiscard]]
@@ -111,138 +759,318 @@ auto at(const Storage& st, channel_idx channel, double frame) -> typename Storag
 	return std::lerp(value0, value1, t);
 }
 
-template <typename Storage> [[nodiscard]]
-auto at(Storage& st, ads::frame_idx frame_idx) -> frame_ref_t<typename Storage::value_type, Storage::CHANNEL_COUNT, false> {
-	frame_ref_t<typename Storage::value_type, Storage::CHANNEL_COUNT, false> frame;
-	for (size_t c = 0; c < Storage::CHANNEL_COUNT; c++) {
-		frame[c] = &st[c].at(frame_idx.value);
-	}
-	return frame;
-}
-
-template <typename Storage> [[nodiscard]]
-auto at(const Storage& st, ads::frame_idx frame_idx) -> frame_ref_t<typename Storage::value_type, Storage::CHANNEL_COUNT, true> {
-	frame_ref_t<typename Storage::value_type, Storage::CHANNEL_COUNT, true> frame;
-	for (size_t c = 0; c < Storage::CHANNEL_COUNT; c++) {
-		frame[c] = &st[c].at(frame_idx.value);
-	}
-	return frame;
-}
-
 template <typename Storage>
 	requires (Storage::CHANNEL_COUNT == DYNAMIC_EXTENT)
 [[nodiscard]]
-auto at(Storage& st, ads::frame_idx frame_idx) -> frame_ref_t<typename Storage::value_type, DYNAMIC_EXTENT, false> {
-	frame_ref_t<typename Storage::value_type, DYNAMIC_EXTENT, false> frame;
-	std::ranges::transform(st, std::back_inserter(frame), [frame_idx](auto& channel) {
-		return &channel.at(frame_idx.value);
-	});
-	return frame;
-}
-
-template <typename Storage>
-	requires (Storage::CHANNEL_COUNT == DYNAMIC_EXTENT)
-[[nodiscard]]
-auto at(const Storage& st, ads::frame_idx frame_idx) -> frame_ref_t<typename Storage::value_type, DYNAMIC_EXTENT, true> {
-	frame_ref_t<typename Storage::value_type, DYNAMIC_EXTENT, true> frame;
-	std::ranges::transform(st, std::back_inserter(frame), [frame_idx](const auto& channel) {
-		return &channel.at(frame_idx.value);
-	});
-	return frame;
+auto get_channel_count(const Storage& st) -> channel_count {
+	return {st.size()};
 }
 
 template <typename Storage>
-	requires (Storage::CHANNEL_COUNT == DYNAMIC_EXTENT)
+	requires (Storage::CHANNEL_COUNT != DYNAMIC_EXTENT)
 [[nodiscard]]
-auto get_channel_count(const Storage& st) -> channel_count {
-	return {st.size()};
+auto get_channel_count(const Storage&) -> channel_count {
+	return {Storage::CHANNEL_COUNT};
 }
 
 template <typename Storage> [[nodiscard]]
 auto data(Storage& st, channel_idx ch) -> typename Storage::value_type* {
-	return st.at(ch.value).data();
+	return at(st, ch).data();
 }
 
 template <typename Storage> [[nodiscard]]
 auto data(const Storage& st, channel_idx ch) -> const typename Storage::value_type* {
-	return st.at(ch.value).data();
+	return at(st, ch).data();
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs>
-auto fill(storage<ValueType, Chs, Frs>& st, ValueType value) -> void {
-	for (auto& channel : st) {
+template <typename Storage>
+auto fill(Storage& st, typename Storage::value_type value) -> void {
+	for (auto&& channel : st) {
 		std::fill(channel.begin(), channel.end(), value);
 	}
 }
 
-template <typename ValueType>
-auto resize(storage<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT>& st, ads::channel_count channel_count, ads::frame_count frame_count) -> void {
+template <typename ValueType, typename Policy>
+auto resize(storage<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ads::frame_count frame_count) -> void {
 	st.resize(channel_count.value);
 	for (auto& channel : st) {
-		channel.resize(frame_count.value);
+		channel.resize(frame_count.value, ValueType{});
 	}
 }
 
-template <typename ValueType>
-auto resize(storage<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT>& st, ads::channel_count channel_count, ads::frame_count frame_count, ValueType fill_value) -> void {
+template <typename ValueType, typename Policy>
+auto resize(storage<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ads::frame_count frame_count, ValueType fill_value) -> void {
 	st.resize(channel_count.value);
 	for (auto& channel : st) {
 		channel.resize(frame_count.value, fill_value);
 	}
 }
 
-template <typename ValueType, uint64_t Chs>
-auto resize(storage<ValueType, Chs, DYNAMIC_EXTENT>& st, ads::frame_count frame_count) -> void {
+template <typename ValueType, uint64_t Chs, typename Policy>
+auto resize(storage<ValueType, Chs, DYNAMIC_EXTENT, Policy>& st, ads::frame_count frame_count) -> void {
 	for (auto& channel : st) {
-		channel.resize(frame_count.value);
+		channel.resize(frame_count.value, ValueType{});
 	}
 }
 
-template <typename ValueType, uint64_t Chs>
-auto resize(storage<ValueType, Chs, DYNAMIC_EXTENT>& st, ads::frame_count frame_count, ValueType fill_value) -> void {
+template <typename ValueType, uint64_t Chs, typename Policy>
+auto resize(storage<ValueType, Chs, DYNAMIC_EXTENT, Policy>& st, ads::frame_count frame_count, ValueType fill_value) -> void {
 	for (auto& channel : st) {
 		channel.resize(frame_count.value, fill_value);
 	}
 }
 
-template <typename ValueType, uint64_t Frs>
-auto resize(storage<ValueType, DYNAMIC_EXTENT, Frs>& st, ads::channel_count channel_count) -> void {
+template <typename ValueType, uint64_t Frs, typename Policy>
+auto resize(storage<ValueType, DYNAMIC_EXTENT, Frs, Policy>& st, ads::channel_count channel_count) -> void {
 	st.resize(channel_count.value);
 }
 
-template <typename ValueType, uint64_t Frs>
-auto resize(storage<ValueType, DYNAMIC_EXTENT, Frs>& st, ads::channel_count channel_count, ValueType fill_value) -> void {
+template <typename ValueType, uint64_t Frs, typename Policy>
+auto resize(storage<ValueType, DYNAMIC_EXTENT, Frs, Policy>& st, ads::channel_count channel_count, ValueType fill_value) -> void {
 	st.resize(channel_count.value);
 	fill(st, fill_value);
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs>
-auto set(storage<ValueType, Chs, Frs>& st, channel_idx channel, frame_idx frame, ValueType value) -> void {
-	st.at(channel.value).at(frame.value) = value;
+template <typename ValueType, typename Policy>
+auto resize(planar_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ads::frame_count frame_count) -> void {
+	st.resize(channel_count.value, frame_count.value, ValueType{});
+}
+
+template <typename ValueType, typename Policy>
+auto resize(planar_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ads::frame_count frame_count, ValueType fill_value) -> void {
+	st.resize(channel_count.value, frame_count.value, fill_value);
+}
+
+template <typename ValueType, typename Policy>
+auto resize(planar_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count) -> void {
+	st.resize(channel_count.value, get_frame_count(st).value, ValueType{});
+}
+
+template <typename ValueType, typename Policy>
+auto resize(planar_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ValueType fill_value) -> void {
+	st.resize(channel_count.value, get_frame_count(st).value, fill_value);
+}
+
+template <typename ValueType, uint64_t Chs, typename Policy>
+auto resize(planar_storage<ValueType, Chs, Policy>& st, ads::frame_count frame_count) -> void {
+	st.resize(get_channel_count(st).value, frame_count.value, ValueType{});
+}
+
+template <typename ValueType, uint64_t Chs, typename Policy>
+auto resize(planar_storage<ValueType, Chs, Policy>& st, ads::frame_count frame_count, ValueType fill_value) -> void {
+	st.resize(get_channel_count(st).value, frame_count.value, fill_value);
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs>
-auto set(storage<ValueType, Chs, Frs>& st, ads::frame_idx frame_idx, frame_t<ValueType, Chs> value) -> void {
-	for (uint64_t c = 0; c < Chs; c++) {
-		st[c].at(frame_idx.value) = value[c];
+template <typename ValueType, typename Policy>
+auto resize(shared_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ads::frame_count frame_count) -> void {
+	st.resize(channel_count.value, frame_count.value, ValueType{});
+}
+
+template <typename ValueType, typename Policy>
+auto resize(shared_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ads::frame_count frame_count, ValueType fill_value) -> void {
+	st.resize(channel_count.value, frame_count.value, fill_value);
+}
+
+template <typename ValueType, typename Policy>
+auto resize(shared_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count) -> void {
+	st.resize(channel_count.value, get_frame_count(st).value, ValueType{});
+}
+
+template <typename ValueType, typename Policy>
+auto resize(shared_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ValueType fill_value) -> void {
+	st.resize(channel_count.value, get_frame_count(st).value, fill_value);
+}
+
+template <typename ValueType, uint64_t Chs, typename Policy>
+auto resize(shared_storage<ValueType, Chs, Policy>& st, ads::frame_count frame_count) -> void {
+	st.resize(get_channel_count(st).value, frame_count.value, ValueType{});
+}
+
+template <typename ValueType, uint64_t Chs, typename Policy>
+auto resize(shared_storage<ValueType, Chs, Policy>& st, ads::frame_count frame_count, ValueType fill_value) -> void {
+	st.resize(get_channel_count(st).value, frame_count.value, fill_value);
+}
+
+// The same as resize(), but new frames are left uninitialized. Only
+// storage with a dynamic frame count supports this.
+template <typename ValueType, typename Policy>
+auto resize_uninitialized(storage<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ads::frame_count frame_count) -> void {
+	st.resize(channel_count.value);
+	for (auto& channel : st) {
+		channel.resize(frame_count.value);
+	}
+}
+
+template <typename ValueType, typename Policy>
+auto resize_uninitialized(storage<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count) -> void {
+	resize_uninitialized(st, channel_count, get_frame_count(st));
+}
+
+template <typename ValueType, uint64_t Chs, typename Policy>
+auto resize_uninitialized(storage<ValueType, Chs, DYNAMIC_EXTENT, Policy>& st, ads::frame_count frame_count) -> void {
+	for (auto& channel : st) {
+		channel.resize(frame_count.value);
+	}
+}
+
+template <typename ValueType, typename Policy>
+auto resize_uninitialized(planar_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ads::frame_count frame_count) -> void {
+	st.resize(channel_count.value, frame_count.value, std::nullopt);
+}
+
+template <typename ValueType, typename Policy>
+auto resize_uninitialized(planar_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count) -> void {
+	st.resize(channel_count.value, get_frame_count(st).value, std::nullopt);
+}
+
+template <typename ValueType, uint64_t Chs, typename Policy>
+auto resize_uninitialized(planar_storage<ValueType, Chs, Policy>& st, ads::frame_count frame_count) -> void {
+	st.resize(get_channel_count(st).value, frame_count.value, std::nullopt);
+}
+
+template <typename ValueType, typename Policy>
+auto resize_uninitialized(shared_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count, ads::frame_count frame_count) -> void {
+	st.resize(channel_count.value, frame_count.value, std::nullopt);
+}
+
+template <typename ValueType, typename Policy>
+auto resize_uninitialized(shared_storage<ValueType, DYNAMIC_EXTENT, Policy>& st, ads::channel_count channel_count) -> void {
+	st.resize(channel_count.value, get_frame_count(st).value, std::nullopt);
+}
+
+template <typename ValueType, uint64_t Chs, typename Policy>
+auto resize_uninitialized(shared_storage<ValueType, Chs, Policy>& st, ads::frame_count frame_count) -> void {
+	st.resize(get_channel_count(st).value, frame_count.value, std::nullopt);
+}
+
+template <typename Storage>
+auto set(Storage& st, channel_idx channel, frame_idx frame, typename Storage::value_type value) -> void {
+	at(st, channel, frame) = value;
+}
+
+template <typename Storage>
+auto set(Storage& st, ads::frame_idx frame_idx, frame_t<typename Storage::value_type, Storage::CHANNEL_COUNT> value) -> void {
+	for (uint64_t c = 0; c < Storage::CHANNEL_COUNT; c++) {
+		at(st, channel_idx{c}, frame_idx) = value[c];
 	}
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Fn>
-	requires concepts::is_value_visitor_fn<ValueType, Fn>
-auto visit(const storage<ValueType, Chs, Frs>& st, Fn fn) -> void {
+template <typename Storage, typename Fn>
+	requires concepts::is_value_visitor_fn<typename Storage::value_type, Fn>
+auto visit(const Storage& st, Fn fn) -> void {
 	const auto channel_count = get_channel_count(st);
 	const auto frame_count   = get_frame_count(st);
 	for (ads::channel_idx ch = {0}; ch < channel_count; ch++) {
+		const auto channel = at_unchecked(st, ch).data();
 		for (ads::frame_idx fr = {0}; fr < frame_count; fr++) {
-			fn(ch, fr, at(st, ch, fr));
+			fn(ch, fr, channel[fr.value]);
 		}
 	}
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename ReadFn>
-	requires concepts::is_single_channel_read_fn<ValueType, ReadFn>
-auto read(const storage<ValueType, Chs, Frs>& st, channel_idx ch, frame_idx start, ads::frame_count frame_count, ReadFn read_fn) -> ads::frame_count {
+// Calls fn with contiguous spans of each channel, at most BlockSize
+// frames long. With a dynamic block size each channel is one span.
+template <uint64_t BlockSize, typename Storage, typename Fn>
+	requires concepts::is_block_visitor_fn<typename Storage::value_type, Fn>
+auto visit_blocks(const Storage& st, Fn fn) -> void {
+	static_assert (BlockSize > 0, "BlockSize must be greater than zero");
+	const auto channel_count = get_channel_count(st);
+	const auto frame_count   = get_frame_count(st).value;
+	const auto block_size    = BlockSize == DYNAMIC_EXTENT ? frame_count : BlockSize;
+	for (ads::channel_idx ch = {0}; ch < channel_count; ch++) {
+		const auto channel = at_unchecked(st, ch).data();
+		for (uint64_t start = 0; start < frame_count; start += block_size) {
+			fn(ch, frame_idx{static_cast<int64_t>(start)}, std::span{channel + start, std::min(block_size, frame_count - start)});
+		}
+	}
+}
+
+// Calls fn(task) for every task in [0, task_count), shared out between
+// thread_count threads (including the calling thread), so fn must be
+// safe to call concurrently. A thread_count of zero means one per
+// hardware thread. If fn throws, the remaining tasks are skipped and
+// the first exception is rethrown once every thread has stopped.
+template <typename Fn>
+auto parallel_for(uint64_t task_count, unsigned thread_count, Fn fn) -> void {
+	if (thread_count == 0) {
+		thread_count = std::max(std::thread::hardware_concurrency(), 1U);
+	}
+	thread_count = static_cast<unsigned>(std::min<uint64_t>(thread_count, task_count));
+	std::atomic<uint64_t> next_task = 0;
+	std::atomic<bool> failed        = false;
+	std::exception_ptr error;
+	std::mutex error_mutex;
+	auto work = [&] {
+		for (auto task = next_task++; task < task_count && !failed; task = next_task++) {
+			try {
+				fn(task);
+			}
+			catch (...) {
+				const auto lock = std::lock_guard{error_mutex};
+				if (!error) { error = std::current_exception(); }
+				failed = true;
+			}
+		}
+	};
+	{
+		std::vector<std::jthread> threads;
+		for (unsigned i = 1; i < thread_count; i++) {
+			threads.emplace_back(work);
+		}
+		work();
+	}
+	if (error) {
+		std::rethrow_exception(error);
+	}
+}
+
+// The same as visit_blocks() but the blocks are shared out between
+// threads by parallel_for().
+template <uint64_t BlockSize, typename Storage, typename Fn>
+	requires concepts::is_block_visitor_fn<typename Storage::value_type, Fn>
+auto visit_blocks_parallel(const Storage& st, Fn fn, unsigned thread_count) -> void {
+	static_assert (BlockSize > 0, "BlockSize must be greater than zero");
+	const auto channel_count = get_channel_count(st).value;
+	const auto frame_count   = get_frame_count(st).value;
+	const auto block_size    = BlockSize == DYNAMIC_EXTENT ? frame_count : BlockSize;
+	const auto channel_tasks = block_size == 0 ? 0 : (frame_count + block_size - 1) / block_size;
+	parallel_for(channel_count * channel_tasks, thread_count, [&](uint64_t task) {
+		const auto ch      = ads::channel_idx{task / channel_tasks};
+		const auto start   = (task % channel_tasks) * block_size;
+		const auto channel = at_unchecked(st, ch).data();
+		fn(ch, frame_idx{static_cast<int64_t>(start)}, std::span{channel + start, std::min(block_size, frame_count - start)});
+	});
+}
+
+// Fills every channel in blocks of BlockSize frames shared out between
+// threads. Memory is usually placed near the thread which touches it
+// first, so this spreads a freshly allocated buffer across the memory
+// of every core which fills it.
+template <uint64_t BlockSize, typename Storage>
+auto fill_parallel(Storage& st, typename Storage::value_type value, unsigned thread_count) -> void {
+	static_assert (BlockSize > 0, "BlockSize must be greater than zero");
+	const auto channel_count = get_channel_count(st).value;
+	const auto frame_count   = get_frame_count(st).value;
+	const auto block_size    = BlockSize == DYNAMIC_EXTENT ? frame_count : BlockSize;
+	const auto channel_tasks = block_size == 0 ? 0 : (frame_count + block_size - 1) / block_size;
+	// Channel pointers are taken up front because non-const access to
+	// copy-on-write storage isn't thread safe.
+	channel_pointers_t<typename Storage::value_type*, Storage::CHANNEL_COUNT> channels;
+	if constexpr (Storage::CHANNEL_COUNT == DYNAMIC_EXTENT) {
+		channels.resize(channel_count);
+	}
+	for (ads::channel_idx ch = {0}; ch < channel_count; ch++) {
+		channels[ch.value] = at_unchecked(st, ch).data();
+	}
+	parallel_for(channel_count * channel_tasks, thread_count, [&](uint64_t task) {
+		const auto start = (task % channel_tasks) * block_size;
+		std::fill_n(channels[task / channel_tasks] + start, std::min(block_size, frame_count - start), value);
+	});
+}
+
+template <typename Storage, typename ReadFn>
+	requires concepts::is_single_channel_read_fn<typename Storage::value_type, ReadFn>
+auto read(const Storage& st, channel_idx ch, frame_idx start, ads::frame_count frame_count, ReadFn read_fn) -> ads::frame_count {
 	if (start.value > SANE_NUMBER_OF_FRAMES) {
 		throw std::underflow_error{std::format("ads::detail::read() with frame start = {} is insane", start.value)};
 	}
@@ -256,23 +1084,23 @@ auto read(const storage<ValueType, Chs, Frs>& st, channel_idx ch, frame_idx star
 	return read_fn(channel.data() + start.value, start, frame_count);
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename ReadFn>
-	requires concepts::is_multi_channel_read_fn<ValueType, ReadFn>
-auto read(const storage<ValueType, Chs, Frs>& st, channel_idx ch, frame_idx start, ads::frame_count frame_count, ReadFn read_fn) -> ads::frame_count {
-	return read(st, ch, start, frame_count, [ch, read_fn](const ValueType* buffer, frame_idx frame_start, ads::frame_count frame_count) {
+template <typename Storage, typename ReadFn>
+	requires concepts::is_multi_channel_read_fn<typename Storage::value_type, ReadFn>
+auto read(const Storage& st, channel_idx ch, frame_idx start, ads::frame_count frame_count, ReadFn read_fn) -> ads::frame_count {
+	return read(st, ch, start, frame_count, [ch, read_fn](const typename Storage::value_type* buffer, frame_idx frame_start, ads::frame_count frame_count) {
 		return read_fn(buffer, ch, frame_start, frame_count);
 	});
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename ReadFn>
-	requires concepts::is_single_channel_read_fn<ValueType, ReadFn> && concepts::is_mono_data<Chs>
-auto read(const storage<ValueType, Chs, Frs>& st, frame_idx start, ads::frame_count frame_count, ReadFn read_fn) -> ads::frame_count {
+template <typename Storage, typename ReadFn>
+	requires concepts::is_single_channel_read_fn<typename Storage::value_type, ReadFn> && concepts::is_mono_data<Storage::CHANNEL_COUNT>
+auto read(const Storage& st, frame_idx start, ads::frame_count frame_count, ReadFn read_fn) -> ads::frame_count {
 	return read(st, channel_idx{0}, start, frame_count, read_fn);
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename ReadFn>
-	requires ((concepts::is_single_channel_read_fn<ValueType, ReadFn> && !concepts::is_mono_data<Chs>) || concepts::is_multi_channel_read_fn<ValueType, ReadFn>)
-auto read(const storage<ValueType, Chs, Frs>& st, frame_idx start, ads::frame_count frame_count, ReadFn read_fn) -> ads::frame_count {
+template <typename Storage, typename ReadFn>
+	requires ((concepts::is_single_channel_read_fn<typename Storage::value_type, ReadFn> && !concepts::is_mono_data<Storage::CHANNEL_COUNT>) || concepts::is_multi_channel_read_fn<typename Storage::value_type, ReadFn>)
+auto read(const Storage& st, frame_idx start, ads::frame_count frame_count, ReadFn read_fn) -> ads::frame_count {
 	auto frames_read = ads::frame_count{0};
 	for (size_t c = 0; c < st.size(); c++) {
 		const auto channel_frames_read = read(st, channel_idx{c}, start, frame_count, read_fn);
@@ -284,13 +1112,13 @@ auto read(const storage<ValueType, Chs, Frs>& st, frame_idx start, ads::frame_co
 	return frames_read;
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename WriteFn>
-	requires concepts::is_single_channel_write_fn<ValueType, WriteFn>
-auto write(storage<ValueType, Chs, Frs>& st, channel_idx ch, frame_idx start, ads::frame_count frame_count, WriteFn write_fn) -> ads::frame_count {
+template <typename Storage, typename WriteFn>
+	requires concepts::is_single_channel_write_fn<typename Storage::value_type, WriteFn>
+auto write(Storage& st, channel_idx ch, frame_idx start, ads::frame_count frame_count, WriteFn write_fn) -> ads::frame_count {
 	if (start.value > SANE_NUMBER_OF_FRAMES) {
 		throw std::underflow_error{std::format("ads::detail::write() with frame start = {} is insane", start.value)};
 	}
-	auto& channel = at(st, ch);
+	auto&& channel = at(st, ch);
 	if (start >= channel.size()) {
 		return {0};
 	}
@@ -300,23 +1128,23 @@ auto write(storage<ValueType, Chs, Frs>& st, channel_idx ch, frame_idx start, ad
 	return write_fn(channel.data() + start.value, start, frame_count);
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename WriteFn>
-	requires concepts::is_multi_channel_write_fn<ValueType, WriteFn>
-auto write(storage<ValueType, Chs, Frs>& st, channel_idx ch, frame_idx start, ads::frame_count frame_count, WriteFn write_fn) -> ads::frame_count {
-	return write(st, ch, start, frame_count, [ch, write_fn](ValueType* buffer, frame_idx frame_start, ads::frame_count frame_count) {
+template <typename Storage, typename WriteFn>
+	requires concepts::is_multi_channel_write_fn<typename Storage::value_type, WriteFn>
+auto write(Storage& st, channel_idx ch, frame_idx start, ads::frame_count frame_count, WriteFn write_fn) -> ads::frame_count {
+	return write(st, ch, start, frame_count, [ch, write_fn](typename Storage::value_type* buffer, frame_idx frame_start, ads::frame_count frame_count) {
 		return write_fn(buffer, ch, frame_start, frame_count);
 	});
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename WriteFn>
-	requires concepts::is_single_channel_write_fn<ValueType, WriteFn> && concepts::is_mono_data<Chs>
-auto write(storage<ValueType, Chs, Frs>& st, frame_idx start, ads::frame_count frame_count, WriteFn write_fn) -> ads::frame_count {
+template <typename Storage, typename WriteFn>
+	requires concepts::is_single_channel_write_fn<typename Storage::value_type, WriteFn> && concepts::is_mono_data<Storage::CHANNEL_COUNT>
+auto write(Storage& st, frame_idx start, ads::frame_count frame_count, WriteFn write_fn) -> ads::frame_count {
 	return write(st, channel_idx{0}, start, frame_count, write_fn);
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename WriteFn>
-	requires ((concepts::is_single_channel_write_fn<ValueType, WriteFn> && !concepts::is_mono_data<Chs>) || concepts::is_multi_channel_write_fn<ValueType, WriteFn>)
-auto write(storage<ValueType, Chs, Frs>& st, frame_idx start, ads::frame_count frame_count, WriteFn write_fn) -> ads::frame_count {
+template <typename Storage, typename WriteFn>
+	requires ((concepts::is_single_channel_write_fn<typename Storage::value_type, WriteFn> && !concepts::is_mono_data<Storage::CHANNEL_COUNT>) || concepts::is_multi_channel_write_fn<typename Storage::value_type, WriteFn>)
+auto write(Storage& st, frame_idx start, ads::frame_count frame_count, WriteFn write_fn) -> ads::frame_count {
 	auto frames_written = ads::frame_count{0};
 	for (size_t c = 0; c < st.size(); c++) {
 		const auto channel_frames_written = write(st, channel_idx{c}, start, frame_count, write_fn);
@@ -328,48 +1156,138 @@ auto write(storage<ValueType, Chs, Frs>& st, frame_idx start, ads::frame_count f
 	return frames_written;
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs>
-auto write(storage<ValueType, Chs, Frs>& dest, frame_idx start, ads::frame_count frame_count, const storage<ValueType, Chs, Frs>& src) -> ads::frame_count {
-	return write(dest, start, frame_count, [&src](ValueType* buffer, channel_idx ch, frame_idx frame_start, ads::frame_count frame_count) {
+template <typename Storage> [[nodiscard]]
+auto get_channel_pointers(Storage& st, frame_idx start) {
+	channel_pointers_t<decltype(st[0].data()), Storage::CHANNEL_COUNT> pointers;
+	if constexpr (Storage::CHANNEL_COUNT == DYNAMIC_EXTENT) {
+		pointers.resize(st.size());
+	}
+	for (size_t c = 0; c < pointers.size(); c++) {
+		pointers[c] = st[c].data() + start.value;
+	}
+	return pointers;
+}
+
+// Calls fn with every channel at once, one block of frames at a time.
+// With a dynamic block size the whole range is one block. Stops early if
+// fn returns fewer frames than it was given.
+template <uint64_t BlockSize, typename Storage, typename Fn>
+auto for_each_block(Storage& st, frame_idx start, ads::frame_count frame_count, Fn fn) -> ads::frame_count {
+	static_assert (BlockSize > 0, "BlockSize must be greater than zero");
+	if (start.value > SANE_NUMBER_OF_FRAMES) {
+		throw std::underflow_error{std::format("ads::detail::for_each_block() with frame start = {} is insane", start.value)};
+	}
+	const auto total_frames = get_frame_count(st);
+	if (st.empty() || start >= total_frames) {
+		return {0};
+	}
+	frame_count.value = std::min(frame_count.value, total_frames.value - static_cast<uint64_t>(start.value));
+	auto pointers = get_channel_pointers(st, start);
+	auto done     = ads::frame_count{0};
+	while (done < frame_count) {
+		const auto block = ads::frame_count{std::min(BlockSize == DYNAMIC_EXTENT ? frame_count.value : BlockSize, frame_count.value - done.value)};
+		const auto block_done = fn(std::span<const typename decltype(pointers)::value_type>{pointers.data(), pointers.size()}, start + done, block);
+		done += block_done;
+		if (block_done < block) {
+			break;
+		}
+		for (auto& ptr : pointers) {
+			ptr += block.value;
+		}
+	}
+	return done;
+}
+
+template <uint64_t BlockSize, typename Storage, typename ReadFn>
+	requires concepts::is_block_read_fn<typename Storage::value_type, ReadFn>
+auto read_blocks(const Storage& st, frame_idx start, ads::frame_count frame_count, ReadFn read_fn) -> ads::frame_count {
+	return for_each_block<BlockSize>(st, start, frame_count, read_fn);
+}
+
+template <uint64_t BlockSize, typename Storage, typename WriteFn>
+	requires concepts::is_block_write_fn<typename Storage::value_type, WriteFn>
+auto write_blocks(Storage& st, frame_idx start, ads::frame_count frame_count, WriteFn write_fn) -> ads::frame_count {
+	return for_each_block<BlockSize>(st, start, frame_count, write_fn);
+}
+
+template <typename Storage>
+auto write(Storage& dest, frame_idx start, ads::frame_count frame_count, const Storage& src) -> ads::frame_count {
+	return write(dest, start, frame_count, [&src](typename Storage::value_type* buffer, channel_idx ch, frame_idx frame_start, ads::frame_count frame_count) {
 		const auto& channel = at(src, ch);
 		std::copy_n(channel.begin(), frame_count.value, buffer);
 		return frame_count;
 	});
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, bool Const>
+// A single frame of the storage. This is just the storage pointer and
+// the frame index, and channels are looked up when they are accessed,
+// so iterating frame-by-frame never allocates. Accessing a channel gives
+// a pointer to its sample, the same as a frame_ref_t, and channel indices
+// are not bounds-checked.
+template <typename Storage, bool Const>
+struct frame_proxy {
+	using storage_type = std::conditional_t<Const, const Storage, Storage>;
+	using pointer      = std::conditional_t<Const, const typename Storage::value_type*, typename Storage::value_type*>;
+	struct iterator {
+		using iterator_category = std::random_access_iterator_tag;
+		using value_type        = pointer;
+		using difference_type   = int64_t;
+		using reference         = pointer;
+		storage_type* st = nullptr;
+		uint64_t frame   = 0;
+		uint64_t channel = 0;
+		[[nodiscard]] auto operator*() const -> pointer                { return &(*st)[channel][frame]; }
+		[[nodiscard]] auto operator[](int64_t n) const -> pointer      { return &(*st)[channel + n][frame]; }
+		auto operator++() -> iterator&                                 { ++channel; return *this; }
+		auto operator--() -> iterator&                                 { --channel; return *this; }
+		auto operator++(int) -> iterator                               { auto copy = *this; ++channel; return copy; }
+		auto operator--(int) -> iterator                               { auto copy = *this; --channel; return copy; }
+		auto operator+=(int64_t n) -> iterator&                        { channel += n; return *this; }
+		auto operator-=(int64_t n) -> iterator&                        { channel -= n; return *this; }
+		[[nodiscard]] auto operator+(int64_t n) const -> iterator      { return {st, frame, channel + n}; }
+		[[nodiscard]] auto operator-(int64_t n) const -> iterator      { return {st, frame, channel - n}; }
+		[[nodiscard]] auto operator-(const iterator& other) const -> difference_type { return static_cast<int64_t>(channel) - static_cast<int64_t>(other.channel); }
+		[[nodiscard]] auto operator==(const iterator& other) const -> bool { return channel == other.channel; }
+		[[nodiscard]] auto operator<=>(const iterator& other) const    { return channel <=> other.channel; }
+		[[nodiscard]] friend auto operator+(int64_t n, const iterator& it) -> iterator { return it + n; }
+	};
+	storage_type* st = nullptr;
+	uint64_t frame   = 0;
+	[[nodiscard]] auto size() const -> size_t                 { return get_channel_count(*st).value; }
+	[[nodiscard]] auto operator[](size_t channel) const -> pointer { return &(*st)[channel][frame]; }
+	[[nodiscard]] auto begin() const -> iterator              { return {st, frame, 0}; }
+	[[nodiscard]] auto end() const -> iterator                { return {st, frame, size()}; }
+};
+
+template <typename Storage, bool Const>
 struct frame_iterator_base {
 	using iterator_category = std::random_access_iterator_tag;
-	using value_type        = frame_ref_t<ValueType, Chs, Const>;
+	using value_type        = frame_proxy<Storage, Const>;
 	using difference_type   = int64_t;
-	using pointer           = value_type*;
-	using reference         = value_type&;
-	using storage_type      = std::conditional_t<Const, const storage<ValueType, Chs, Frs>, storage<ValueType, Chs, Frs>>;
-	storage_type* st = nullptr;
-	frame_idx frame  = {0};
+	using reference         = value_type;
+	using storage_type      = std::conditional_t<Const, const Storage, Storage>;
+	storage_type* st     = nullptr;
+	frame_idx frame      = {0};
+	uint64_t frame_count = 0;
 	frame_iterator_base() = default;
-	frame_iterator_base(storage_type& st)                  : st{st.empty() ? nullptr : &st} {}
-	frame_iterator_base(storage_type& st, frame_idx frame) : st{st.empty() ? nullptr : &st}, frame{frame} {}
+	frame_iterator_base(storage_type& st)                  : frame_iterator_base{st, frame_idx{0}} {}
+	frame_iterator_base(storage_type& st, frame_idx frame) : st{st.empty() ? nullptr : &st}, frame{frame}, frame_count{get_frame_count(st).value} {}
 	frame_iterator_base(const frame_iterator_base&) = default;
 	frame_iterator_base(frame_iterator_base&&) = default;
 	frame_iterator_base& operator=(const frame_iterator_base&) = default;
 	frame_iterator_base& operator=(frame_iterator_base&&) = default;
 	[[nodiscard]] static
 	auto is_end(const frame_iterator_base& it) -> bool {
-		if (!it.st) return true;
-		if (it.frame.value == std::size(*it.st->begin())) return true;
-		return false;
-	}
-	auto operator*()        { return detail::at(*st, frame); }
-	auto operator*() const  { return detail::at(*st, frame); }
-	auto operator->()       { return detail::at(*st, frame); }
-	auto operator->() const { return detail::at(*st, frame); }
+		return !it.st || it.frame.value == static_cast<int64_t>(it.frame_count);
+	}
+	[[nodiscard]] auto operator*() const -> value_type { return {st, static_cast<uint64_t>(frame.value)}; }
+	[[nodiscard]] auto operator[](int64_t n) const -> value_type { return {st, static_cast<uint64_t>(frame.value + n)}; }
 	auto operator++(int)    { auto copy = *this; ++frame.value; return copy; }
 	auto operator--(int)    { auto copy = *this; --frame.value; return copy; }
-	auto operator+=(int64_t n) { frame.value += n; return *this; }
-	auto operator-=(int64_t n) { frame.value -= n; return *this; }
-	auto operator+(int64_t n) const { return frame_iterator_base{*st, frame_idx{frame.value + n}}; }
-	auto operator-(int64_t n) const { return frame_iterator_base{*st, frame_idx{frame.value - n}}; }
+	auto operator+=(int64_t n) -> frame_iterator_base& { frame.value += n; return *this; }
+	auto operator-=(int64_t n) -> frame_iterator_base& { frame.value -= n; return *this; }
+	auto operator+(int64_t n) const { auto copy = *this; copy.frame.value += n; return copy; }
+	auto operator-(int64_t n) const { auto copy = *this; copy.frame.value -= n; return copy; }
 	auto operator==(const frame_iterator_base& other) const {
 		if (is_end(*this)) return is_end(other);
 		if (is_end(other)) return false;
@@ -389,19 +1307,21 @@ struct frame_iterator_base {
 	frame_iterator_base& operator++() { ++frame.value; return *this; }
 };
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs> using frame_iterator       = frame_iterator_base<ValueType, Chs, Frs, false>;
-template <typename ValueType, uint64_t Chs, uint64_t Frs> using const_frame_iterator = frame_iterator_base<ValueType, Chs, Frs, true>;
+template <typename Storage> using frame_iterator       = frame_iterator_base<Storage, false>;
+template <typename Storage> using const_frame_iterator = frame_iterator_base<Storage, true>;
 
 } // namespace detail
 
 namespace detail {
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs>
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy = default_policy>
 struct impl {
+	using storage_type   = select_storage_t<ValueType, Chs, Frs, Policy>;
+	using allocator_type = typename Policy::allocator;
 	impl() = default;
-	impl(storage<ValueType, Chs, Frs>&& st) : st_{std::move(st)} {
-		fill(ValueType{0});
-	}
+	// Takes storage which has already been initialized, or deliberately
+	// left uninitialized.
+	impl(storage_type&& st) : st_{std::move(st)} {}
 	impl& operator=(const impl&)     = default;
 	impl& operator=(impl&&) noexcept = default;
 	impl(const impl&)                = default;
@@ -416,38 +1336,128 @@ struct impl {
 		if constexpr (Frs == DYNAMIC_EXTENT) { return detail::get_frame_count(st_); }
 		else                                 { return {Frs}; }
 	}
-	impl& operator=(impl<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT>&& rhs)
+	[[nodiscard]]
+	auto get_allocator() const -> allocator_type {
+		return st_.get_allocator();
+	}
+	// The number of frames which can safely be accessed in each channel
+	// buffer, including any padding requested by the policy.
+	[[nodiscard]] constexpr
+	auto get_padded_frame_count() const -> frame_count {
+		return {detail::get_padded_frame_count<ValueType, Policy>(get_frame_count().value)};
+	}
+	// The number of frames each channel can be resized to without
+	// allocating, and the number of channels.
+	[[nodiscard]] auto get_capacity() const -> frame_count                 { return {st_.get_frame_capacity()}; }
+	[[nodiscard]] auto get_channel_capacity() const -> channel_count       { return {st_.get_channel_capacity()}; }
+	auto reserve(ads::channel_count channel_count, ads::frame_count frame_count) -> void
+		requires (Chs == DYNAMIC_EXTENT && Frs == DYNAMIC_EXTENT)
+	{
+		st_.reserve(channel_count.value, frame_count.value);
+	}
+	auto reserve(ads::channel_count channel_count) -> void
+		requires (Chs == DYNAMIC_EXTENT)
+	{
+		st_.reserve(channel_count.value, get_frame_count().value);
+	}
+	auto reserve(ads::frame_count frame_count) -> void
+		requires (Frs == DYNAMIC_EXTENT)
+	{
+		st_.reserve(get_channel_count().value, frame_count.value);
+	}
+	// The same as resize(), but never allocates. Returns false, and
+	// leaves the data as it was, if the new size doesn't fit within the
+	// capacity.
+	[[nodiscard]]
+	auto try_resize(ads::channel_count channel_count, ads::frame_count frame_count) -> bool
+		requires (Chs == DYNAMIC_EXTENT && Frs == DYNAMIC_EXTENT)
+	{
+		if (!st_.can_resize(channel_count.value, frame_count.value)) { return false; }
+		detail::resize(st_, channel_count, frame_count);
+		return true;
+	}
+	[[nodiscard]]
+	auto try_resize(ads::channel_count channel_count, ads::frame_count frame_count, ValueType fill_value) -> bool
+		requires (Chs == DYNAMIC_EXTENT && Frs == DYNAMIC_EXTENT)
+	{
+		if (!st_.can_resize(channel_count.value, frame_count.value)) { return false; }
+		detail::resize(st_, channel_count, frame_count, fill_value);
+		return true;
+	}
+	[[nodiscard]]
+	auto try_resize(ads::channel_count channel_count) -> bool
+		requires (Chs == DYNAMIC_EXTENT)
+	{
+		if (!st_.can_resize(channel_count.value, get_frame_count().value)) { return false; }
+		detail::resize(st_, channel_count);
+		return true;
+	}
+	[[nodiscard]]
+	auto try_resize(ads::channel_count channel_count, ValueType fill_value) -> bool
+		requires (Chs == DYNAMIC_EXTENT)
+	{
+		if (!st_.can_resize(channel_count.value, get_frame_count().value)) { return false; }
+		detail::resize(st_, channel_count, fill_value);
+		return true;
+	}
+	[[nodiscard]]
+	auto try_resize(ads::frame_count frame_count) -> bool
+		requires (Frs == DYNAMIC_EXTENT)
+	{
+		if (!st_.can_resize(get_channel_count().value, frame_count.value)) { return false; }
+		detail::resize(st_, frame_count);
+		return true;
+	}
+	[[nodiscard]]
+	auto try_resize(ads::frame_count frame_count, ValueType fill_value) -> bool
+		requires (Frs == DYNAMIC_EXTENT)
+	{
+		if (!st_.can_resize(get_channel_count().value, frame_count.value)) { return false; }
+		detail::resize(st_, frame_count, fill_value);
+		return true;
+	}
+	impl& operator=(impl<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, Policy>&& rhs)
 		requires (Chs != DYNAMIC_EXTENT && Frs == DYNAMIC_EXTENT)
 	{
+		if constexpr (!std::is_reference_v<typename storage_type::channel_ref>) {
+			// Channels are views into a single buffer so they can't be
+			// moved individually. Copy them instead.
+			detail::resize(st_, rhs.get_frame_count());
+		}
 		for (ads::channel_idx i = {0}; i < Chs; i++) {
 			if (i >= rhs.get_channel_count()) {
 				break;
 			}
-			st_.at(i.value) = std::move(rhs.at(i));
+			if constexpr (std::is_reference_v<typename storage_type::channel_ref>) { st_.at(i.value) = std::move(rhs.at(i)); }
+			else                                                                     { std::ranges::copy(rhs.at(i), st_.at(i.value).begin()); }
 		}
 		return *this;
 	}
-	[[nodiscard]] auto at(channel_idx ch) -> channel_data_t<ValueType, Frs>&             { return detail::at(st_, ch); }
-	[[nodiscard]] auto at(channel_idx ch) const -> const channel_data_t<ValueType, Frs>& { return detail::at(st_, ch); }
+	[[nodiscard]] auto at(channel_idx ch) -> typename storage_type::channel_ref             { return detail::at(st_, ch); }
+	[[nodiscard]] auto at(channel_idx ch) const -> typename storage_type::const_channel_ref { return detail::at(st_, ch); }
 	[[nodiscard]] auto at(channel_idx ch, frame_idx f) -> ValueType&                     { return detail::at(st_, ch, f); }
 	[[nodiscard]] auto at(channel_idx ch, frame_idx f) const -> const ValueType          { return detail::at(st_, ch, f); }
 	[[nodiscard]] auto at(channel_idx ch, double f) const -> ValueType                   { return detail::at(st_, ch, f); }
-	[[nodiscard]] auto begin() -> frame_iterator<ValueType, Chs, Frs>                    { return {st_}; }
-	[[nodiscard]] auto end() -> frame_iterator<ValueType, Chs, Frs>                      { return {}; }
-	[[nodiscard]] auto begin() const -> const_frame_iterator<ValueType, Chs, Frs>        { return {st_}; }
-	[[nodiscard]] auto end() const -> const_frame_iterator<ValueType, Chs, Frs>          { return {}; }
-	[[nodiscard]] auto cbegin() const -> const_frame_iterator<ValueType, Chs, Frs>       { return {st_}; }
-	[[nodiscard]] auto cend() const -> const_frame_iterator<ValueType, Chs, Frs>         { return {}; }
-	[[nodiscard]] auto channels_begin() -> channel_iterator_t<ValueType, Frs>            { return std::begin(st_); }
-	[[nodiscard]] auto channels_end()   -> channel_iterator_t<ValueType, Frs>            { return std::end(st_); }
+	[[nodiscard]] auto at_unchecked(channel_idx ch) -> typename storage_type::channel_ref             { return detail::at_unchecked(st_, ch); }
+	[[nodiscard]] auto at_unchecked(channel_idx ch) const -> typename storage_type::const_channel_ref { return detail::at_unchecked(st_, ch); }
+	[[nodiscard]] auto at_unchecked(channel_idx ch, frame_idx f) -> ValueType&                     { return detail::at_unchecked(st_, ch, f); }
+	[[nodiscard]] auto at_unchecked(channel_idx ch, frame_idx f) const -> const ValueType&         { return detail::at_unchecked(st_, ch, f); }
+	[[nodiscard]] auto begin() -> frame_iterator<storage_type>                           { return {st_}; }
+	[[nodiscard]] auto end() -> frame_iterator<storage_type>                             { return {}; }
+	[[nodiscard]] auto begin() const -> const_frame_iterator<storage_type>               { return {st_}; }
+	[[nodiscard]] auto end() const -> const_frame_iterator<storage_type>                 { return {}; }
+	[[nodiscard]] auto cbegin() const -> const_frame_iterator<storage_type>              { return {st_}; }
+	[[nodiscard]] auto cend() const -> const_frame_iterator<storage_type>                { return {}; }
+	[[nodiscard]] auto channels_begin() -> typename storage_type::channel_iterator       { return std::begin(st_); }
+	[[nodiscard]] auto channels_end()   -> typename storage_type::channel_iterator       { return std::end(st_); }
 	[[nodiscard]] auto channels_begin() const                                            { return std::cbegin(st_); }
 	[[nodiscard]] auto channels_end() const                                              { return std::cend(st_); }
 	[[nodiscard]] auto channels_cbegin() const                                           { return std::cbegin(st_); }
 	[[nodiscard]] auto channels_cend() const                                             { return std::cend(st_); }
 	[[nodiscard]] auto data(channel_idx ch) -> ValueType*                                { return detail::data(st_, ch); }
 	[[nodiscard]] auto data(channel_idx ch) const -> const ValueType*                    { return detail::data(st_, ch); }
-	[[nodiscard]] auto at() -> channel_data_t<ValueType, Frs>&             requires (concepts::is_mono_data<Chs>) { return detail::at(st_, channel_idx{0}); }
-	[[nodiscard]] auto at() const -> const channel_data_t<ValueType, Frs>& requires (concepts::is_mono_data<Chs>) { return detail::at(st_, channel_idx{0}); }
+	[[nodiscard]] auto at() -> typename storage_type::channel_ref             requires (concepts::is_mono_data<Chs>) { return detail::at(st_, channel_idx{0}); }
+	[[nodiscard]] auto at() const -> typename storage_type::const_channel_ref requires (concepts::is_mono_data<Chs>) { return detail::at(st_, channel_idx{0}); }
 	[[nodiscard]] auto data() -> ValueType*                                requires (concepts::is_mono_data<Chs>) { return detail::data(st_, channel_idx{0}); }
 	[[nodiscard]] auto data() const -> const ValueType*                    requires (concepts::is_mono_data<Chs>) { return detail::data(st_, channel_idx{0}); }
 	[[nodiscard]] auto at(frame_idx f) -> ValueType&                       requires (concepts::is_mono_data<Chs>) { return detail::at(st_, channel_idx{0}, f); }
@@ -458,6 +1468,16 @@ struct impl {
 	auto visit(Fn fn) const -> void {
 		detail::visit(st_, fn);
 	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename Fn>
+		requires concepts::is_block_visitor_fn<ValueType, Fn>
+	auto visit_blocks(Fn fn) const -> void {
+		detail::visit_blocks<BlockSize>(st_, fn);
+	}
+	template <uint64_t BlockSize = 65536, typename Fn>
+		requires concepts::is_block_visitor_fn<ValueType, Fn>
+	auto visit_blocks_parallel(Fn fn, unsigned thread_count = 0) const -> void {
+		detail::visit_blocks_parallel<BlockSize>(st_, fn, thread_count);
+	}
 	auto resize(ads::channel_count channel_count, ads::frame_count frame_count) -> void
 		requires (Chs == DYNAMIC_EXTENT && Frs == DYNAMIC_EXTENT)
 	{
@@ -488,6 +1508,23 @@ struct impl {
 	{
 		detail::resize(st_, frame_count, fill_value);
 	}
+	// The same as resize(), but new frames are left uninitialized, for
+	// when they are about to be overwritten anyway.
+	auto resize_uninitialized(ads::channel_count channel_count, ads::frame_count frame_count) -> void
+		requires (Chs == DYNAMIC_EXTENT && Frs == DYNAMIC_EXTENT)
+	{
+		detail::resize_uninitialized(st_, channel_count, frame_count);
+	}
+	auto resize_uninitialized(ads::channel_count channel_count) -> void
+		requires (Chs == DYNAMIC_EXTENT && Frs == DYNAMIC_EXTENT)
+	{
+		detail::resize_uninitialized(st_, channel_count);
+	}
+	auto resize_uninitialized(ads::frame_count frame_count) -> void
+		requires (Frs == DYNAMIC_EXTENT)
+	{
+		detail::resize_uninitialized(st_, frame_count);
+	}
 	auto set(frame_idx f, frame_t<ValueType, Chs> value) -> void {
 		auto pos = std::begin(value);
 		for (size_t c = 0; c < detail::get_channel_count(st_).value; c++) {
@@ -497,9 +1534,20 @@ struct impl {
 	auto set(channel_idx ch, frame_idx f, ValueType value) -> void {
 		detail::set(st_, ch, f, value);
 	}
+	auto set_unchecked(channel_idx ch, frame_idx f, ValueType value) -> void {
+		detail::at_unchecked(st_, ch, f) = value;
+	}
 	auto fill(ValueType value) -> void {
 		detail::fill(st_, value);
 	}
+	// The same as fill(), but shared out between threads in blocks of
+	// BlockSize frames. Filling a buffer from make_uninitialized() this
+	// way is the first time its memory is touched, which spreads it
+	// across the memory nearest to each thread.
+	template <uint64_t BlockSize = 65536>
+	auto fill_parallel(ValueType value, unsigned thread_count = 0) -> void {
+		detail::fill_parallel<BlockSize>(st_, value, thread_count);
+	}
 	template <typename ReadFn>
 		requires concepts::is_read_fn<ValueType, ReadFn>
 	auto read(ReadFn read_fn) const -> frame_count {
@@ -540,10 +1588,10 @@ struct impl {
 	auto read(channel_idx ch, frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
 		return detail::read(st_, ch, start, n, read_fn);
 	}
-	auto write(frame_idx start, const impl<ValueType, Chs, Frs>& data) -> frame_count {
+	auto write(frame_idx start, const impl& data) -> frame_count {
 		return detail::write(st_, start, data.get_frame_count(), data.st_);
 	}
-	auto write(const impl<ValueType, Chs, Frs>& data) -> frame_count {
+	auto write(const impl& data) -> frame_count {
 		return detail::write(st_, frame_idx{0}, data.get_frame_count(), data.st_);
 	}
 	template <typename WriteFn>
@@ -586,57 +1634,98 @@ struct impl {
 	auto write(channel_idx ch, frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
 		return detail::write(st_, ch, start, n, write_fn);
 	}
+	// Block callbacks receive a pointer to every channel at once, so
+	// cross-channel processing can be done in one pass. BlockSize splits
+	// the range into blocks of at most that many frames.
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename ReadFn>
+		requires concepts::is_block_read_fn<ValueType, ReadFn>
+	auto read_blocks(ReadFn read_fn) const -> frame_count {
+		return detail::read_blocks<BlockSize>(st_, frame_idx{0}, get_frame_count(), read_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename ReadFn>
+		requires concepts::is_block_read_fn<ValueType, ReadFn>
+	auto read_blocks(frame_idx start, frame_count n, ReadFn read_fn) const -> frame_count {
+		return detail::read_blocks<BlockSize>(st_, start, n, read_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename WriteFn>
+		requires concepts::is_block_write_fn<ValueType, WriteFn>
+	auto write_blocks(WriteFn write_fn) -> frame_count {
+		return detail::write_blocks<BlockSize>(st_, frame_idx{0}, get_frame_count(), write_fn);
+	}
+	template <uint64_t BlockSize = DYNAMIC_EXTENT, typename WriteFn>
+		requires concepts::is_block_write_fn<ValueType, WriteFn>
+	auto write_blocks(frame_idx start, frame_count n, WriteFn write_fn) -> frame_count {
+		return detail::write_blocks<BlockSize>(st_, start, n, write_fn);
+	}
 private:
-	alignas(16) storage<ValueType, Chs, Frs> st_;
+	alignas(std::max(Policy::alignment, alignof(storage_type))) storage_type st_;
 };
 
 } // namespace detail
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs> using data   = detail::impl<ValueType, Chs, Frs>;
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy = default_policy> using data = detail::impl<ValueType, Chs, Frs, Policy>;
 template <typename ValueType, uint64_t Frs>               using mono   = data<ValueType, 1, Frs>;
 template <typename ValueType, uint64_t Frs>               using stereo = data<ValueType, 2, Frs>;
 template <typename ValueType> using dynamic_mono   = mono<ValueType, DYNAMIC_EXTENT>;
 template <typename ValueType> using dynamic_stereo = stereo<ValueType, DYNAMIC_EXTENT>;
 template <typename ValueType> using fully_dynamic  = data<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT>;
+template <typename ValueType> using planar_stereo  = data<ValueType, 2, DYNAMIC_EXTENT, planar_policy>;
+template <typename ValueType> using fully_planar   = data<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, planar_policy>;
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs> [[nodiscard]] auto as_channel_range(data<ValueType, Chs, Frs>& st)       { return std::ranges::subrange(st.channels_begin(), st.channels_end()); }
-template <typename ValueType, uint64_t Chs, uint64_t Frs> [[nodiscard]] auto as_channel_range(const data<ValueType, Chs, Frs>& st) { return std::ranges::subrange(st.channels_cbegin(), st.channels_cend()); }
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy> [[nodiscard]] auto as_channel_range(data<ValueType, Chs, Frs, Policy>& st)       { return std::ranges::subrange(st.channels_begin(), st.channels_end()); }
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy> [[nodiscard]] auto as_channel_range(const data<ValueType, Chs, Frs, Policy>& st) { return std::ranges::subrange(st.channels_cbegin(), st.channels_cend()); }
 
-template <typename ValueType> [[nodiscard]]
-auto make(ads::channel_count channel_count, ads::frame_count frame_count) -> data<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT> {
+template <typename ValueType, typename Policy = default_policy> [[nodiscard]]
+auto make(ads::channel_count channel_count, ads::frame_count frame_count, const typename Policy::allocator& alloc = {}) -> data<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, Policy> {
 	if (channel_count.value > detail::SANE_NUMBER_OF_CHANNELS) { throw std::invalid_argument{std::format("ads::make(): Channel count {} is too high", channel_count.value)}; }
 	if (frame_count.value > detail::SANE_NUMBER_OF_FRAMES)     { throw std::invalid_argument{std::format("ads::make(): Frame count {} is too high", frame_count.value)}; }
-	detail::storage<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT> st;
-	st.resize(channel_count.value);
-	for (auto& channel : st) {
-		channel.resize(frame_count.value);
-	}
+	detail::select_storage_t<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, Policy> st{alloc};
+	detail::resize(st, channel_count, frame_count);
 	return {std::move(st)};
 }
 
-template <typename ValueType, uint64_t Chs> [[nodiscard]]
-auto make(ads::frame_count frame_count) -> data<ValueType, Chs, DYNAMIC_EXTENT> {
+template <typename ValueType, uint64_t Chs, typename Policy = default_policy> [[nodiscard]]
+auto make(ads::frame_count frame_count, const typename Policy::allocator& alloc = {}) -> data<ValueType, Chs, DYNAMIC_EXTENT, Policy> {
 	if (frame_count.value > detail::SANE_NUMBER_OF_FRAMES) { throw std::invalid_argument{std::format("ads::make(): Frame count {} is too high", frame_count.value)}; }
-	detail::storage<ValueType, Chs, DYNAMIC_EXTENT> st;
-	for (auto& channel : st) {
-		channel.resize(frame_count.value);
-	}
+	detail::select_storage_t<ValueType, Chs, DYNAMIC_EXTENT, Policy> st{alloc};
+	detail::resize(st, frame_count);
 	return {std::move(st)};
 }
 
-template <typename ValueType, uint64_t Frs> [[nodiscard]]
-auto make(ads::channel_count channel_count) -> data<ValueType, DYNAMIC_EXTENT, Frs> {
+template <typename ValueType, uint64_t Frs, typename Policy = default_policy> [[nodiscard]]
+auto make(ads::channel_count channel_count, const typename Policy::allocator& alloc = {}) -> data<ValueType, DYNAMIC_EXTENT, Frs, Policy> {
 	if (channel_count.value > detail::SANE_NUMBER_OF_CHANNELS) { throw std::invalid_argument{std::format("ads::make(): Channel count {} is too high", channel_count.value)}; }
-	detail::storage<ValueType, DYNAMIC_EXTENT, Frs> st;
-	st.resize(channel_count.value);
+	detail::select_storage_t<ValueType, DYNAMIC_EXTENT, Frs, Policy> st{alloc};
+	detail::resize(st, channel_count);
 	return {std::move(st)};
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs> [[nodiscard]]
-auto make() -> data<ValueType, Chs, Frs> {
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy = default_policy> [[nodiscard]]
+auto make() -> data<ValueType, Chs, Frs, Policy> {
 	return {};
 }
 
+// The same as make(), but the samples are left uninitialized, so the
+// memory isn't touched until it is written. For buffers which are about
+// to be overwritten, e.g. by reading a file, or filled with
+// fill_parallel().
+template <typename ValueType, typename Policy = default_policy> [[nodiscard]]
+auto make_uninitialized(ads::channel_count channel_count, ads::frame_count frame_count, const typename Policy::allocator& alloc = {}) -> data<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, Policy> {
+	if (channel_count.value > detail::SANE_NUMBER_OF_CHANNELS) { throw std::invalid_argument{std::format("ads::make_uninitialized(): Channel count {} is too high", channel_count.value)}; }
+	if (frame_count.value > detail::SANE_NUMBER_OF_FRAMES)     { throw std::invalid_argument{std::format("ads::make_uninitialized(): Frame count {} is too high", frame_count.value)}; }
+	detail::select_storage_t<ValueType, DYNAMIC_EXTENT, DYNAMIC_EXTENT, Policy> st{alloc};
+	detail::resize_uninitialized(st, channel_count, frame_count);
+	return {std::move(st)};
+}
+
+template <typename ValueType, uint64_t Chs, typename Policy = default_policy> [[nodiscard]]
+auto make_uninitialized(ads::frame_count frame_count, const typename Policy::allocator& alloc = {}) -> data<ValueType, Chs, DYNAMIC_EXTENT, Policy> {
+	if (frame_count.value > detail::SANE_NUMBER_OF_FRAMES) { throw std::invalid_argument{std::format("ads::make_uninitialized(): Frame count {} is too high", frame_count.value)}; }
+	detail::select_storage_t<ValueType, Chs, DYNAMIC_EXTENT, Policy> st{alloc};
+	detail::resize_uninitialized(st, frame_count);
+	return {std::move(st)};
+}
+
 template <typename ValueType, uint64_t Frs> [[nodiscard]] auto make_mono() -> mono<ValueType, Frs>     { return make<ValueType, 1, Frs>(); } 
 template <typename ValueType, uint64_t Frs> [[nodiscard]] auto make_stereo() -> stereo<ValueType, Frs> { return make<ValueType, 2, Frs>(); }
 template <typename ValueType> [[nodiscard]] auto make_mono(ads::frame_count frame_count) -> dynamic_mono<ValueType>     { return make<ValueType, 1>(frame_count); } 
@@ -646,7 +1735,6 @@ template <std::ranges::input_range Frames, typename OutputIterator>
 	requires
 		is_frame_ref<std::iter_value_t<OutputIterator>, std::ranges::range_value_t<Frames>>
 auto deinterleave(Frames&& input, OutputIterator output) -> void {
-	static auto channel_count = std::size(*output);
 	auto pos = std::begin(input);
 	auto end = std::end(input);
 	while (pos != end) {
@@ -689,11 +1777,90 @@ auto interleave(Input&& input, OutputIterator output) -> void {
 	} while (progress);
 }
 
-template <typename ValueType, uint64_t Chs, uint64_t Frs, typename OutputIterator>
-auto interleave(const data<ValueType, Chs, Frs>& input, OutputIterator output) -> void {
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy, typename OutputIterator>
+auto interleave(const data<ValueType, Chs, Frs, Policy>& input, OutputIterator output) -> void {
 	interleave(as_channel_range(input), output);
 }
 
+namespace detail {
+
+// Generic fallback which transposes a block of frames at a time, so the
+// strided side of the copy stays in cache. Chs is used as a
+// compile-time channel count if it is known.
+template <uint64_t Chs, typename ValueType>
+auto interleave_blocked(const ValueType* const* channels, uint64_t channel_count, uint64_t start, uint64_t frame_count, ValueType* output) -> void {
+	constexpr uint64_t BLOCK_SIZE = 64;
+	const auto chs = Chs == DYNAMIC_EXTENT ? channel_count : Chs;
+	for (auto block = start; block < frame_count; block += BLOCK_SIZE) {
+		const auto block_end = std::min(block + BLOCK_SIZE, frame_count);
+		for (uint64_t c = 0; c < chs; c++) {
+			const auto src = channels[c];
+			for (auto f = block; f < block_end; f++) {
+				output[f * chs + c] = src[f];
+			}
+		}
+	}
+}
+
+template <uint64_t Chs, typename ValueType>
+auto deinterleave_blocked(const ValueType* input, uint64_t channel_count, uint64_t start, uint64_t frame_count, ValueType* const* channels) -> void {
+	constexpr uint64_t BLOCK_SIZE = 64;
+	const auto chs = Chs == DYNAMIC_EXTENT ? channel_count : Chs;
+	for (auto block = start; block < frame_count; block += BLOCK_SIZE) {
+		const auto block_end = std::min(block + BLOCK_SIZE, frame_count);
+		for (uint64_t c = 0; c < chs; c++) {
+			const auto dest = channels[c];
+			for (auto f = block; f < block_end; f++) {
+				dest[f] = input[f * chs + c];
+			}
+		}
+	}
+}
+
+template <uint64_t Chs, typename ValueType>
+auto interleave(const ValueType* const* channels, uint64_t channel_count, uint64_t frame_count, ValueType* output) -> void {
+	uint64_t done = 0;
+	if constexpr (std::is_same_v<ValueType, float>) {
+		done = simd::interleave(channels, channel_count, frame_count, output);
+	}
+	interleave_blocked<Chs>(channels, channel_count, done, frame_count, output);
+}
+
+template <uint64_t Chs, typename ValueType>
+auto deinterleave(const ValueType* input, uint64_t channel_count, uint64_t frame_count, ValueType* const* channels) -> void {
+	uint64_t done = 0;
+	if constexpr (std::is_same_v<ValueType, float>) {
+		done = simd::deinterleave(input, channel_count, frame_count, channels);
+	}
+	deinterleave_blocked<Chs>(input, channel_count, done, frame_count, channels);
+}
+
+template <typename Data> [[nodiscard]]
+auto get_channel_pointers(Data& data) {
+	channel_pointers_t<decltype(data.data(channel_idx{0})), Data::storage_type::CHANNEL_COUNT> pointers;
+	if constexpr (Data::storage_type::CHANNEL_COUNT == DYNAMIC_EXTENT) {
+		pointers.resize(data.get_channel_count().value);
+	}
+	for (ads::channel_idx ch = {0}; ch < data.get_channel_count(); ch++) {
+		pointers[ch.value] = data.data(ch);
+	}
+	return pointers;
+}
+
+} // namespace detail
+
+// Interleaves frame_count frames of each channel into output, which must
+// have room for channel_count * frame_count values.
+template <typename ValueType>
+auto interleave(const ValueType* const* channels, ads::channel_count channel_count, ads::frame_count frame_count, ValueType* output) -> void {
+	detail::interleave<DYNAMIC_EXTENT>(channels, channel_count.value, frame_count.value, output);
+}
+
+template <typename ValueType>
+auto deinterleave(const ValueType* input, ads::channel_count channel_count, ads::frame_count frame_count, ValueType* const* channels) -> void {
+	detail::deinterleave<DYNAMIC_EXTENT>(input, channel_count.value, frame_count.value, channels);
+}
+
 template <typename ValueType>
 struct interleaved {
 	interleaved() = default;
@@ -733,4 +1900,26 @@ private:
 	dynamic_mono<ValueType> data_;
 };
 
+// Converts as many frames as both sides have room for, and returns the
+// number of frames converted. The channel counts must match.
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy>
+auto interleave(const data<ValueType, Chs, Frs, Policy>& input, interleaved<ValueType>& output) -> frame_count {
+	if (input.get_channel_count() != output.get_channel_count()) {
+		throw std::invalid_argument{std::format("ads::interleave(): Channel count mismatch ({} != {})", input.get_channel_count().value, output.get_channel_count().value)};
+	}
+	const auto frame_count = std::min(input.get_frame_count(), output.get_frame_count());
+	detail::interleave<Chs>(detail::get_channel_pointers(input).data(), input.get_channel_count().value, frame_count.value, output.data());
+	return frame_count;
+}
+
+template <typename ValueType, uint64_t Chs, uint64_t Frs, typename Policy>
+auto deinterleave(const interleaved<ValueType>& input, data<ValueType, Chs, Frs, Policy>& output) -> frame_count {
+	if (input.get_channel_count() != output.get_channel_count()) {
+		throw std::invalid_argument{std::format("ads::deinterleave(): Channel count mismatch ({} != {})", input.get_channel_count().value, output.get_channel_count().value)};
+	}
+	const auto frame_count = std::min(input.get_frame_count(), output.get_frame_count());
+	detail::deinterleave<Chs>(input.data(), output.get_channel_count().value, frame_count.value, detail::get_channel_pointers(output).data());
+	return frame_count;
+}
+
 } // namespace ads
@@ -1,11 +1,39 @@
 #include "ads-vocab.hpp"
 #define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <new>
 #include <numeric>
+#include <random>
 #include "ads.hpp"
+#include "ads-view.hpp"
+#include "ads-convert.hpp"
+#include "ads-interpolate.hpp"
+#include "ads-io.hpp"
+#include "ads-kernels.hpp"
+#include "ads-mmap.hpp"
+#include "ads-paged.hpp"
+#include "ads-resample.hpp"
+#include "ads-ring.hpp"
+#include "ads-sparse.hpp"
+#include "ads-stats.hpp"
 #include "doctest.h"
 
-template <uint64_t Chs, uint64_t Frs>
-auto write_read_iota(ads::data<float, Chs, Frs>* st, ads::channel_idx ch) -> void {
+static size_t allocation_count = 0;
+
+auto operator new(size_t size) -> void* {
+	allocation_count++;
+	if (const auto ptr = std::malloc(size)) { return ptr; }
+	throw std::bad_alloc{};
+}
+
+auto operator delete(void* ptr) noexcept -> void         { std::free(ptr); }
+auto operator delete(void* ptr, size_t) noexcept -> void { std::free(ptr); }
+
+template <uint64_t Chs, uint64_t Frs, typename Policy>
+auto write_read_iota(ads::data<float, Chs, Frs, Policy>* st, ads::channel_idx ch) -> void {
 	ads::frame_count count;
 	count = st->write(ch, [](float* buffer, ads::frame_idx start, ads::frame_count frame_count) {
 		std::iota(buffer, buffer + frame_count.value, 0.0f);
@@ -280,3 +308,1190 @@ TEST_CASE("lerp compile") {
 	auto value1 = d1.at(ads::channel_idx{1}, 5.0);
 	auto value2 = d2.at(ads::channel_idx{1}, 5.0);
 }
+
+TEST_CASE("planar storage") {
+	auto st = ads::make<float, ads::planar_policy>(ads::channel_count{3}, ads::frame_count{10});
+	REQUIRE (st.get_channel_count() == ads::channel_count{3});
+	REQUIRE (st.get_frame_count() == ads::frame_count{10});
+	// One allocation, with every channel the same distance apart.
+	const auto stride = st.data(ads::channel_idx{1}) - st.data(ads::channel_idx{0});
+	REQUIRE (stride >= 10);
+	REQUIRE (st.data(ads::channel_idx{2}) - st.data(ads::channel_idx{1}) == stride);
+	REQUIRE (reinterpret_cast<uintptr_t>(st.data(ads::channel_idx{1})) % 16 == 0);
+	write_read_iota(&st, ads::channel_idx{0});
+	write_read_iota(&st, ads::channel_idx{2});
+	st.set(ads::channel_idx{1}, ads::frame_idx{3}, 5.0f);
+	st.resize(ads::channel_count{4}, ads::frame_count{20});
+	REQUIRE (st.get_frame_count() == ads::frame_count{20});
+	CHECK (st.at(ads::channel_idx{0}, ads::frame_idx{9}) == 9.0f);
+	CHECK (st.at(ads::channel_idx{1}, ads::frame_idx{3}) == 5.0f);
+	CHECK (st.at(ads::channel_idx{2}, ads::frame_idx{9}) == 9.0f);
+	CHECK (st.at(ads::channel_idx{2}, ads::frame_idx{15}) == 0.0f);
+	CHECK (st.at(ads::channel_idx{3}, ads::frame_idx{0}) == 0.0f);
+	CHECK_THROWS (st.at(ads::channel_idx{0}, ads::frame_idx{20}));
+	auto stereo = ads::make<float, 2, ads::planar_policy>(ads::frame_count{4});
+	auto interleaved = std::vector<float>{0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f};
+	ads::deinterleave(interleaved, stereo.begin());
+	CHECK (stereo.at(ads::channel_idx{0}, ads::frame_idx{3}) == 6.0f);
+	CHECK (stereo.at(ads::channel_idx{1}, ads::frame_idx{3}) == 7.0f);
+	auto output = std::vector<float>(8);
+	ads::interleave(stereo, output.begin());
+	CHECK (output == interleaved);
+	stereo = ads::make<float, ads::planar_policy>(ads::channel_count{1}, ads::frame_count{6});
+	REQUIRE (stereo.get_frame_count() == ads::frame_count{6});
+}
+
+TEST_CASE("alignment and channel padding") {
+	using policy = ads::with_alignment<ads::default_policy, 64>;
+	using planar = ads::with_alignment<ads::planar_policy, 64>;
+	auto separate = ads::make<float, policy>(ads::channel_count{3}, ads::frame_count{10});
+	auto contiguous = ads::make<float, 4, planar>(ads::frame_count{10});
+	auto fixed = ads::make<float, 2, 10, policy>();
+	REQUIRE (separate.get_padded_frame_count() == ads::frame_count{16});
+	REQUIRE (contiguous.get_padded_frame_count() == ads::frame_count{16});
+	REQUIRE (fixed.get_padded_frame_count() == ads::frame_count{16});
+	for (ads::channel_idx ch = {0}; ch < 3; ch++) {
+		REQUIRE (reinterpret_cast<uintptr_t>(separate.data(ch)) % 64 == 0);
+	}
+	for (ads::channel_idx ch = {0}; ch < 4; ch++) {
+		REQUIRE (reinterpret_cast<uintptr_t>(contiguous.data(ch)) % 64 == 0);
+	}
+	REQUIRE (contiguous.data(ads::channel_idx{1}) - contiguous.data(ads::channel_idx{0}) == 16);
+	REQUIRE (reinterpret_cast<uintptr_t>(fixed.data(ads::channel_idx{0})) % 64 == 0);
+	REQUIRE (reinterpret_cast<uintptr_t>(fixed.data(ads::channel_idx{1})) % 64 == 0);
+	// Padding in planar storage is zeroed, and writing to it doesn't
+	// touch the next channel.
+	contiguous.write([](float* buffer, ads::frame_idx start, ads::frame_count frame_count) {
+		std::fill(buffer, buffer + frame_count.value, 1.0f);
+		return frame_count;
+	});
+	REQUIRE (contiguous.data(ads::channel_idx{0})[15] == 0.0f);
+	std::fill(contiguous.data(ads::channel_idx{0}), contiguous.data(ads::channel_idx{0}) + 16, 2.0f);
+	REQUIRE (contiguous.at(ads::channel_idx{1}, ads::frame_idx{0}) == 1.0f);
+	write_read_iota(&separate, ads::channel_idx{2});
+	write_read_iota(&contiguous, ads::channel_idx{3});
+}
+
+TEST_CASE("allocators") {
+	// Any allocation which doesn't come from the arena will throw.
+	std::array<std::byte, 16384> buffer;
+	std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+	auto separate = ads::make<float, ads::pmr::policy>(ads::channel_count{4}, ads::frame_count{100}, &arena);
+	auto planar = ads::make<float, ads::pmr::planar_policy>(ads::channel_count{4}, ads::frame_count{100}, &arena);
+	auto stereo = ads::make<float, 2, ads::pmr::policy>(ads::frame_count{100}, &arena);
+	auto aligned = ads::make<float, ads::with_alignment<ads::pmr::planar_policy, 64>>(ads::channel_count{2}, ads::frame_count{100}, &arena);
+	REQUIRE (separate.get_allocator().resource() == &arena);
+	REQUIRE (planar.get_allocator().resource() == &arena);
+	REQUIRE (stereo.get_allocator().resource() == &arena);
+	REQUIRE (reinterpret_cast<uintptr_t>(aligned.data(ads::channel_idx{1})) % 64 == 0);
+	separate.resize(ads::channel_count{5}, ads::frame_count{50});
+	planar.resize(ads::channel_count{5}, ads::frame_count{50});
+	write_read_iota(&separate, ads::channel_idx{4});
+	write_read_iota(&planar, ads::channel_idx{4});
+	write_read_iota(&stereo, ads::channel_idx{1});
+	// Copies don't inherit the arena (the same as std::pmr containers.)
+	auto copy = planar;
+	REQUIRE (copy.get_allocator().resource() == std::pmr::get_default_resource());
+	REQUIRE (copy.at(ads::channel_idx{4}, ads::frame_idx{49}) == 49.0f);
+	auto exhausted = std::pmr::monotonic_buffer_resource{std::pmr::null_memory_resource()};
+	auto make_from_exhausted = [&exhausted] { return ads::make<float, ads::pmr::policy>(ads::channel_count{1}, ads::frame_count{10}, &exhausted); };
+	REQUIRE_THROWS_AS (make_from_exhausted(), std::bad_alloc);
+}
+
+TEST_CASE("views") {
+	auto data = ads::make<float>(ads::channel_count{2}, ads::frame_count{10});
+	write_read_iota(&data, ads::channel_idx{0});
+	write_read_iota(&data, ads::channel_idx{1});
+	// Views share memory with the data they were made from.
+	ads::view<float> v = data;
+	auto cv = ads::const_view<float, 2>{data};
+	REQUIRE (v.get_channel_count() == ads::channel_count{2});
+	REQUIRE (cv.get_frame_count() == ads::frame_count{10});
+	REQUIRE (v.data(ads::channel_idx{1}) == data.data(ads::channel_idx{1}));
+	v.set(ads::channel_idx{1}, ads::frame_idx{0}, 100.0f);
+	REQUIRE (cv.at(ads::channel_idx{1}, ads::frame_idx{0}) == 100.0f);
+	// Slicing doesn't copy either.
+	auto slice = v.slice({ads::frame_idx{4}, ads::frame_idx{8}});
+	REQUIRE (slice.get_frame_count() == ads::frame_count{4});
+	REQUIRE (slice.at(ads::channel_idx{0}, ads::frame_idx{0}) == 4.0f);
+	slice.fill(-1.0f);
+	REQUIRE (data.at(ads::channel_idx{0}, ads::frame_idx{3}) == 3.0f);
+	REQUIRE (data.at(ads::channel_idx{0}, ads::frame_idx{4}) == -1.0f);
+	REQUIRE (data.at(ads::channel_idx{1}, ads::frame_idx{7}) == -1.0f);
+	REQUIRE (data.at(ads::channel_idx{1}, ads::frame_idx{8}) == 8.0f);
+	REQUIRE_THROWS_AS (v.slice({ads::frame_idx{4}, ads::frame_idx{11}}), std::out_of_range);
+	REQUIRE_THROWS_AS (slice.at(ads::channel_idx{0}, ads::frame_idx{4}), std::out_of_range);
+	// Frame iteration.
+	auto frames = 0;
+	for (auto frame : cv.slice({ads::frame_idx{8}, ads::frame_idx{10}})) {
+		REQUIRE (*frame[0] == 8.0f + frames);
+		frames++;
+	}
+	REQUIRE (frames == 2);
+	for (auto frame : slice) {
+		*frame[1] = 5.0f;
+	}
+	REQUIRE (data.at(ads::channel_idx{1}, ads::frame_idx{5}) == 5.0f);
+	// Foreign memory, with a stride between channels.
+	auto buffer = std::vector<float>(32, 0.0f);
+	auto strided = ads::view<float, 2>{buffer.data(), ads::channel_count{2}, ads::frame_count{10}, 16};
+	REQUIRE (strided.data(ads::channel_idx{1}) == buffer.data() + 16);
+	REQUIRE (strided.write(ads::frame_idx{2}, cv.slice({ads::frame_idx{0}, ads::frame_idx{4}})) == ads::frame_count{4});
+	REQUIRE (buffer[5] == 3.0f);
+	REQUIRE (buffer[18] == 100.0f);
+	auto sum = 0.0f;
+	strided.read(ads::channel_idx{0}, [&sum](const float* buffer, ads::frame_idx start, ads::frame_count frame_count) {
+		sum = std::accumulate(buffer, buffer + frame_count.value, 0.0f);
+		return frame_count;
+	});
+	REQUIRE (sum == 6.0f);
+	auto planar = ads::make<float, ads::planar_policy>(ads::channel_count{3}, ads::frame_count{4});
+	ads::view<float> planar_view = planar;
+	planar_view.slice({ads::frame_idx{1}, ads::frame_idx{2}}).fill(1.0f);
+	REQUIRE (planar.at(ads::channel_idx{2}, ads::frame_idx{1}) == 1.0f);
+	REQUIRE_THROWS_AS ((ads::view<float, 3>{buffer.data(), ads::channel_count{2}, ads::frame_count{10}}), std::invalid_argument);
+}
+
+template <typename ValueType>
+auto check_interleave_round_trip(ads::channel_count chs, ads::frame_count frs) -> void {
+	auto input = ads::make<ValueType>(chs, frs);
+	input.visit([&input](ads::channel_idx ch, ads::frame_idx fr, ValueType) {
+		input.set(ch, fr, static_cast<ValueType>(ch.value * 1000 + fr.value));
+	});
+	auto buffer = ads::interleaved<ValueType>{chs, frs};
+	REQUIRE (ads::interleave(input, buffer) == frs);
+	for (uint64_t f = 0; f < frs.value; f++) {
+		for (uint64_t c = 0; c < chs.value; c++) {
+			REQUIRE (buffer.at(f * chs.value + c) == static_cast<ValueType>(c * 1000 + f));
+		}
+	}
+	auto output = ads::make<ValueType>(chs, frs);
+	REQUIRE (ads::deinterleave(buffer, output) == frs);
+	for (ads::channel_idx ch = {0}; ch < chs; ch++) {
+		REQUIRE (std::equal(input.at(ch).begin(), input.at(ch).end(), output.at(ch).begin()));
+	}
+}
+
+TEST_CASE("interleave kernels") {
+	for (uint64_t chs = 1; chs <= 9; chs++) {
+		for (const auto frs : {0, 1, 3, 4, 8, 17, 67, 200}) {
+			check_interleave_round_trip<float>(ads::channel_count{chs}, ads::frame_count{static_cast<uint64_t>(frs)});
+			check_interleave_round_trip<double>(ads::channel_count{chs}, ads::frame_count{static_cast<uint64_t>(frs)});
+		}
+	}
+	// Compile-time channel counts and raw pointers.
+	auto stereo = ads::make<float, 2>(ads::frame_count{13});
+	std::iota(stereo.data(ads::channel_idx{0}), stereo.data(ads::channel_idx{0}) + 13, 0.0f);
+	std::iota(stereo.data(ads::channel_idx{1}), stereo.data(ads::channel_idx{1}) + 13, 100.0f);
+	auto buffer = std::vector<float>(26);
+	const float* channels[] = {stereo.data(ads::channel_idx{0}), stereo.data(ads::channel_idx{1})};
+	ads::interleave(channels, ads::channel_count{2}, ads::frame_count{13}, buffer.data());
+	REQUIRE (buffer[24] == 12.0f);
+	REQUIRE (buffer[25] == 112.0f);
+	auto planar = ads::make<float, ads::planar_policy>(ads::channel_count{2}, ads::frame_count{13});
+	float* planar_channels[] = {planar.data(ads::channel_idx{0}), planar.data(ads::channel_idx{1})};
+	ads::deinterleave(buffer.data(), ads::channel_count{2}, ads::frame_count{13}, planar_channels);
+	REQUIRE (planar.at(ads::channel_idx{1}, ads::frame_idx{7}) == 107.0f);
+	// Views, and a mismatched channel count.
+	auto six = ads::interleaved<float>{ads::channel_count{6}, ads::frame_count{9}};
+	std::iota(six.begin(), six.end(), 0.0f);
+	auto surround = ads::make<float, 6, 16>();
+	REQUIRE (ads::deinterleave(six, ads::view<float, 6>{surround}.slice({ads::frame_idx{4}, ads::frame_idx{16}})) == ads::frame_count{9});
+	REQUIRE (surround.at(ads::channel_idx{5}, ads::frame_idx{12}) == 53.0f);
+	REQUIRE_THROWS_AS (ads::interleave(stereo, six), std::invalid_argument);
+}
+
+TEST_CASE("frame iteration") {
+	auto data = ads::make<float>(ads::channel_count{16}, ads::frame_count{100});
+	auto planar = ads::make<float, ads::planar_policy>(ads::channel_count{16}, ads::frame_count{100});
+	auto interleaved = std::vector<float>(1600);
+	std::iota(interleaved.begin(), interleaved.end(), 0.0f);
+	const auto allocations = allocation_count;
+	auto frame_number = 0.0f;
+	for (auto frame : data) {
+		for (auto ptr : frame) {
+			*ptr = frame_number;
+		}
+		frame_number++;
+	}
+	auto sum = 0.0f;
+	for (auto frame : std::as_const(data)) {
+		for (uint64_t c = 0; c < frame.size(); c++) {
+			sum += *frame[c];
+		}
+	}
+	ads::deinterleave(interleaved, planar.begin());
+	const auto new_allocations = allocation_count - allocations;
+	REQUIRE (new_allocations == 0);
+	REQUIRE (sum == 16.0f * (99.0f * 100.0f / 2.0f));
+	REQUIRE (data.at(ads::channel_idx{15}, ads::frame_idx{42}) == 42.0f);
+	REQUIRE (planar.at(ads::channel_idx{3}, ads::frame_idx{2}) == 35.0f);
+	auto it = data.begin() + 10;
+	REQUIRE (*(*it)[7] == 10.0f);
+	REQUIRE ((it + 90) == data.end());
+}
+
+TEST_CASE("block read and write") {
+	auto data = ads::make<float, 2>(ads::frame_count{300});
+	std::fill(data.data(ads::channel_idx{0}), data.data(ads::channel_idx{0}) + 300, 3.0f);
+	std::fill(data.data(ads::channel_idx{1}), data.data(ads::channel_idx{1}) + 300, 1.0f);
+	// Mid/side in one pass, 64 frames at a time.
+	auto blocks = std::vector<uint64_t>{};
+	const auto written = data.write_blocks<64>([&blocks](std::span<float* const> channels, ads::frame_idx start, ads::frame_count frame_count) {
+		REQUIRE (channels.size() == 2);
+		blocks.push_back(frame_count.value);
+		for (uint64_t i = 0; i < frame_count.value; i++) {
+			const auto l = channels[0][i];
+			const auto r = channels[1][i];
+			channels[0][i] = (l + r) * 0.5f;
+			channels[1][i] = (l - r) * 0.5f;
+		}
+		return frame_count;
+	});
+	REQUIRE (written == ads::frame_count{300});
+	REQUIRE (blocks == std::vector<uint64_t>{64, 64, 64, 64, 44});
+	REQUIRE (data.at(ads::channel_idx{0}, ads::frame_idx{299}) == 2.0f);
+	REQUIRE (data.at(ads::channel_idx{1}, ads::frame_idx{0}) == 1.0f);
+	// The range is clipped to the data, and returning fewer frames stops early.
+	auto starts = std::vector<int64_t>{};
+	const auto read = data.read_blocks<128>(ads::frame_idx{100}, ads::frame_count{1000}, [&starts](std::span<const float* const> channels, ads::frame_idx start, ads::frame_count frame_count) {
+		REQUIRE (channels[1][0] == 1.0f);
+		starts.push_back(start.value);
+		return start.value < 200 ? frame_count : ads::frame_count{10};
+	});
+	REQUIRE (read == ads::frame_count{138});
+	REQUIRE (starts == std::vector<int64_t>{100, 228});
+	// Dynamic channel counts and views.
+	auto planar = ads::make<float, ads::planar_policy>(ads::channel_count{12}, ads::frame_count{10});
+	ads::view<float>{planar}.slice({ads::frame_idx{5}, ads::frame_idx{10}}).write_blocks([](std::span<float* const> channels, ads::frame_idx start, ads::frame_count frame_count) {
+		for (uint64_t c = 0; c < channels.size(); c++) {
+			std::fill(channels[c], channels[c] + frame_count.value, static_cast<float>(c));
+		}
+		return frame_count;
+	});
+	REQUIRE (planar.at(ads::channel_idx{11}, ads::frame_idx{4}) == 0.0f);
+	REQUIRE (planar.at(ads::channel_idx{11}, ads::frame_idx{5}) == 11.0f);
+}
+
+TEST_CASE("bounds checking") {
+	static_assert (std::is_same_v<ads::default_policy::bounds_check, ads::bounds::checked>);
+	auto checked = ads::make<float>(ads::channel_count{2}, ads::frame_count{10});
+	REQUIRE_THROWS_AS ((void)checked.at(ads::channel_idx{2}), std::out_of_range);
+	REQUIRE_THROWS_AS ((void)checked.at(ads::channel_idx{1}, ads::frame_idx{10}), std::out_of_range);
+	REQUIRE_THROWS_AS ((void)checked.at(ads::channel_idx{1}, ads::frame_idx{-1}), std::out_of_range);
+	REQUIRE_THROWS_AS (checked.set(ads::channel_idx{0}, ads::frame_idx{10}, 1.0f), std::out_of_range);
+	REQUIRE_THROWS_AS ((void)checked.data(ads::channel_idx{3}), std::out_of_range);
+	checked.set_unchecked(ads::channel_idx{1}, ads::frame_idx{9}, 4.0f);
+	REQUIRE (checked.at_unchecked(ads::channel_idx{1}, ads::frame_idx{9}) == 4.0f);
+	REQUIRE (checked.at_unchecked(ads::channel_idx{1}).size() == 10);
+	using unchecked_policy = ads::with_bounds_check<ads::planar_policy, ads::bounds::unchecked>;
+	auto unchecked = ads::make<float, 2, unchecked_policy>(ads::frame_count{10});
+	unchecked.set(ads::channel_idx{1}, ads::frame_idx{3}, 2.0f);
+	REQUIRE (unchecked.at(ads::channel_idx{1}, ads::frame_idx{3}) == 2.0f);
+	write_read_iota(&unchecked, ads::channel_idx{1});
+	auto sum = 0.0f;
+	unchecked.visit([&sum](ads::channel_idx, ads::frame_idx, float value) { sum += value; });
+	REQUIRE (sum == 45.0f);
+	const auto view = ads::const_view<float>{checked};
+	REQUIRE (view.at_unchecked(ads::channel_idx{1}, ads::frame_idx{9}) == 4.0f);
+	REQUIRE_THROWS_AS ((void)view.at(ads::channel_idx{0}, ads::frame_idx{10}), std::out_of_range);
+}
+
+TEST_CASE("block visitors") {
+	auto data = ads::make<float>(ads::channel_count{3}, ads::frame_count{1000});
+	for (ads::channel_idx ch = {0}; ch < 3; ch++) {
+		std::iota(data.data(ch), data.data(ch) + 1000, static_cast<float>(ch.value));
+	}
+	auto peaks = std::array<float, 3>{};
+	auto spans = 0;
+	data.visit_blocks<256>([&](ads::channel_idx ch, ads::frame_idx start, std::span<const float> block) {
+		REQUIRE (block.size() == (start.value == 768 ? 232 : 256));
+		REQUIRE (block[0] == static_cast<float>(ch.value + start.value));
+		peaks[ch.value] = std::max(peaks[ch.value], *std::ranges::max_element(block));
+		spans++;
+	});
+	REQUIRE (spans == 12);
+	REQUIRE (peaks == std::array<float, 3>{999.0f, 1000.0f, 1001.0f});
+	// Every frame is visited exactly once.
+	auto sum = std::atomic<uint64_t>{0};
+	auto blocks = std::atomic<int>{0};
+	data.visit_blocks_parallel<100>([&](ads::channel_idx ch, ads::frame_idx start, std::span<const float> block) {
+		sum += static_cast<uint64_t>(std::accumulate(block.begin(), block.end(), 0.0));
+		blocks++;
+	}, 4);
+	REQUIRE (blocks == 30);
+	REQUIRE (sum == 3 * (999 * 1000 / 2) + 1000 + 2000);
+	auto whole_channels = std::atomic<int>{0};
+	ads::const_view<float>{data}.visit_blocks_parallel<ads::DYNAMIC_EXTENT>([&](ads::channel_idx, ads::frame_idx, std::span<const float> block) {
+		if (block.size() == 1000) { whole_channels++; }
+	});
+	REQUIRE (whole_channels == 3);
+	const auto throwing_visit = [&data] {
+		data.visit_blocks_parallel<10>([](ads::channel_idx ch, ads::frame_idx start, std::span<const float>) {
+			if (ch.value == 2 && start.value == 500) { throw std::runtime_error{"clipping"}; }
+		});
+	};
+	REQUIRE_THROWS_AS (throwing_visit(), std::runtime_error);
+}
+
+TEST_CASE("arithmetic kernels") {
+	auto a = ads::make<float>(ads::channel_count{2}, ads::frame_count{37});
+	auto b = ads::make<float>(ads::channel_count{2}, ads::frame_count{37});
+	a.fill(2.0f);
+	b.fill(1.0f);
+	ads::apply_gain(a, 0.5f);
+	REQUIRE (a.at(ads::channel_idx{1}, ads::frame_idx{36}) == 1.0f);
+	REQUIRE (ads::add(a, b) == ads::frame_count{37});
+	REQUIRE (a.at(ads::channel_idx{0}, ads::frame_idx{35}) == 2.0f);
+	REQUIRE (ads::add_scaled(a, ads::const_view<float>{b}, 0.25f) == ads::frame_count{37});
+	REQUIRE (a.at(ads::channel_idx{1}, ads::frame_idx{0}) == 2.25f);
+	const auto gains = std::array{1.0f, 2.0f};
+	ads::add_scaled(a, b, gains);
+	REQUIRE (a.at(ads::channel_idx{0}, ads::frame_idx{20}) == 3.25f);
+	REQUIRE (a.at(ads::channel_idx{1}, ads::frame_idx{20}) == 4.25f);
+	ads::apply_gain(ads::view<float>{a}.slice({ads::frame_idx{30}, ads::frame_idx{37}}), std::span{gains});
+	REQUIRE (a.at(ads::channel_idx{1}, ads::frame_idx{29}) == 4.25f);
+	REQUIRE (a.at(ads::channel_idx{1}, ads::frame_idx{30}) == 8.5f);
+	// Linear ramp from 0 to 1 over 37 frames.
+	ads::apply_gain_ramp(b, 0.0f, 1.0f);
+	for (ads::frame_idx fr = {0}; fr < 37; fr++) {
+		REQUIRE (b.at(ads::channel_idx{1}, fr) == doctest::Approx(fr.value / 37.0f));
+	}
+	// Exponential ramp, halving over the range.
+	auto c = ads::make<double, 1>(ads::frame_count{19});
+	auto d = ads::make<float, 1>(ads::frame_count{19});
+	c.fill(1.0);
+	d.fill(1.0f);
+	ads::apply_gain_ramp_exp(c, 1.0, 0.5);
+	ads::apply_gain_ramp_exp(d, 1.0f, 0.5f);
+	for (ads::frame_idx fr = {0}; fr < 19; fr++) {
+		REQUIRE (c.at(fr) == doctest::Approx(std::pow(0.5, fr.value / 19.0)));
+		REQUIRE (d.at(fr) == doctest::Approx(std::pow(0.5, fr.value / 19.0)));
+	}
+	REQUIRE_THROWS_AS (ads::apply_gain_ramp_exp(c, 0.0, 1.0), std::invalid_argument);
+	auto mono = ads::make<float>(ads::channel_count{1}, ads::frame_count{37});
+	REQUIRE_THROWS_AS (ads::add(mono, b), std::invalid_argument);
+	static_assert (!ads::concepts::is_mutable_channel_data<ads::const_view<float>>);
+	static_assert (ads::concepts::is_mutable_channel_data<ads::view<float>>);
+}
+
+template <typename In, typename Out>
+auto check_conversion(const std::vector<In>& in) -> void {
+	for (size_t n = 0; n <= in.size(); n += 7) {
+		std::vector<Out> out(n);
+		ads::convert(in.data(), out.data(), n);
+		for (size_t i = 0; i < n; i++) {
+			const auto expected = ads::detail::convert::convert_sample<In, Out>(in[i]);
+			REQUIRE (std::memcmp(&out[i], &expected, sizeof(Out)) == 0);
+		}
+	}
+}
+
+TEST_CASE("sample format conversion") {
+	std::vector<float> floats(100);
+	for (size_t i = 0; i < floats.size(); i++) {
+		floats[i] = std::sin(static_cast<float>(i) * 0.3f) * 1.2f;
+	}
+	floats[3] = 1.0f;
+	floats[4] = -1.0f;
+	std::vector<int16_t> s16(100);
+	std::vector<ads::int24_t> s24(100);
+	std::vector<int32_t> s32(100);
+	ads::convert(floats.data(), s16.data(), 100);
+	ads::convert(floats.data(), s24.data(), 100);
+	ads::convert(floats.data(), s32.data(), 100);
+	REQUIRE (s16[3] == 32767);
+	REQUIRE (s16[4] == -32768);
+	REQUIRE (ads::detail::convert::load_int(s24[3]) == 8388607);
+	REQUIRE (ads::detail::convert::load_int(s24[4]) == -8388608);
+	REQUIRE (s32[3] == 2147483520);
+	REQUIRE (s32[4] == std::numeric_limits<int32_t>::min());
+	check_conversion<float, int16_t>(floats);
+	check_conversion<float, ads::int24_t>(floats);
+	check_conversion<float, int32_t>(floats);
+	check_conversion<float, double>(floats);
+	check_conversion<int16_t, float>(s16);
+	check_conversion<ads::int24_t, float>(s24);
+	check_conversion<int32_t, float>(s32);
+	check_conversion<int32_t, int16_t>(s32);
+	check_conversion<int16_t, ads::int24_t>(s16);
+	REQUIRE (ads::detail::convert::convert_sample<int16_t, float>(int16_t{-16384}) == -0.5f);
+	REQUIRE (ads::detail::convert::convert_sample<double, int16_t>(0.5) == 16384);
+	REQUIRE (ads::detail::convert::convert_sample<int16_t, ads::int24_t>(int16_t{-2}).bytes[0] == 0x00);
+	REQUIRE (ads::detail::convert::convert_sample<int16_t, ads::int24_t>(int16_t{-2}).bytes[1] == 0xFE);
+	// Runtime formats
+	std::vector<float> back(100);
+	ads::convert(reinterpret_cast<const std::byte*>(s24.data()), ads::sample_format::int24, reinterpret_cast<std::byte*>(back.data()), ads::sample_format::float32, 100);
+	for (size_t i = 0; i < 100; i++) {
+		REQUIRE (back[i] == doctest::Approx(std::clamp(floats[i], -1.0f, 1.0f)).epsilon(1e-6));
+	}
+	// Dither changes the result by at most one step.
+	ads::tpdf_dither dither;
+	std::vector<int16_t> dithered(100);
+	ads::convert(floats.data(), dithered.data(), 100, dither);
+	REQUIRE (dithered != s16);
+	for (size_t i = 0; i < 100; i++) {
+		REQUIRE (std::abs(dithered[i] - s16[i]) <= 1);
+	}
+	// Planar
+	auto planar_in  = ads::make<int16_t>(ads::channel_count{2}, ads::frame_count{50});
+	auto planar_out = ads::make<float>(ads::channel_count{2}, ads::frame_count{60});
+	planar_in.fill(int16_t{8192});
+	REQUIRE (ads::convert(planar_in, planar_out) == ads::frame_count{50});
+	REQUIRE (planar_out.at(ads::channel_idx{1}, ads::frame_idx{49}) == 0.25f);
+	REQUIRE (ads::convert(planar_out, ads::view<int16_t>{planar_in}, dither) == ads::frame_count{50});
+	REQUIRE (std::abs(planar_in.at(ads::channel_idx{0}, ads::frame_idx{10}) - 8192) <= 1);
+}
+
+template <typename Out>
+auto check_fused_deinterleave(uint64_t channel_count, uint64_t frame_count) -> void {
+	std::vector<ads::int24_t> in(channel_count * frame_count);
+	for (size_t i = 0; i < in.size(); i++) {
+		in[i] = ads::detail::convert::store_int<ads::int24_t>(static_cast<int32_t>(i * 7919) % 8388608 - 4194304);
+	}
+	std::vector<Out> converted(in.size());
+	ads::convert(in.data(), converted.data(), in.size());
+	auto expected = ads::make<Out>(ads::channel_count{channel_count}, ads::frame_count{frame_count});
+	auto output   = ads::make<Out>(ads::channel_count{channel_count}, ads::frame_count{frame_count + 5});
+	ads::deinterleave(converted.data(), ads::channel_count{channel_count}, ads::frame_count{frame_count}, ads::detail::get_channel_pointers(expected).data());
+	const auto done = ads::deinterleave(reinterpret_cast<const std::byte*>(in.data()), ads::sample_format::int24, ads::channel_count{channel_count}, ads::frame_count{frame_count}, output);
+	REQUIRE (done == ads::frame_count{frame_count});
+	for (ads::channel_idx ch = {0}; ch < channel_count; ch++) {
+		for (ads::frame_idx fr = {0}; fr < frame_count; fr++) {
+			REQUIRE (output.at(ch, fr) == expected.at(ch, fr));
+		}
+	}
+}
+
+TEST_CASE("fused deinterleave and convert") {
+	check_fused_deinterleave<float>(1, 3000);
+	check_fused_deinterleave<float>(2, 3000);
+	check_fused_deinterleave<float>(3, 1001);
+	check_fused_deinterleave<float>(8, 999);
+	check_fused_deinterleave<float>(10, 300);
+	check_fused_deinterleave<double>(2, 1025);
+	auto stereo = ads::make<float, 2>(ads::frame_count{4});
+	const int16_t pcm[] = {0, 16384, -16384, 8192, 0, 0, 0, 0};
+	const auto bytes = reinterpret_cast<const std::byte*>(pcm);
+	REQUIRE (ads::deinterleave(bytes, ads::sample_format::int16, ads::channel_count{2}, ads::frame_count{4}, ads::view<float>{stereo}.slice({ads::frame_idx{1}, ads::frame_idx{4}})) == ads::frame_count{3});
+	REQUIRE (stereo.at(ads::channel_idx{1}, ads::frame_idx{1}) == 0.5f);
+	REQUIRE (stereo.at(ads::channel_idx{0}, ads::frame_idx{2}) == -0.5f);
+	REQUIRE (stereo.at(ads::channel_idx{1}, ads::frame_idx{2}) == 0.25f);
+	REQUIRE_THROWS_AS (ads::deinterleave(bytes, ads::sample_format::int16, ads::channel_count{1}, ads::frame_count{8}, stereo), std::invalid_argument);
+	const auto before = allocation_count;
+	ads::deinterleave(bytes, ads::sample_format::int16, ads::channel_count{2}, ads::frame_count{4}, stereo);
+	REQUIRE (allocation_count == before);
+}
+
+template <typename T>
+auto write_bytes(const std::filesystem::path& path, const std::vector<T>& values, const std::string& prefix = {}) -> void {
+	std::ofstream file{path, std::ios::binary};
+	file.write(prefix.data(), static_cast<std::streamsize>(prefix.size()));
+	file.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+}
+
+auto make_float_wav_header(uint16_t channel_count, uint32_t data_size) -> std::string {
+	std::string header;
+	const auto put = [&header](uint64_t value, int bytes) {
+		for (int i = 0; i < bytes; i++) { header.push_back(static_cast<char>((value >> (i * 8)) & 0xFF)); }
+	};
+	header += "RIFF"; put(36 + data_size, 4); header += "WAVE";
+	header += "fmt "; put(16, 4); put(3, 2); put(channel_count, 2); put(48000, 4); put(48000 * 4 * channel_count, 4); put(4 * channel_count, 2); put(32, 2);
+	header += "data"; put(data_size, 4);
+	return header;
+}
+
+TEST_CASE("memory-mapped data") {
+	const auto dir = std::filesystem::temp_directory_path();
+	const auto raw = dir / "ads-test-mapped.raw";
+	std::vector<float> samples(300);
+	std::iota(samples.begin(), samples.end(), 0.0f);
+	write_bytes(raw, samples);
+	{
+		const auto mapped = ads::map_raw<const float, 2>(raw);
+		mapped.advise(ads::access_hint::sequential);
+		REQUIRE (mapped.get_channel_count() == ads::channel_count{2});
+		REQUIRE (mapped.get_frame_count() == ads::frame_count{150});
+		REQUIRE (mapped.at(ads::channel_idx{0}, ads::frame_idx{10}) == 10.0f);
+		REQUIRE (mapped.at(ads::channel_idx{1}, ads::frame_idx{10}) == 160.0f);
+		static_assert (!ads::concepts::is_mutable_channel_data<decltype(mapped)>);
+		REQUIRE (mapped.data(ads::channel_idx{1})[3] == 153.0f);
+	}
+	{
+		auto mapped = ads::map_raw<float>(raw, ads::channel_count{3});
+		REQUIRE (mapped.get_frame_count() == ads::frame_count{100});
+		mapped.set(ads::channel_idx{2}, ads::frame_idx{0}, -1.0f);
+		REQUIRE (mapped.at(ads::channel_idx{2}, ads::frame_idx{0}) == -1.0f);
+		auto moved = std::move(mapped);
+		REQUIRE (moved.at(ads::channel_idx{2}, ads::frame_idx{0}) == -1.0f);
+		ads::const_view<float> view = moved.as_view();
+		REQUIRE (view.at(ads::channel_idx{1}, ads::frame_idx{1}) == 101.0f);
+	}
+	// Copy-on-write changes never reach the file.
+	REQUIRE (ads::map_raw<const float>(raw, ads::channel_count{3}).at(ads::channel_idx{2}, ads::frame_idx{0}) == 200.0f);
+	REQUIRE_THROWS_AS (static_cast<void>(ads::map_raw<const float>(raw, ads::channel_count{7})), std::runtime_error);
+	REQUIRE_THROWS_AS (static_cast<void>(ads::map_raw<const float>(dir / "ads-test-missing.raw", ads::channel_count{1})), std::runtime_error);
+	const auto wav = dir / "ads-test-mapped.wav";
+	write_bytes(wav, samples, make_float_wav_header(1, 1200));
+	{
+		auto mapped = ads::map_wav<const float>(wav);
+		REQUIRE (mapped.get_frame_count() == ads::frame_count{300});
+		REQUIRE (mapped.at(ads::channel_idx{0}, ads::frame_idx{299}) == 299.0f);
+		REQUIRE_THROWS_AS (static_cast<void>(ads::map_wav<const double>(wav)), std::runtime_error);
+	}
+	write_bytes(wav, samples, make_float_wav_header(2, 1200));
+	REQUIRE_THROWS_AS (static_cast<void>(ads::map_wav<const float>(wav)), std::runtime_error);
+	std::filesystem::remove(raw);
+	std::filesystem::remove(wav);
+}
+
+TEST_CASE("audio file streaming") {
+	const auto path = std::filesystem::temp_directory_path() / "ads-test-stream";
+	auto source = ads::make<float>(ads::channel_count{3}, ads::frame_count{30001});
+	for (ads::channel_idx ch = {0}; ch < 3; ch++) {
+		for (ads::frame_idx fr = {0}; fr < 30001; fr++) {
+			source.set(ch, fr, std::sin(static_cast<float>(fr.value) * 0.01f * static_cast<float>(ch.value + 1)) * 0.9f);
+		}
+	}
+	const auto types   = std::array{ads::file_type::wav, ads::file_type::w64, ads::file_type::aiff};
+	const auto formats = std::array{ads::sample_format::int16, ads::sample_format::int24, ads::sample_format::int32, ads::sample_format::float32, ads::sample_format::float64};
+	for (const auto type : types) {
+		for (const auto format : formats) {
+			{
+				ads::file_writer writer{path, type, format, ads::channel_count{3}, 44100.0};
+				writer.write(ads::const_view<float>{source}.slice({ads::frame_idx{0}, ads::frame_idx{1000}}));
+				writer.write(ads::const_view<float>{source}.slice({ads::frame_idx{1000}, ads::frame_idx{30001}}));
+			}
+			ads::file_reader reader{path};
+			REQUIRE (reader.get_info().type == type);
+			REQUIRE (reader.get_info().format == format);
+			REQUIRE (reader.get_info().channel_count == ads::channel_count{3});
+			REQUIRE (reader.get_info().frame_count == ads::frame_count{30001});
+			REQUIRE (reader.get_info().sample_rate == 44100.0);
+			const auto tolerance = format == ads::sample_format::int16 ? 1.0 / 32768.0 : 1e-6;
+			auto block = ads::make<float>(ads::channel_count{3}, ads::frame_count{4096});
+			ads::frame_idx pos = {0};
+			for (auto n = reader.read(block); n > 0; n = reader.read(block)) {
+				for (ads::channel_idx ch = {0}; ch < 3; ch++) {
+					for (ads::frame_idx fr = {0}; fr < n.value; fr++) {
+						REQUIRE (block.at(ch, fr) == doctest::Approx(source.at(ch, ads::frame_idx{pos.value + fr.value})).epsilon(tolerance).scale(1.0));
+					}
+				}
+				pos.value += n.value;
+			}
+			REQUIRE (pos == ads::frame_idx{30001});
+			// Seek and read into part of a view.
+			reader.seek(ads::frame_idx{20000});
+			auto doubles = ads::make<double>(ads::channel_count{3}, ads::frame_count{10});
+			REQUIRE (reader.read(ads::view<double>{doubles}.slice({ads::frame_idx{5}, ads::frame_idx{10}})) == ads::frame_count{5});
+			REQUIRE (doubles.at(ads::channel_idx{2}, ads::frame_idx{7}) == doctest::Approx(source.at(ads::channel_idx{2}, ads::frame_idx{20002})).epsilon(tolerance).scale(1.0));
+			REQUIRE (reader.get_position() == ads::frame_idx{20005});
+		}
+	}
+	// Files written by other programs.
+	std::vector<float> samples(10);
+	std::iota(samples.begin(), samples.end(), 0.0f);
+	write_bytes(path, samples, make_float_wav_header(2, 40));
+	const auto loaded = ads::read_file<float>(path);
+	REQUIRE (loaded.get_channel_count() == ads::channel_count{2});
+	REQUIRE (loaded.get_frame_count() == ads::frame_count{5});
+	REQUIRE (loaded.at(ads::channel_idx{1}, ads::frame_idx{4}) == 9.0f);
+	ads::file_reader reader{path};
+	auto mono = ads::make<float>(ads::channel_count{1}, ads::frame_count{5});
+	REQUIRE_THROWS_AS (reader.read(mono), std::invalid_argument);
+	REQUIRE_THROWS_AS (reader.seek(ads::frame_idx{6}), std::out_of_range);
+	write_bytes(path, samples, "nonsense");
+	REQUIRE_THROWS_AS (ads::file_reader{path}, std::runtime_error);
+	std::filesystem::remove(path);
+}
+
+TEST_CASE("paged storage") {
+	ads::paged<float, 2, 64> rec;
+	for (int i = 0; i < 100; i++) {
+		rec.append({static_cast<float>(i), static_cast<float>(-i)});
+	}
+	REQUIRE (rec.get_frame_count() == ads::frame_count{100});
+	REQUIRE (rec.get_page_count() == 2);
+	const auto first_page = &rec.at(ads::channel_idx{0}, ads::frame_idx{0});
+	// Appending a block which is split across pages.
+	auto block = ads::make<float, 2>(ads::frame_count{200});
+	for (ads::frame_idx fr = {0}; fr < 200; fr++) {
+		block.set(fr, {static_cast<float>(100 + fr.value), static_cast<float>(-100 - fr.value)});
+	}
+	REQUIRE (rec.append(block) == ads::frame_count{200});
+	REQUIRE (rec.get_frame_count() == ads::frame_count{300});
+	REQUIRE (rec.get_page_count() == 5);
+	REQUIRE (&rec.at(ads::channel_idx{0}, ads::frame_idx{0}) == first_page);
+	for (ads::frame_idx fr = {0}; fr < 300; fr++) {
+		REQUIRE (rec.at(ads::channel_idx{0}, fr) == static_cast<float>(fr.value));
+		REQUIRE (rec.at(ads::channel_idx{1}, fr) == static_cast<float>(-fr.value));
+	}
+	// Callbacks are split at page boundaries.
+	std::vector<std::pair<int64_t, uint64_t>> chunks;
+	const auto read = rec.read(ads::channel_idx{1}, ads::frame_idx{60}, ads::frame_count{100}, [&](const float* buffer, ads::frame_idx start, ads::frame_count n) {
+		for (uint64_t i = 0; i < n.value; i++) {
+			REQUIRE (buffer[i] == static_cast<float>(-(start.value + static_cast<int64_t>(i))));
+		}
+		chunks.emplace_back(start.value, n.value);
+		return n;
+	});
+	REQUIRE (read == ads::frame_count{100});
+	REQUIRE (chunks == std::vector<std::pair<int64_t, uint64_t>>{{60, 4}, {64, 64}, {128, 32}});
+	REQUIRE (rec.write(ads::frame_idx{250}, [](float* buffer, ads::channel_idx, ads::frame_idx, ads::frame_count n) {
+		std::fill_n(buffer, n.value, 1.0f);
+		return n;
+	}) == ads::frame_count{50});
+	REQUIRE (rec.at(ads::channel_idx{1}, ads::frame_idx{299}) == 1.0f);
+	uint64_t blocks = 0;
+	REQUIRE (rec.read_blocks<16>(ads::frame_idx{0}, ads::frame_count{300}, [&](std::span<const float* const> channels, ads::frame_idx start, ads::frame_count n) {
+		REQUIRE (channels.size() == 2);
+		REQUIRE (channels[0][0] == rec.at(ads::channel_idx{0}, start));
+		REQUIRE (channels[1][n.value - 1] == rec.at(ads::channel_idx{1}, start + n - 1));
+		blocks++;
+		return n;
+	}) == ads::frame_count{300});
+	REQUIRE (blocks == 300 / 16 + 1);
+	// Copies are deep, and reserved pages make growth allocation-free.
+	const auto copy = rec;
+	rec.set(ads::channel_idx{0}, ads::frame_idx{0}, 42.0f);
+	REQUIRE (copy.at(ads::channel_idx{0}, ads::frame_idx{0}) == 0.0f);
+	rec.reserve(ads::frame_count{1000});
+	const auto before = allocation_count;
+	rec.resize(ads::frame_count{1000});
+	REQUIRE (allocation_count == before);
+	REQUIRE (rec.at(ads::channel_idx{1}, ads::frame_idx{999}) == 0.0f);
+	rec.resize(ads::frame_count{10});
+	rec.shrink_to_fit();
+	REQUIRE (rec.get_page_count() == 1);
+	REQUIRE_THROWS_AS (static_cast<void>(rec.at(ads::channel_idx{0}, ads::frame_idx{10})), std::out_of_range);
+	ads::paged<float> dynamic{ads::channel_count{3}};
+	REQUIRE_THROWS_AS (dynamic.append(block), std::invalid_argument);
+}
+
+TEST_CASE("copy-on-write storage") {
+	auto original = ads::make<float, ads::shared_policy>(ads::channel_count{3}, ads::frame_count{100000});
+	original.set(ads::channel_idx{1}, ads::frame_idx{10}, 1.0f);
+	const auto before = allocation_count;
+	auto copy = original;
+	REQUIRE (allocation_count == before);
+	for (ads::channel_idx ch = {0}; ch < 3; ch++) {
+		REQUIRE (std::as_const(copy).data(ch) == std::as_const(original).data(ch));
+	}
+	// Writing only copies the channel which is written to.
+	copy.set(ads::channel_idx{1}, ads::frame_idx{10}, 2.0f);
+	REQUIRE (std::as_const(copy).data(ads::channel_idx{0}) == std::as_const(original).data(ads::channel_idx{0}));
+	REQUIRE (std::as_const(copy).data(ads::channel_idx{1}) != std::as_const(original).data(ads::channel_idx{1}));
+	REQUIRE (original.at(ads::channel_idx{1}, ads::frame_idx{10}) == 1.0f);
+	REQUIRE (copy.at(ads::channel_idx{1}, ads::frame_idx{10}) == 2.0f);
+	// Once a channel is no longer shared it is written in place.
+	const auto detached = std::as_const(copy).data(ads::channel_idx{1});
+	copy.set(ads::channel_idx{1}, ads::frame_idx{11}, 3.0f);
+	REQUIRE (std::as_const(copy).data(ads::channel_idx{1}) == detached);
+	// Reading never copies.
+	auto snapshot = copy;
+	REQUIRE (snapshot.read(ads::channel_idx{1}, [](const float* buffer, ads::frame_idx, ads::frame_count n) { return n; }) == ads::frame_count{100000});
+	REQUIRE (std::as_const(snapshot).data(ads::channel_idx{1}) == detached);
+	// Writing through callbacks or frame iteration copies as well.
+	snapshot.write(ads::channel_idx{2}, [](float* buffer, ads::frame_idx, ads::frame_count n) {
+		std::fill_n(buffer, n.value, 0.5f);
+		return n;
+	});
+	REQUIRE (copy.at(ads::channel_idx{2}, ads::frame_idx{0}) == 0.0f);
+	ads::const_view<float> view = snapshot;
+	REQUIRE (view.at(ads::channel_idx{2}, ads::frame_idx{0}) == 0.5f);
+	auto stereo = ads::make<double, 2, ads::shared_policy>(ads::frame_count{64});
+	auto stereo_copy = stereo;
+	*(*stereo_copy.begin())[0] = 1.0;
+	REQUIRE (stereo.at(ads::channel_idx{0}, ads::frame_idx{0}) == 0.0);
+	REQUIRE (stereo_copy.at(ads::channel_idx{0}, ads::frame_idx{0}) == 1.0);
+	// Resizing a shared channel leaves the other copy alone.
+	stereo_copy.resize(ads::frame_count{32});
+	REQUIRE (stereo.get_frame_count() == ads::frame_count{64});
+	REQUIRE (stereo_copy.get_frame_count() == ads::frame_count{32});
+	REQUIRE (stereo_copy.at(ads::channel_idx{0}, ads::frame_idx{0}) == 1.0);
+	std::pmr::monotonic_buffer_resource arena;
+	auto pmr_data = ads::make<float, ads::pmr::shared_policy>(ads::channel_count{2}, ads::frame_count{16}, &arena);
+	auto pmr_copy = pmr_data;
+	pmr_copy.fill(1.0f);
+	REQUIRE (pmr_data.at(ads::channel_idx{1}, ads::frame_idx{15}) == 0.0f);
+	REQUIRE (pmr_copy.get_allocator().resource() == &arena);
+}
+
+TEST_CASE("sparse storage") {
+	ads::sparse<float, 2, 64> tracks{ads::frame_count{1000}};
+	REQUIRE (tracks.get_block_count() == 16);
+	REQUIRE (tracks.get_allocated_block_count() == 0);
+	REQUIRE (tracks.at(ads::channel_idx{1}, ads::frame_idx{999}) == 0.0f);
+	// Only the blocks which aren't silent are kept.
+	auto source = ads::make<float, 2>(ads::frame_count{1000});
+	source.set(ads::channel_idx{0}, ads::frame_idx{100}, 0.5f);
+	source.set(ads::channel_idx{1}, ads::frame_idx{900}, -0.25f);
+	REQUIRE (tracks.write(source) == ads::frame_count{1000});
+	REQUIRE (tracks.get_allocated_block_count() == 2);
+	REQUIRE (tracks.is_silent(ads::channel_idx{0}, ads::frame_idx{0}));
+	REQUIRE (!tracks.is_silent(ads::channel_idx{0}, ads::frame_idx{127}));
+	REQUIRE (tracks.at(ads::channel_idx{0}, ads::frame_idx{100}) == 0.5f);
+	REQUIRE (tracks.at(ads::channel_idx{1}, ads::frame_idx{900}) == -0.25f);
+	// Silent blocks read back as zeros, or as null with read_sparse().
+	float sum = 0.0f;
+	uint64_t silent_frames = 0;
+	REQUIRE (tracks.read(ads::channel_idx{1}, [&](const float* buffer, ads::frame_idx, ads::frame_count n) {
+		sum += std::accumulate(buffer, buffer + n.value, 0.0f);
+		return n;
+	}) == ads::frame_count{1000});
+	REQUIRE (sum == -0.25f);
+	REQUIRE (tracks.read_sparse(ads::channel_idx{1}, ads::frame_idx{10}, ads::frame_count{990}, [&](const float* buffer, ads::frame_idx start, ads::frame_count n) {
+		REQUIRE (start.value / 64 == (start.value + static_cast<int64_t>(n.value) - 1) / 64);
+		if (!buffer) { silent_frames += n.value; }
+		return n;
+	}) == ads::frame_count{990});
+	REQUIRE (silent_frames == 990 - 64);
+	// Writing silence releases blocks.
+	tracks.write(ads::channel_idx{0}, ads::frame_idx{64}, ads::frame_count{64}, [](float* buffer, ads::frame_idx, ads::frame_count n) {
+		std::fill_n(buffer, n.value, 0.0f);
+		return n;
+	});
+	REQUIRE (tracks.get_allocated_block_count() == 1);
+	tracks.set(ads::channel_idx{0}, ads::frame_idx{0}, 0.0f);
+	REQUIRE (tracks.get_allocated_block_count() == 1);
+	tracks.set(ads::channel_idx{0}, ads::frame_idx{0}, 1.0f);
+	REQUIRE (tracks.get_allocated_block_count() == 2);
+	tracks.set(ads::channel_idx{0}, ads::frame_idx{0}, 0.0f);
+	tracks.compact();
+	REQUIRE (tracks.get_allocated_block_count() == 1);
+	// Copies are deep.
+	auto copy = tracks;
+	tracks.fill(0.0f);
+	REQUIRE (tracks.get_allocated_block_count() == 0);
+	REQUIRE (copy.at(ads::channel_idx{1}, ads::frame_idx{900}) == -0.25f);
+	// Shrinking zeroes the end of the last block.
+	copy.resize(ads::frame_count{899});
+	copy.resize(ads::frame_count{1000});
+	REQUIRE (copy.at(ads::channel_idx{1}, ads::frame_idx{900}) == 0.0f);
+	// Values below the threshold are treated as silence.
+	ads::sparse<double> quiet{ads::channel_count{1}, ads::frame_count{128}, 1e-6};
+	quiet.fill(1e-7);
+	REQUIRE (quiet.get_allocated_block_count() == 0);
+	quiet.set(ads::channel_idx{0}, ads::frame_idx{5}, 0.1);
+	REQUIRE (quiet.get_allocated_block_count() == 1);
+	REQUIRE_THROWS_AS (static_cast<void>(quiet.at(ads::channel_idx{1}, ads::frame_idx{0})), std::out_of_range);
+}
+
+TEST_CASE("ring buffer") {
+	ads::ring_buffer<float, 2> ring{ads::frame_count{100}};
+	REQUIRE (ring.get_capacity() == ads::frame_count{100});
+	REQUIRE (ring.get_write_available() == ads::frame_count{100});
+	auto block = ads::make<float, 2>(ads::frame_count{70});
+	for (ads::frame_idx fr = {0}; fr < 70; fr++) {
+		block.set(fr, {static_cast<float>(fr.value), static_cast<float>(-fr.value)});
+	}
+	REQUIRE (ring.write(block) == ads::frame_count{70});
+	REQUIRE (ring.skip(ads::frame_count{50}) == ads::frame_count{50});
+	// The next write wraps around, so the callback is called twice.
+	std::vector<std::pair<int64_t, uint64_t>> parts;
+	REQUIRE (ring.write(ads::frame_count{70}, [&](std::span<float* const> channels, ads::frame_idx start, ads::frame_count n) {
+		for (uint64_t i = 0; i < n.value; i++) {
+			channels[0][i] = static_cast<float>(100 + start.value + static_cast<int64_t>(i));
+			channels[1][i] = 0.0f;
+		}
+		parts.emplace_back(start.value, n.value);
+		return n;
+	}) == ads::frame_count{70});
+	REQUIRE (parts == std::vector<std::pair<int64_t, uint64_t>>{{0, 30}, {30, 40}});
+	REQUIRE (ring.get_read_available() == ads::frame_count{90});
+	REQUIRE (ring.write(block) == ads::frame_count{10});
+	auto out = ads::make<float, 2>(ads::frame_count{100});
+	REQUIRE (ring.read(out) == ads::frame_count{100});
+	REQUIRE (out.at(ads::channel_idx{0}, ads::frame_idx{0}) == 50.0f);
+	REQUIRE (out.at(ads::channel_idx{1}, ads::frame_idx{19}) == -69.0f);
+	REQUIRE (out.at(ads::channel_idx{0}, ads::frame_idx{20}) == 100.0f);
+	REQUIRE (out.at(ads::channel_idx{0}, ads::frame_idx{89}) == 169.0f);
+	REQUIRE (out.at(ads::channel_idx{0}, ads::frame_idx{99}) == 9.0f);
+	REQUIRE (ring.read(out) == ads::frame_count{0});
+	// Neither side allocates.
+	const auto before = allocation_count;
+	REQUIRE (ring.write(block) == ads::frame_count{70});
+	REQUIRE (ring.read(out) == ads::frame_count{70});
+	REQUIRE (allocation_count == before);
+	// One thread writes a ramp while another reads it.
+	ads::ring_buffer<double> stream{ads::channel_count{3}, ads::frame_count{257}};
+	constexpr uint64_t total = 200000;
+	uint64_t checked  = 0;
+	bool ok           = true;
+	{
+		std::jthread producer{[&stream] {
+			uint64_t written = 0;
+			while (written < total) {
+				written += stream.write(ads::frame_count{std::min<uint64_t>(total - written, 31)}, [written](double* buffer, ads::channel_idx ch, ads::frame_idx start, ads::frame_count n) {
+					for (uint64_t i = 0; i < n.value; i++) {
+						buffer[i] = static_cast<double>(written + static_cast<uint64_t>(start.value) + i) * static_cast<double>(ch.value + 1);
+					}
+					return n;
+				}).value;
+			}
+		}};
+		while (checked < total) {
+			checked += stream.read(ads::frame_count{64}, [&](const double* buffer, ads::channel_idx ch, ads::frame_idx start, ads::frame_count n) {
+				for (uint64_t i = 0; i < n.value; i++) {
+					ok = ok && buffer[i] == static_cast<double>(checked + static_cast<uint64_t>(start.value) + i) * static_cast<double>(ch.value + 1);
+				}
+				return n;
+			}).value;
+		}
+	}
+	REQUIRE (ok);
+	REQUIRE (checked == total);
+	ads::ring_buffer<float, 1, 16> fixed;
+	REQUIRE (fixed.get_capacity() == ads::frame_count{16});
+	REQUIRE_THROWS_AS (fixed.write(block), std::invalid_argument);
+}
+
+TEST_CASE("capacity and try_resize") {
+	auto check = [](auto data) {
+		data.reserve(ads::channel_count{4}, ads::frame_count{512});
+		REQUIRE (data.get_capacity() >= ads::frame_count{512});
+		REQUIRE (data.get_channel_capacity() >= ads::channel_count{4});
+		data.set(ads::channel_idx{1}, ads::frame_idx{10}, 1.0f);
+		const auto before = allocation_count;
+		REQUIRE (data.try_resize(ads::frame_count{64}));
+		REQUIRE (data.try_resize(ads::frame_count{512}, 0.5f));
+		REQUIRE (data.try_resize(ads::channel_count{1}));
+		REQUIRE (allocation_count == before);
+		REQUIRE (data.get_frame_count() == ads::frame_count{512});
+		REQUIRE (data.at(ads::channel_idx{0}, ads::frame_idx{63}) == 0.0f);
+		REQUIRE (data.at(ads::channel_idx{0}, ads::frame_idx{64}) == 0.5f);
+		REQUIRE (!data.try_resize(ads::frame_count{513}));
+		REQUIRE (data.get_frame_count() == ads::frame_count{512});
+		data.resize(ads::channel_count{2});
+		data.resize(ads::frame_count{100});
+		REQUIRE (data.at(ads::channel_idx{1}, ads::frame_idx{10}) == 0.0f);
+	};
+	check(ads::make<float>(ads::channel_count{2}, ads::frame_count{100}));
+	check(ads::make<float, ads::planar_policy>(ads::channel_count{2}, ads::frame_count{100}));
+	check(ads::make<float, ads::shared_policy>(ads::channel_count{2}, ads::frame_count{100}));
+	// Planar channels don't move when the frame count changes within the
+	// capacity, and channels can be added without allocating.
+	auto planar = ads::make<float, ads::planar_policy>(ads::channel_count{2}, ads::frame_count{100});
+	planar.reserve(ads::channel_count{8}, ads::frame_count{1024});
+	planar.set(ads::channel_idx{1}, ads::frame_idx{99}, 1.0f);
+	const auto ptr    = std::as_const(planar).data(ads::channel_idx{1});
+	const auto before = allocation_count;
+	REQUIRE (planar.try_resize(ads::channel_count{8}, ads::frame_count{1024}));
+	REQUIRE (planar.try_resize(ads::channel_count{3}, ads::frame_count{100}));
+	REQUIRE (allocation_count == before);
+	REQUIRE (std::as_const(planar).data(ads::channel_idx{1}) == ptr);
+	REQUIRE (planar.at(ads::channel_idx{1}, ads::frame_idx{99}) == 1.0f);
+	REQUIRE (!planar.try_resize(ads::channel_count{9}, ads::frame_count{100}));
+	// Separate channels allocate their own buffers when added.
+	auto separate = ads::make<float>(ads::channel_count{1}, ads::frame_count{100});
+	separate.reserve(ads::channel_count{2}, ads::frame_count{100});
+	REQUIRE (!separate.try_resize(ads::channel_count{2}));
+	// A channel which is still shared can't be resized without copying it.
+	auto shared = ads::make<float, 2, ads::shared_policy>(ads::frame_count{100});
+	shared.reserve(ads::frame_count{200});
+	const auto copy = shared;
+	REQUIRE (!shared.try_resize(ads::frame_count{150}));
+	REQUIRE (copy.get_frame_count() == ads::frame_count{100});
+	// Fixed extents have a fixed capacity.
+	auto fixed = ads::make<float, 2, 64>();
+	REQUIRE (fixed.get_capacity() == ads::frame_count{64});
+	REQUIRE (fixed.get_channel_capacity() == ads::channel_count{2});
+}
+
+TEST_CASE("uninitialized construction") {
+	// The arena is filled with a pattern, so samples which were never
+	// written to still hold it.
+	static constexpr auto PATTERN = int32_t{0x7f7f7f7f};
+	std::array<std::byte, 65536> buffer;
+	auto check = [&buffer]<typename Policy>(Policy) {
+		std::ranges::fill(buffer, std::byte{0x7f});
+		std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+		auto data = ads::make_uninitialized<int32_t, Policy>(ads::channel_count{2}, ads::frame_count{100}, &arena);
+		REQUIRE (data.get_channel_count() == ads::channel_count{2});
+		REQUIRE (data.get_frame_count() == ads::frame_count{100});
+		REQUIRE (data.at(ads::channel_idx{1}, ads::frame_idx{99}) == PATTERN);
+		data.set(ads::channel_idx{0}, ads::frame_idx{10}, 1);
+		data.resize_uninitialized(ads::channel_count{3}, ads::frame_count{200});
+		REQUIRE (data.at(ads::channel_idx{0}, ads::frame_idx{10}) == 1);
+		REQUIRE (data.at(ads::channel_idx{2}, ads::frame_idx{0}) == PATTERN);
+		data.template fill_parallel<16>(5, 4);
+		for (ads::channel_idx ch = {0}; ch < data.get_channel_count(); ch++) {
+			REQUIRE (std::ranges::all_of(std::as_const(data).at(ch), [](int32_t value) { return value == 5; }));
+		}
+		// make() and resize() still zero every sample, once.
+		auto zeroed = ads::make<int32_t, Policy>(ads::channel_count{2}, ads::frame_count{100}, &arena);
+		REQUIRE (zeroed.at(ads::channel_idx{1}, ads::frame_idx{99}) == 0);
+		zeroed.resize(ads::frame_count{200});
+		REQUIRE (zeroed.at(ads::channel_idx{1}, ads::frame_idx{199}) == 0);
+	};
+	check(ads::pmr::policy{});
+	check(ads::pmr::planar_policy{});
+	check(ads::pmr::shared_policy{});
+	// Filling in parallel copies shared channels first.
+	auto shared = ads::make<float, 2, ads::shared_policy>(ads::frame_count{1000});
+	const auto copy = shared;
+	shared.fill_parallel<64>(1.0f);
+	REQUIRE (shared.at(ads::channel_idx{1}, ads::frame_idx{999}) == 1.0f);
+	REQUIRE (copy.at(ads::channel_idx{1}, ads::frame_idx{999}) == 0.0f);
+}
+
+TEST_CASE("interpolated reads") {
+	auto data = ads::make<float>(ads::channel_count{2}, ads::frame_count{1000});
+	data.write(ads::channel_idx{1}, [](float* buffer, ads::frame_idx start, ads::frame_count n) {
+		for (uint64_t i = 0; i < n.value; i++) {
+			buffer[i] = static_cast<float>(std::sin(0.05 * static_cast<double>(start.value + i)));
+		}
+		return n;
+	});
+	std::vector<float> out(500);
+	// Linear matches at(double) everywhere inside the channel.
+	ads::read_interpolated(data, ads::channel_idx{1}, 2.5, 1.37, out);
+	for (uint64_t i = 0; i < out.size(); i++) {
+		const auto pos = 2.5 + 1.37 * static_cast<double>(i);
+		if (pos < 999.0) { REQUIRE (out[i] == doctest::Approx(data.at(ads::channel_idx{1}, pos)).epsilon(1e-5)); }
+	}
+	// Cubic and sinc are close to the underlying sine, and the same
+	// whether the positions are given by an increment or an array.
+	std::vector<double> positions(out.size());
+	for (uint64_t i = 0; i < positions.size(); i++) {
+		positions[i] = 20.0 + 0.731 * static_cast<double>(i);
+	}
+	std::vector<float> from_array(out.size());
+	auto check_sine = [&](auto interpolation, double tolerance) {
+		using interpolation_type = decltype(interpolation);
+		ads::read_interpolated<interpolation_type>(data, ads::channel_idx{1}, 20.0, 0.731, out);
+		ads::read_interpolated<interpolation_type>(data, ads::channel_idx{1}, positions, from_array);
+		for (uint64_t i = 0; i < out.size(); i++) {
+			REQUIRE (std::abs(out[i] - std::sin(0.05 * positions[i])) < tolerance);
+			REQUIRE (out[i] == doctest::Approx(from_array[i]));
+		}
+	};
+	check_sine(ads::interpolation::linear{}, 1e-3);
+	check_sine(ads::interpolation::cubic{}, 1e-4);
+	check_sine(ads::interpolation::sinc<8>{}, 1e-3);
+	check_sine(ads::interpolation::sinc<16>{}, 1e-4);
+	// Frames outside the channel read as zero, so reading backwards off
+	// the start fades out.
+	std::vector<float> edge(4);
+	data.set(ads::channel_idx{0}, ads::frame_idx{0}, 1.0f);
+	ads::read_interpolated<ads::interpolation::linear>(data, ads::channel_idx{0}, 0.5, -0.5, edge);
+	REQUIRE (edge == std::vector<float>{0.5f, 1.0f, 0.5f, 0.0f});
+	ads::read_interpolated<ads::interpolation::cubic>(data, ads::channel_idx{0}, 998.0, 1.0, edge);
+	REQUIRE (edge == std::vector<float>{0.0f, 0.0f, 0.0f, 0.0f});
+	// Other value types use the scalar implementation.
+	auto doubles = ads::make<double>(ads::channel_count{1}, ads::frame_count{100});
+	for (uint64_t i = 0; i < 100; i++) { doubles.set(ads::channel_idx{0}, ads::frame_idx{static_cast<int64_t>(i)}, static_cast<double>(i * i)); }
+	std::vector<double> quadratic(50);
+	ads::read_interpolated<ads::interpolation::cubic>(doubles, ads::channel_idx{0}, 10.25, 0.5, quadratic);
+	REQUIRE (quadratic[2] == doctest::Approx(11.25 * 11.25));
+	REQUIRE_THROWS_AS (ads::read_interpolated(data, ads::channel_idx{2}, 0.0, 1.0, out), std::out_of_range);
+	REQUIRE_THROWS_AS (ads::read_interpolated(data, ads::channel_idx{0}, std::span{positions}.first(3), out), std::invalid_argument);
+}
+
+TEST_CASE("sample rate conversion") {
+	auto sine = [](uint64_t rate, double hz, uint64_t frame_count) {
+		auto out = ads::make<float>(ads::channel_count{2}, ads::frame_count{frame_count});
+		for (uint64_t i = 0; i < frame_count; i++) {
+			const auto value = static_cast<float>(std::sin(2.0 * std::numbers::pi * hz * static_cast<double>(i) / static_cast<double>(rate)));
+			out.set(ads::channel_idx{0}, ads::frame_idx{static_cast<int64_t>(i)}, value);
+			out.set(ads::channel_idx{1}, ads::frame_idx{static_cast<int64_t>(i)}, -value);
+		}
+		return out;
+	};
+	const auto in  = sine(44100, 1000.0, 44100);
+	const auto out = ads::resample(in, 44100, 48000);
+	REQUIRE (out.get_channel_count() == ads::channel_count{2});
+	REQUIRE (out.get_frame_count() == ads::frame_count{48000});
+	REQUIRE (ads::get_resampled_frame_count(ads::frame_count{44100}, 44100, 48000) == ads::frame_count{48000});
+	const auto expected = sine(48000, 1000.0, 48000);
+	for (int64_t i = 100; i < 47900; i++) {
+		REQUIRE (std::abs(out.at(ads::channel_idx{0}, ads::frame_idx{i}) - expected.at(ads::channel_idx{0}, ads::frame_idx{i})) < 1e-3f);
+		REQUIRE (out.at(ads::channel_idx{1}, ads::frame_idx{i}) == -out.at(ads::channel_idx{0}, ads::frame_idx{i}));
+	}
+	// Parallel conversion gives exactly the same result.
+	const auto parallel = ads::resample(in, 44100, 48000, ads::resample_quality::high, 4);
+	REQUIRE (std::ranges::equal(std::as_const(parallel).at(ads::channel_idx{0}), std::as_const(out).at(ads::channel_idx{0})));
+	// Frequencies above the new Nyquist frequency are removed.
+	const auto alias = ads::resample(sine(96000, 30000.0, 9600), 96000, 44100, ads::resample_quality::medium);
+	for (int64_t i = 100; i < 4300; i++) {
+		REQUIRE (std::abs(alias.at(ads::channel_idx{0}, ads::frame_idx{i})) < 1e-2f);
+	}
+	// Streaming in uneven blocks gives the same result as converting all at
+	// once.
+	auto resampler = ads::resampler<float>{ads::channel_count{2}, 44100, 48000, ads::resample_quality::fast};
+	const auto bulk = ads::resample(in, 44100, 48000, ads::resample_quality::fast);
+	auto streamed = ads::make<float>(ads::channel_count{2}, ads::frame_count{48000});
+	// Views of frames [start, start + n) of both channels.
+	auto part = [](auto& data, uint64_t start, uint64_t n) {
+		using element_type = std::remove_pointer_t<decltype(data.data(ads::channel_idx{0}))>;
+		const auto channels = std::array{data.data(ads::channel_idx{0}) + start, data.data(ads::channel_idx{1}) + start};
+		return ads::view<element_type>{channels, ads::frame_count{n}};
+	};
+	uint64_t written = 0;
+	for (uint64_t start = 0; start < 44100; start += 1000) {
+		const auto n = std::min<uint64_t>(1000, 44100 - start);
+		written += resampler.process(part(in, start, n), part(streamed, written, std::min<uint64_t>(512, 48000 - written))).value;
+	}
+	REQUIRE (resampler.get_pending_frame_count() > ads::frame_count{0});
+	for (auto n = ads::frame_count{1}; n > ads::frame_count{0}; written += n.value) {
+		n = resampler.flush(part(streamed, written, 48000 - written));
+	}
+	REQUIRE (written == 48000);
+	for (int64_t i = 0; i < 48000; i++) {
+		REQUIRE (streamed.at(ads::channel_idx{1}, ads::frame_idx{i}) == doctest::Approx(bulk.at(ads::channel_idx{1}, ads::frame_idx{i})).epsilon(1e-4));
+	}
+	REQUIRE_THROWS_AS (resampler.process(in, streamed), std::logic_error);
+	resampler.reset();
+	REQUIRE_THROWS_AS (ads::resample(in, 0, 48000), std::invalid_argument);
+	REQUIRE_THROWS_AS (ads::resample(in, 44100, 48001), std::invalid_argument);
+}
+
+TEST_CASE("statistics") {
+	auto data = ads::make<float>(ads::channel_count{2}, ads::frame_count{200003});
+	for (int64_t i = 0; i < 200003; i++) {
+		const auto value = static_cast<float>(std::sin(static_cast<double>(i) * 0.01)) + 0.25f;
+		data.set(ads::channel_idx{0}, ads::frame_idx{i}, value);
+		data.set(ads::channel_idx{1}, ads::frame_idx{i}, -0.5f * value);
+	}
+	data.set(ads::channel_idx{0}, ads::frame_idx{123457}, -2.0f);
+	// Compare against a straightforward double precision implementation.
+	auto expected = [&data](ads::channel_idx ch, ads::region region) {
+		auto out = ads::stats<float>{};
+		for (auto i = region.beg; i < region.end; i++) {
+			const auto value = data.at(ch, i);
+			out.min = std::min(out.min, value);
+			out.max = std::max(out.max, value);
+			out.sum += value;
+			out.sum_of_squares += static_cast<double>(value) * value;
+			out.clip_count += std::abs(value) >= 1.0f ? 1 : 0;
+			out.sample_count++;
+		}
+		return out;
+	};
+	auto check = [](const ads::stats<float>& actual, const ads::stats<float>& expected) {
+		REQUIRE (actual.min == expected.min);
+		REQUIRE (actual.max == expected.max);
+		REQUIRE (actual.clip_count == expected.clip_count);
+		REQUIRE (actual.sample_count == expected.sample_count);
+		REQUIRE (actual.mean() == doctest::Approx(expected.mean()).epsilon(1e-6));
+		REQUIRE (actual.rms() == doctest::Approx(expected.rms()).epsilon(1e-6));
+	};
+	const auto whole  = ads::region{ads::frame_idx{0}, ads::frame_idx{200003}};
+	const auto region = ads::region{ads::frame_idx{1001}, ads::frame_idx{190001}};
+	const auto ch0    = ads::get_stats(data, ads::channel_idx{0}, region);
+	check(ch0, expected(ads::channel_idx{0}, region));
+	REQUIRE (ch0.peak() == 2.0f);
+	REQUIRE (ch0.clip_count > 0);
+	check(ads::get_stats(data, ads::channel_idx{1}, whole, 1.0f, 4), expected(ads::channel_idx{1}, whole));
+	// Per channel and across channels, in parallel.
+	const auto channels = ads::get_channel_stats(data, region, 1.0f, 3);
+	REQUIRE (channels.size() == 2);
+	check(channels[0], ch0);
+	check(channels[1], expected(ads::channel_idx{1}, region));
+	auto combined = expected(ads::channel_idx{0}, region);
+	combined.merge(expected(ads::channel_idx{1}, region));
+	check(ads::get_stats(data, region, 1.0f, 0), combined);
+	// Views, and empty and out of range regions.
+	const auto view = ads::view<const float>{data};
+	check(ads::get_stats(view, ads::channel_idx{1}, region), channels[1]);
+	const auto empty = ads::get_stats(view, ads::region{ads::frame_idx{5}, ads::frame_idx{5}});
+	REQUIRE (empty.sample_count == 0);
+	REQUIRE (empty.peak() == 0.0f);
+	REQUIRE (empty.rms() == 0.0);
+	REQUIRE_THROWS_AS ((void)ads::get_stats(data, ads::region{ads::frame_idx{0}, ads::frame_idx{200004}}), std::out_of_range);
+	REQUIRE_THROWS_AS ((void)ads::get_channel_stats(data, ads::region{ads::frame_idx{-1}, ads::frame_idx{5}}), std::out_of_range);
+}
+
+TEST_CASE("energy index") {
+	auto data = ads::make<float>(ads::channel_count{2}, ads::frame_count{100000});
+	for (int64_t i = 0; i < 100000; i++) {
+		const auto value = static_cast<float>(std::sin(static_cast<double>(i) * 0.003)) * 0.5f + 0.1f;
+		data.set(ads::channel_idx{0}, ads::frame_idx{i}, value);
+		data.set(ads::channel_idx{1}, ads::frame_idx{i}, -value);
+	}
+	auto index = ads::energy_index<>{data};
+	REQUIRE (index.get_channel_count() == ads::channel_count{2});
+	REQUIRE (index.get_frame_count() == ads::frame_count{100000});
+	auto check = [&](ads::channel_idx ch, ads::region region) {
+		const auto expected = ads::get_stats(data, ch, region);
+		REQUIRE (index.get_energy(data, ch, region) == doctest::Approx(expected.sum_of_squares).epsilon(1e-5));
+		REQUIRE (index.get_mean(data, ch, region) == doctest::Approx(expected.mean()).epsilon(1e-5));
+		REQUIRE (index.get_rms(data, ch, region) == doctest::Approx(expected.rms()).epsilon(1e-5));
+	};
+	const std::pair<int64_t, int64_t> regions[] = {{0, 100000}, {0, 256}, {3, 7}, {255, 257}, {300, 700}, {1000, 99999}, {77777, 100000}};
+	for (const auto [beg, end] : regions) {
+		check(ads::channel_idx{0}, {ads::frame_idx{beg}, ads::frame_idx{end}});
+		check(ads::channel_idx{1}, {ads::frame_idx{beg}, ads::frame_idx{end}});
+	}
+	REQUIRE (index.get_rms(data, ads::channel_idx{0}, {ads::frame_idx{5}, ads::frame_idx{5}}) == 0.0);
+	// Rewrite a region and update just that part of the index.
+	const auto rewritten = ads::region{ads::frame_idx{40000}, ads::frame_idx{40500}};
+	data.write(ads::channel_idx{1}, rewritten.beg, rewritten.size(), [](float* buffer, ads::frame_idx, ads::frame_count n) {
+		std::fill_n(buffer, n.value, 0.9f);
+		return n;
+	});
+	index.update(data, rewritten);
+	check(ads::channel_idx{1}, {ads::frame_idx{0}, ads::frame_idx{100000}});
+	check(ads::channel_idx{1}, {ads::frame_idx{39000}, ads::frame_idx{41000}});
+	REQUIRE (index.get_rms(data, ads::channel_idx{1}, rewritten) == doctest::Approx(0.9));
+	check(ads::channel_idx{0}, {ads::frame_idx{1000}, ads::frame_idx{99999}});
+	// The source must match the index.
+	data.resize(ads::frame_count{1000});
+	REQUIRE_THROWS_AS ((void)index.get_energy(data, ads::channel_idx{0}, {ads::frame_idx{0}, ads::frame_idx{10}}), std::invalid_argument);
+	index.rebuild(data);
+	check(ads::channel_idx{0}, {ads::frame_idx{10}, ads::frame_idx{900}});
+	REQUIRE_THROWS_AS ((void)index.get_energy(data, ads::channel_idx{2}, {ads::frame_idx{0}, ads::frame_idx{10}}), std::out_of_range);
+	REQUIRE_THROWS_AS (index.update(data, {ads::frame_idx{0}, ads::frame_idx{1001}}), std::out_of_range);
+}
+
+TEST_CASE("minmax index") {
+	auto data = ads::make<float>(ads::channel_count{2}, ads::frame_count{50000});
+	auto rng  = std::mt19937{7};
+	auto dist = std::uniform_real_distribution<float>{-1.0f, 1.0f};
+	for (int64_t i = 0; i < 50000; i++) {
+		data.set(ads::channel_idx{0}, ads::frame_idx{i}, dist(rng));
+		data.set(ads::channel_idx{1}, ads::frame_idx{i}, 0.5f * dist(rng));
+	}
+	auto expected = [&data](ads::channel_idx ch, int64_t beg, int64_t end) {
+		auto out = ads::minmax<float>{};
+		for (auto i = beg; i < end; i++) {
+			out.merge({data.at(ch, ads::frame_idx{i}), data.at(ch, ads::frame_idx{i})});
+		}
+		return out;
+	};
+	auto index = ads::minmax_index<float, 64>{data};
+	REQUIRE (index.get_frame_count() == ads::frame_count{50000});
+	auto check = [&](ads::channel_idx ch, int64_t beg, int64_t end) {
+		const auto actual = index.get(data, ch, {ads::frame_idx{beg}, ads::frame_idx{end}});
+		const auto exact  = expected(ch, beg, end);
+		REQUIRE (actual.min == exact.min);
+		REQUIRE (actual.max == exact.max);
+	};
+	auto positions = std::uniform_int_distribution<int64_t>{0, 50000};
+	for (int i = 0; i < 200; i++) {
+		const auto a = positions(rng);
+		const auto b = positions(rng);
+		check(ads::channel_idx{static_cast<uint64_t>(i % 2)}, std::min(a, b), std::max(a, b));
+	}
+	check(ads::channel_idx{0}, 0, 50000);
+	check(ads::channel_idx{1}, 64, 128);
+	check(ads::channel_idx{1}, 63, 129);
+	REQUIRE (index.get(data, ads::channel_idx{0}, {ads::frame_idx{9}, ads::frame_idx{9}}).is_empty());
+	REQUIRE (index.get(data, ads::channel_idx{0}, {ads::frame_idx{9}, ads::frame_idx{9}}).peak() == 0.0f);
+	// Dirty regions are rebuilt incrementally.
+	data.set(ads::channel_idx{1}, ads::frame_idx{31234}, 3.0f);
+	data.set(ads::channel_idx{1}, ads::frame_idx{31300}, -4.0f);
+	index.update(data, {ads::frame_idx{31234}, ads::frame_idx{31301}});
+	check(ads::channel_idx{1}, 0, 50000);
+	check(ads::channel_idx{1}, 10000, 31299);
+	check(ads::channel_idx{1}, 31235, 49999);
+	const auto all = index.get(data, {ads::frame_idx{0}, ads::frame_idx{50000}});
+	REQUIRE (all.min == -4.0f);
+	REQUIRE (all.max == 3.0f);
+	REQUIRE (all.peak() == 4.0f);
+	REQUIRE_THROWS_AS ((void)index.get(data, ads::channel_idx{0}, {ads::frame_idx{10}, ads::frame_idx{50001}}), std::out_of_range);
+	data.resize(ads::frame_count{100});
+	REQUIRE_THROWS_AS ((void)index.get(data, ads::channel_idx{0}, {ads::frame_idx{0}, ads::frame_idx{10}}), std::invalid_argument);
+	index.rebuild(data);
+	check(ads::channel_idx{0}, 0, 100);
+}